@@ -0,0 +1,552 @@
+/*
+    backdoors.h
+
+    Polynomial syntactic classes of formulas and backdoors into them. A
+    formula is renameable Horn if flipping the signs of some variables makes
+    it Horn, which is decided in linear time as a 2-SAT problem. A strong
+    backdoor into Horn (or 2-CNF) is a set of variables such that every
+    assignment of them leaves a Horn (2-CNF) formula, and a weak backdoor an
+    assignment leaving a satisfiable one. Backdoors are searched by size,
+    enumerating sets of the variables of the clauses out of the class, with
+    the clauses kept as bitsets over them.
+
+*/
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+#include "formula.h"
+#include "budget.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef BACKDOORS_H
+#define BACKDOORS_H
+
+using namespace std;
+
+enum BackdoorClass { BACKDOOR_HORN, BACKDOOR_2CNF };
+
+// Variables of a weak backdoor, whose assignments are enumerated as bits
+#define WEAK_MAX_SIZE 30
+
+//------------------------------------------------------------------------------
+// Clauses of a formula in memory, as sets of literals sorted by variable.
+// Tautologies are always satisfied and disregarded.
+//------------------------------------------------------------------------------
+struct ClauseSet {
+    long long vars;
+    vector<int> lits;           // Clause i is lits[first[i]..first[i+1]-1]
+    vector<size_t> first;
+
+    ClauseSet() : vars(0), first(1, 0) {}
+
+    size_t size() const { return first.size() - 1; }
+
+    // Returns false if the formula cannot be read
+    bool read(const FormulaSource &src) {
+        FormulaReader reader(src);
+        long long header;
+        if (!reader.open() || !reader.header(vars, header))
+            return false;
+        auto by_var = [](int a, int b) { return abs(a) < abs(b) || (abs(a) == abs(b) && a < b); };
+        vector<int> clause;
+        int x;
+        while (reader.next(x)) {
+            if (x != 0) {
+                clause.push_back(x);
+                if (abs(x) > vars)
+                    vars = abs(x);
+                continue;
+            }
+            sort(clause.begin(), clause.end(), by_var);
+            clause.erase(unique(clause.begin(), clause.end()), clause.end());
+            bool taut = false;
+            for (size_t i=1; i<clause.size(); i++)
+                taut = taut || clause[i] == -clause[i-1];
+            if (!taut) {
+                lits.insert(lits.end(), clause.begin(), clause.end());
+                first.push_back(lits.size());
+            }
+            clause.clear();
+        }
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+// 2-SAT problem over variables 1..n, solved by the strongly connected
+// components of its implication graph, in linear time
+//------------------------------------------------------------------------------
+class TwoSat {
+
+    long long n;
+    vector<pair<int,int> > clauses;
+
+    // Node of a literal, its negation is node ^ 1
+    static size_t node(int l) { return l > 0 ? 2 * (size_t)(l-1) : 2 * (size_t)(-l-1) + 1; }
+
+    public:
+
+        TwoSat(long long vars) : n(vars) {}
+
+        // Adds the clause a | b (a single literal if a == b)
+        void add(int a, int b) { clauses.push_back(make_pair(a, b)); }
+
+        //----------------------------------------------------------------------
+        // Returns true if satisfiable, with a model in "model" (the value of
+        // variable x in model[x-1])
+        //----------------------------------------------------------------------
+        bool solve(vector<char> &model) {
+
+            size_t nodes = 2 * n;
+            // Implications -a -> b and -b -> a, in compressed rows
+            vector<size_t> off(nodes + 1, 0);
+            for (size_t i=0; i<clauses.size(); i++) {
+                off[(node(clauses[i].first) ^ 1) + 1]++;
+                off[(node(clauses[i].second) ^ 1) + 1]++;
+            }
+            for (size_t v=0; v<nodes; v++)
+                off[v+1] += off[v];
+            vector<size_t> adj(off[nodes]), next(off.begin(), off.end() - 1);
+            for (size_t i=0; i<clauses.size(); i++) {
+                size_t a = node(clauses[i].first), b = node(clauses[i].second);
+                adj[next[a ^ 1]++] = b;
+                adj[next[b ^ 1]++] = a;
+            }
+
+            // Tarjan, without recursion. Components are numbered in reverse
+            // topological order, so a literal is true if its component
+            // comes before the one of its negation.
+            vector<long long> index(nodes, -1), low(nodes), comp(nodes, -1);
+            vector<size_t> stack;
+            vector<pair<size_t,size_t> > call;      // Node and next edge
+            long long counter = 0, ncomp = 0;
+            for (size_t s=0; s<nodes; s++) {
+                if (index[s] >= 0)
+                    continue;
+                index[s] = low[s] = counter++;
+                stack.push_back(s);
+                call.push_back(make_pair(s, off[s]));
+                while (!call.empty()) {
+                    size_t v = call.back().first;
+                    size_t &e = call.back().second;
+                    if (e < off[v+1]) {
+                        size_t w = adj[e++];
+                        if (index[w] < 0) {
+                            index[w] = low[w] = counter++;
+                            stack.push_back(w);
+                            call.push_back(make_pair(w, off[w]));
+                        } else if (comp[w] < 0 && index[w] < low[v]) {
+                            low[v] = index[w];
+                        }
+                        continue;
+                    }
+                    call.pop_back();
+                    if (!call.empty() && low[v] < low[call.back().first])
+                        low[call.back().first] = low[v];
+                    if (low[v] == index[v]) {
+                        size_t w;
+                        do {
+                            w = stack.back();
+                            stack.pop_back();
+                            comp[w] = ncomp;
+                        } while (w != v);
+                        ncomp++;
+                    }
+                }
+            }
+
+            model.assign(n, 0);
+            for (long long x=0; x<n; x++) {
+                if (comp[2*x] == comp[2*x+1])
+                    return false;
+                model[x] = comp[2*x] < comp[2*x+1];
+            }
+            return true;
+        }
+};
+
+//------------------------------------------------------------------------------
+// Returns true if the formula is renameable Horn, with the variables to
+// rename in "renamed". With a variable f(x) true if x is renamed, a literal
+// l becomes positive if -l holds, and "at most a positive literal" in a
+// clause l1..lk is encoded in 2-SAT with the sequential encoding: p(li) ->
+// s(i), s(i) -> s(i+1) and s(i) -> -p(li+1), on k-1 new variables s(i).
+//------------------------------------------------------------------------------
+bool renameable_horn(const ClauseSet &f, vector<int> &renamed) {
+
+    long long n = f.vars;
+    for (size_t c=0; c<f.size(); c++)
+        if (f.first[c+1] - f.first[c] > 1)
+            n += f.first[c+1] - f.first[c] - 1;
+
+    TwoSat sat(n);
+    long long s = f.vars;       // Last variable used
+    for (size_t c=0; c<f.size(); c++) {
+        size_t k = f.first[c+1] - f.first[c];
+        const int* l = f.lits.data() + f.first[c];
+        for (size_t i=0; i+1<k; i++) {
+            int si = (int)(s + i + 1);
+            sat.add(l[i], si);
+            sat.add(-si, l[i+1]);
+            if (i+2 < k)
+                sat.add(-si, si + 1);
+        }
+        if (k > 1)
+            s += k - 1;
+    }
+
+    vector<char> model;
+    if (!sat.solve(model))
+        return false;
+    renamed.clear();
+    for (long long x=0; x<f.vars; x++)
+        if (model[x])
+            renamed.push_back(x + 1);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Satisfiability of a Horn formula, by the propagation of the variables that
+// must be true (Dowling and Gallier), in linear time
+//------------------------------------------------------------------------------
+bool horn_sat(const vector<int> &lits, const vector<size_t> &first, long long vars) {
+
+    size_t m = first.size() - 1;
+    vector<size_t> off(vars + 1, 0);
+    vector<int> missing(m, 0), head(m, 0);
+    for (size_t c=0; c<m; c++)
+        for (size_t i=first[c]; i<first[c+1]; i++) {
+            if (lits[i] < 0) {
+                off[-lits[i]]++;
+                missing[c]++;
+            } else {
+                head[c] = lits[i];
+            }
+        }
+    for (long long x=0; x<vars; x++)
+        off[x+1] += off[x];
+    vector<size_t> body(off[vars]), next(off.begin(), off.end() - 1);
+    for (size_t c=0; c<m; c++)
+        for (size_t i=first[c]; i<first[c+1]; i++)
+            if (lits[i] < 0)
+                body[next[-lits[i]-1]++] = c;
+
+    vector<char> value(vars, 0);
+    vector<int> queue;
+    // Clauses whose body holds set their head, or are falsified
+    auto fire = [&](size_t c) {
+        if (head[c] == 0)
+            return false;
+        if (!value[head[c]-1]) {
+            value[head[c]-1] = 1;
+            queue.push_back(head[c]);
+        }
+        return true;
+    };
+    for (size_t c=0; c<m; c++)
+        if (missing[c] == 0 && !fire(c))
+            return false;
+    for (size_t q=0; q<queue.size(); q++) {
+        int x = queue[q];
+        for (size_t i=off[x-1]; i<off[x]; i++)
+            if (--missing[body[i]] == 0 && !fire(body[i]))
+                return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Backdoor found: the variables of a strong backdoor, or the literals of the
+// assignment of a weak one
+//------------------------------------------------------------------------------
+struct Backdoor {
+    bool found;
+    vector<int> lits;
+};
+
+//------------------------------------------------------------------------------
+// Search of the smallest backdoor of a formula. Clauses out of the class are
+// obstructions, kept as bitsets over the candidate variables (those in some
+// obstruction, the most frequent first), with the number of them a backdoor
+// must contain: for strong backdoors, all their positive variables (Horn)
+// or variables (2-CNF) but one (two); for weak backdoors, one variable, to
+// satisfy or to shorten the clause. Variables in no obstruction are never
+// needed: their clauses stay in the class under any assignment.
+//------------------------------------------------------------------------------
+class BackdoorSearch {
+
+    const ClauseSet &f;
+    int cls;                    // BackdoorClass
+    bool weak;
+    vector<int> cand;           // Variable of every candidate
+    size_t words;               // Of every bitset
+    vector<uint64_t> sets;      // Candidates of obstruction o are sets[o*words..(o+1)*words-1]
+    vector<int> need;           // Candidates of obstruction o a backdoor must contain
+    Budget* budget;
+    atomic<long long> best;     // First candidate of the backdoor found, or cand.size()
+    atomic<bool> stop;
+    Backdoor result;
+
+    // Variables of clause c out of the class, or an empty list
+    vector<int> obstruction(size_t c) {
+        vector<int> vars;
+        size_t k = f.first[c+1] - f.first[c];
+        const int* l = f.lits.data() + f.first[c];
+        if (cls == BACKDOOR_2CNF) {
+            if (k > 2)
+                for (size_t i=0; i<k; i++)
+                    vars.push_back(abs(l[i]));
+            return vars;
+        }
+        for (size_t i=0; i<k; i++)
+            if (l[i] > 0 || weak)
+                vars.push_back(abs(l[i]));
+        size_t positive = 0;
+        for (size_t i=0; i<k; i++)
+            positive += l[i] > 0;
+        if (positive < 2)
+            vars.clear();
+        return vars;
+    }
+
+    // Per thread state of the enumeration
+    struct State {
+        vector<uint64_t> chosen;        // Bitset of the candidates chosen
+        vector<int> set;                // And their list, in increasing order
+        long long visits;
+        vector<signed char> value;      // Assignment of the variables, -1 if none
+        vector<int> lits;               // Reduced formula
+        vector<size_t> first;
+    };
+
+    //--------------------------------------------------------------------------
+    // Returns 0 if the chosen candidates contain the ones every obstruction
+    // needs, -1 if some obstruction cannot get them anymore from the
+    // candidates after "last" or within "left" more, and 1 otherwise
+    //--------------------------------------------------------------------------
+    int check(State &s, size_t last, int left) {
+        size_t start = last + 1;
+        int ans = 0;
+        for (size_t o=0; o<need.size(); o++) {
+            const uint64_t* b = sets.data() + o * words;
+            int have = 0, avail = 0;
+            for (size_t w=0; w<words; w++) {
+                uint64_t above = w > start/64 ? ~0ULL : w == start/64 ? ~0ULL << (start % 64) : 0;
+                have += __builtin_popcountll(b[w] & s.chosen[w]);
+                avail += __builtin_popcountll(b[w] & above);
+            }
+            int miss = need[o] - have;
+            if (miss <= 0)
+                continue;
+            if (miss > avail || (!weak && miss > left))
+                return -1;
+            ans = 1;
+        }
+        return ans;
+    }
+
+    //--------------------------------------------------------------------------
+    // Returns true if assigning the chosen variables by the bits of "tau"
+    // leaves a satisfiable formula of the class
+    //--------------------------------------------------------------------------
+    bool weak_check(State &s, uint64_t tau) {
+        for (size_t i=0; i<s.set.size(); i++)
+            s.value[cand[s.set[i]]-1] = (tau >> i) & 1;
+        s.lits.clear();
+        s.first.assign(1, 0);
+        bool ok = true;
+        for (size_t c=0; c<f.size() && ok; c++) {
+            size_t start = s.lits.size();
+            bool sat = false;
+            int positive = 0;
+            for (size_t i=f.first[c]; i<f.first[c+1] && !sat; i++) {
+                int l = f.lits[i];
+                signed char v = s.value[abs(l)-1];
+                if (v < 0) {
+                    s.lits.push_back(l);
+                    positive += l > 0;
+                } else {
+                    sat = (v == 1) == (l > 0);
+                }
+            }
+            if (sat) {
+                s.lits.resize(start);
+                continue;
+            }
+            size_t k = s.lits.size() - start;
+            ok = k > 0 && (cls == BACKDOOR_HORN ? positive <= 1 : k <= 2);
+            s.first.push_back(s.lits.size());
+        }
+        if (ok && cls == BACKDOOR_HORN) {
+            ok = horn_sat(s.lits, s.first, f.vars);
+        } else if (ok) {
+            TwoSat sat(f.vars);
+            for (size_t c=0; c+1<s.first.size(); c++)
+                sat.add(s.lits[s.first[c]], s.lits[s.first[c+1]-1]);
+            vector<char> model;
+            ok = sat.solve(model);
+        }
+        for (size_t i=0; i<s.set.size(); i++)
+            s.value[cand[s.set[i]]-1] = -1;
+        return ok;
+    }
+
+    // Records the backdoor of the chosen candidates, if the first one is the smallest
+    void found(State &s, uint64_t tau) {
+        #pragma omp critical(backdoor)
+        {
+            if (s.set[0] < best) {
+                best = s.set[0];
+                result.found = true;
+                result.lits.clear();
+                for (size_t i=0; i<s.set.size(); i++) {
+                    int x = cand[s.set[i]];
+                    result.lits.push_back(weak && !((tau >> i) & 1) ? -x : x);
+                }
+                sort(result.lits.begin(), result.lits.end(),
+                     [](int a, int b) { return abs(a) < abs(b); });
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Chooses "left" more candidates after candidate "last", in increasing
+    // order. Returns true if a backdoor is found.
+    //--------------------------------------------------------------------------
+    bool extend(State &s, size_t last, int left) {
+        if (stop || s.set[0] > best)
+            return false;
+        if (budget != NULL && ++s.visits % BUDGET_POLL == 0 && budget->expired()) {
+            stop = true;
+            return false;
+        }
+        int state = check(s, last, left);
+        if (state < 0)
+            return false;
+        if (left == 0) {
+            if (state > 0)
+                return false;
+            if (!weak) {
+                found(s, 0);
+                return true;
+            }
+            for (uint64_t tau=0; tau < (1ULL << s.set.size()); tau++) {
+                if (weak_check(s, tau)) {
+                    found(s, tau);
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (state == 0 && !weak) {
+            found(s, 0);
+            return true;
+        }
+        for (size_t c=last+1; c + left <= cand.size(); c++) {
+            s.chosen[c/64] |= 1ULL << (c % 64);
+            s.set.push_back(c);
+            bool ok = extend(s, c, left - 1);
+            s.set.pop_back();
+            s.chosen[c/64] &= ~(1ULL << (c % 64));
+            if (ok)
+                return true;
+        }
+        return false;
+    }
+
+    // Searches backdoors of exactly "size" candidates, in parallel by the first one
+    bool search(int size) {
+        best = cand.size();
+        long long n = cand.size();
+        #pragma omp parallel
+        {
+            State s;
+            s.chosen.assign(words, 0);
+            s.visits = 0;
+            s.value.assign(f.vars, -1);
+            #pragma omp for schedule(dynamic,1)
+            for (long long c=0; c<=n-size; c++) {
+                if (stop || c > best)
+                    continue;
+                s.chosen[c/64] |= 1ULL << (c % 64);
+                s.set.assign(1, c);
+                extend(s, c, size - 1);
+                s.chosen[c/64] &= ~(1ULL << (c % 64));
+            }
+        }
+        return result.found;
+    }
+
+    public:
+
+        BackdoorSearch(const ClauseSet &formula, int klass, bool w, Budget* b = NULL) :
+            f(formula), cls(klass), weak(w), budget(b), stop(false) {
+
+            // Candidates by decreasing obstructions, so that pruning comes early
+            vector<vector<int> > obs;
+            vector<long long> count(f.vars + 1, 0);
+            for (size_t c=0; c<f.size(); c++) {
+                vector<int> vars = obstruction(c);
+                if (vars.empty())
+                    continue;
+                for (size_t i=0; i<vars.size(); i++)
+                    count[vars[i]]++;
+                obs.push_back(vars);
+            }
+            for (long long x=1; x<=f.vars; x++)
+                if (count[x] > 0)
+                    cand.push_back(x);
+            stable_sort(cand.begin(), cand.end(), [&count](int a, int b) { return count[a] > count[b]; });
+            vector<int> id(f.vars + 1, -1);
+            for (size_t i=0; i<cand.size(); i++)
+                id[cand[i]] = i;
+
+            words = (cand.size() + 63) / 64;
+            sets.assign(obs.size() * words, 0);
+            for (size_t o=0; o<obs.size(); o++) {
+                for (size_t i=0; i<obs[o].size(); i++) {
+                    int c = id[obs[o][i]];
+                    sets[o * words + c/64] |= 1ULL << (c % 64);
+                }
+                int free = weak ? (int)obs[o].size() - 1 : (cls == BACKDOOR_HORN ? 1 : 2);
+                need.push_back(obs[o].size() - free);
+            }
+            result.found = false;
+        }
+
+        size_t candidates() { return cand.size(); }
+
+        //----------------------------------------------------------------------
+        // Returns the smallest backdoor of at most "maxsize" variables (any
+        // number if negative, at most WEAK_MAX_SIZE for weak ones), the first
+        // one by the order of the candidates. If the budget expires first, a
+        // backdoor of the size being searched may still be found.
+        //----------------------------------------------------------------------
+        Backdoor smallest(int maxsize) {
+            long long limit = cand.size();
+            if (maxsize >= 0 && maxsize < limit)
+                limit = maxsize;
+            if (weak && limit > WEAK_MAX_SIZE)
+                limit = WEAK_MAX_SIZE;
+
+            // The empty set, when the formula is already in the class
+            if (need.empty()) {
+                State s;
+                s.value.assign(f.vars, -1);
+                if (!weak || weak_check(s, 0)) {
+                    result.found = true;
+                    return result;
+                }
+            }
+            for (int size=1; size<=limit && !stop; size++)
+                if (search(size))
+                    break;
+            return result;
+        }
+};
+
+#endif
@@ -0,0 +1,218 @@
+/*
+    basefeatures.h
+
+    Syntactic (SATzilla-like) base features of a formula: its size, the
+    statistics of the sizes of the clauses and of the occurrences of the
+    variables, the balance of positive and negative literals, and the
+    fractions of unit, binary, ternary, Horn and dual Horn clauses. They are
+    counted literal by literal, so that the readers of the graphs count them
+    in the same pass, together with the distributions of the scale-free
+    features (see arityVar and arityClause).
+
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include "formula.h"
+
+#ifndef BASEFEATURES_H
+#define BASEFEATURES_H
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Base features of a formula. The balance of a clause or a variable is
+// 2|1/2 - p/n|, p being its positive literals out of n: 0 if balanced and
+// 1 if all of them have the same sign. The statistics of the variables are
+// over variables 1 to the greatest one, occurring or not, and the balances
+// over the non-empty clauses and the occurring variables.
+//------------------------------------------------------------------------------
+struct BaseFeatures {
+    long long vars, clauses;
+    double ratio;                                   // Clauses per variable
+    double size_mean, size_std;                     // Literals of the clauses
+    long long size_min, size_max;
+    double unit, binary, ternary;                   // Fractions of clauses of 1, 2 and 3 literals
+    double horn, dual_horn;                         // Fractions of clauses with at most a positive
+                                                    // (negative) literal
+    double positive;                                // Fraction of positive literals
+    double balance_clause_mean, balance_clause_std;
+    double balance_var_mean, balance_var_std;
+    double degree_mean, degree_std;                 // Occurrences of the variables
+    long long degree_min, degree_max;
+    double horny_mean, horny_std;                   // Horn clauses of every variable
+
+    // Features not computed
+    void clear() {
+        vars = clauses = size_min = size_max = degree_min = degree_max = -1;
+        ratio = size_mean = size_std = unit = binary = ternary = horn = dual_horn = -1;
+        positive = balance_clause_mean = balance_clause_std = -1;
+        balance_var_mean = balance_var_std = -1;
+        degree_mean = degree_std = horny_mean = horny_std = -1;
+    }
+};
+
+// Mean and standard deviation of n values adding s, and s2 their squares
+void mean_std(double s, double s2, double n, double &mean, double &std) {
+    mean = n > 0 ? s / n : 0;
+    std = n > 0 ? sqrt(max(0.0, s2 / n - mean * mean)) : 0;
+}
+
+//------------------------------------------------------------------------------
+// Counts of a formula read literal by literal, every clause ended by a 0
+//------------------------------------------------------------------------------
+class BaseCounter {
+
+    vector<long long> pos, neg;     // Occurrences of every variable with each sign
+    vector<long long> horny;        // Horn clauses of every variable
+    vector<long long> sizes;        // Clauses of every size
+    vector<int> clause;             // Variables of the current clause, from 0
+    long long npos;                 // Positive literals of the current clause
+    long long lits, plits;          // Literals, positive literals
+    long long nhorn, ndual;
+    double balance, balance2;       // Sums of the balances of the clauses and their squares
+
+    public:
+
+        BaseCounter() : npos(0), lits(0), plits(0), nhorn(0), ndual(0), balance(0), balance2(0) {}
+
+        // Variables 1 to n, even if not occurring
+        void resize(long long n) {
+            if (n > (long long)pos.size()) {
+                pos.resize(n, 0);
+                neg.resize(n, 0);
+                horny.resize(n, 0);
+            }
+        }
+
+        // Counts a literal, or ends a clause if 0
+        void next(int lit) {
+            if (lit != 0) {
+                int v = abs(lit);
+                resize(v);
+                if (lit > 0) {
+                    pos[v-1]++;
+                    npos++;
+                } else {
+                    neg[v-1]++;
+                }
+                clause.push_back(v-1);
+                return;
+            }
+            size_t k = clause.size();
+            if (k >= sizes.size())
+                sizes.resize(k+1, 0);
+            sizes[k]++;
+            lits += k;
+            plits += npos;
+            if (npos <= 1) {
+                nhorn++;
+                for (size_t i=0; i<k; i++)
+                    horny[clause[i]]++;
+            }
+            if ((long long)k - npos <= 1)
+                ndual++;
+            if (k > 0) {
+                double b = 2 * fabs(0.5 - (double)npos / k);
+                balance += b;
+                balance2 += b * b;
+            }
+            clause.clear();
+            npos = 0;
+        }
+
+        //----------------------------------------------------------------------
+        // Counts a formula in a pass, from the variables of its header.
+        // Throws a FormulaError if it cannot be read.
+        //----------------------------------------------------------------------
+        void read(const FormulaSource &src) {
+            FormulaReader reader(src);
+            long long vars, header;
+            if (!reader.open())
+                throw FormulaError("Unable to read CNF file " + src.name(), true);
+            if (!reader.header(vars, header))
+                throw FormulaError("Invalid CNF file " + src.name());
+            resize(vars);
+            int x;
+            while (reader.next(x))
+                next(x);
+        }
+
+        // Pairs (occurrences, variables with them), by increasing occurrences
+        vector<pair<long long,long long> > arity_var() const {
+            vector<long long> occurs(pos.size());
+            for (size_t v=0; v<pos.size(); v++)
+                occurs[v] = pos[v] + neg[v];
+            sort(occurs.begin(), occurs.end());
+            vector<pair<long long,long long> > a;
+            for (size_t i=0; i<occurs.size(); i++) {
+                if (a.empty() || a.back().first != occurs[i])
+                    a.push_back(make_pair(occurs[i], 0LL));
+                a.back().second++;
+            }
+            return a;
+        }
+
+        // Pairs (size, clauses of that size) of the non-empty clauses, by size
+        vector<pair<long long,long long> > arity_clause() const {
+            vector<pair<long long,long long> > a;
+            for (size_t k=1; k<sizes.size(); k++)
+                if (sizes[k] > 0)
+                    a.push_back(make_pair((long long)k, sizes[k]));
+            return a;
+        }
+
+        BaseFeatures features() const {
+            BaseFeatures f;
+            f.vars = pos.size();
+            f.clauses = 0;
+            double s = 0, s2 = 0;
+            f.size_min = f.size_max = 0;
+            for (size_t k=0; k<sizes.size(); k++) {
+                if (sizes[k] == 0)
+                    continue;
+                if (f.clauses == 0)
+                    f.size_min = k;
+                f.size_max = k;
+                f.clauses += sizes[k];
+                s += (double)k * sizes[k];
+                s2 += (double)k * k * sizes[k];
+            }
+            double c = f.clauses;
+            f.ratio = f.vars > 0 ? c / f.vars : 0;
+            mean_std(s, s2, c, f.size_mean, f.size_std);
+            f.unit = c > 0 && sizes.size() > 1 ? sizes[1] / c : 0;
+            f.binary = c > 0 && sizes.size() > 2 ? sizes[2] / c : 0;
+            f.ternary = c > 0 && sizes.size() > 3 ? sizes[3] / c : 0;
+            f.horn = c > 0 ? nhorn / c : 0;
+            f.dual_horn = c > 0 ? ndual / c : 0;
+            f.positive = lits > 0 ? (double)plits / lits : 0;
+            mean_std(balance, balance2, c - (sizes.empty() ? 0 : sizes[0]),
+                     f.balance_clause_mean, f.balance_clause_std);
+
+            double d = 0, d2 = 0, h = 0, h2 = 0, b = 0, b2 = 0, active = 0;
+            f.degree_min = f.degree_max = 0;
+            for (size_t v=0; v<pos.size(); v++) {
+                long long n = pos[v] + neg[v];
+                if (v == 0 || n < f.degree_min) f.degree_min = n;
+                if (n > f.degree_max) f.degree_max = n;
+                d += n;
+                d2 += (double)n * n;
+                h += horny[v];
+                h2 += (double)horny[v] * horny[v];
+                if (n > 0) {
+                    double x = 2 * fabs(0.5 - (double)pos[v] / n);
+                    b += x;
+                    b2 += x * x;
+                    active++;
+                }
+            }
+            mean_std(d, d2, f.vars, f.degree_mean, f.degree_std);
+            mean_std(h, h2, f.vars, f.horny_mean, f.horny_std);
+            mean_std(b, b2, active, f.balance_var_mean, f.balance_var_std);
+            return f;
+        }
+};
+
+#endif
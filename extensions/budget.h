@@ -0,0 +1,72 @@
+/*
+    budget.h
+
+    Time budget and cancellation of the feature kernels. Kernels poll a
+    Budget cooperatively (in the sweeps of the local moving, between GFA
+    levels and between the diameters of the box covering) and, when it is
+    exhausted, stop and keep the best result found so far, marking the
+    Budget as truncated.
+
+*/
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+using namespace std;
+
+// Kernels poll the Budget once every this number of node visits
+#define BUDGET_POLL 1024
+
+//------------------------------------------------------------------------------
+// Deadline and cancellation token shared by the kernels of a computation,
+// that may run in several threads. Optionally, a function "poll" is called
+// from the thread that attached it, e.g. for checking signals.
+//------------------------------------------------------------------------------
+struct Budget {
+    chrono::steady_clock::time_point deadline;
+    bool timed;                     // Has a deadline
+    atomic<bool> cancelled;         // Set by cancel(), from any thread
+    atomic<bool> truncated;         // Some kernel stopped by the budget
+    atomic<bool> interrupted;       // Stopped by poll
+    bool (*poll)();                 // Returns true to stop, or NULL
+    thread::id owner;               // Thread calling poll
+
+    // A budget of "seconds" from now, or without deadline if negative
+    Budget(double seconds = -1) : timed(seconds >= 0), cancelled(false), truncated(false),
+                                  interrupted(false), poll(NULL) {
+        deadline = chrono::steady_clock::now() +
+            chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds > 0 ? seconds : 0));
+    }
+
+    void cancel() { cancelled = true; }
+
+    // Sets the function polled from the calling thread, clearing interruptions
+    void attach(bool (*f)()) {
+        poll = f;
+        owner = this_thread::get_id();
+        interrupted = false;
+    }
+
+    //--------------------------------------------------------------------------
+    // Returns true if the kernels must stop. A deadline or a cancellation
+    // truncates the results; an interruption by "poll" discards them.
+    //--------------------------------------------------------------------------
+    bool expired() {
+        if (interrupted)
+            return true;
+        if (cancelled || (timed && chrono::steady_clock::now() >= deadline)) {
+            truncated = true;
+            return true;
+        }
+        if (poll != NULL && this_thread::get_id() == owner && poll()) {
+            interrupted = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
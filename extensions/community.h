@@ -27,29 +27,58 @@ Contact: jgiraldez@iiia.csic.es
 */
 #include <vector>
 #include <stack>
-#ifndef VECTOR
-#include "graph_set.h"
-#else
-#include "graph_vector.h"
-#endif
+#include <math.h>
+#include <stdint.h>
+#include "graph.h"
 #include <algorithm>
+#include <unordered_map>
 #include <stdio.h> 
+#include "cpu.h"
+#include "budget.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #ifndef COMMUNITY_H
 #define COMMUNITY_H
 
+// Over this number of communities, community2graph() accumulates the weights
+// of each community with a hash map instead of a dense vector per thread
+#define DENSE_AGGREGATION 4000000
+
+// Community detection methods (see Community::compute_modularity)
+enum CommunityMethod { METHOD_LOUVAIN, METHOD_LEIDEN, METHOD_LOUVAIN_QUEUE };
+
 extern bool verbose;
 
 using namespace std;
 
 //------------------------------------------------------------------------------
-// Randomly re-order elements of a vector
+// Pseudo-random generator (splitmix64) owned by a single run, so that runs in
+// different threads are independent and reproducible, unlike rand()
+//------------------------------------------------------------------------------
+struct Random {
+    uint64_t state;
+
+    Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+//------------------------------------------------------------------------------
+// Randomly re-order elements of a vector, with "rng" or, if NULL, rand()
 //------------------------------------------------------------------------------
-void shuffle(vector <int> &x) {
+template <class T>
+void shuffle(vector <T> &x, Random* rng = NULL) {
 
-    for (int i=0 ; i<x.size()-1 ; i++) {
-        int j = rand()%(x.size()-i)+i;
-        int aux = x[i];
+    for (size_t i=0 ; i+1<x.size() ; i++) {
+        size_t j = (rng ? rng->next() : rand())%(x.size()-i)+i;
+        T aux = x[i];
         x[i] = x[j];
         x[j] = aux;
     }
@@ -60,55 +89,143 @@ double abs2(double x){
     return x;
 }
 //------------------------------------------------------------------------------
-bool my_bigger_communities(pair <int,double> x, pair <int,double> y) {
+template <class T>
+bool my_bigger_communities(pair <T,size_t> x, pair <T,size_t> y) {
     return x.second > y.second;
 }
 //------------------------------------------------------------------------------
+// Given the weights wc[0..k-1] from a node of arity "a" to its neighbor 
+// communities, and their arities arity[0..k-1], returns the index of the one
+// with the greatest (positive) modularity gain wc[i] - a * arity[i] / total, 
+// or -1 if none has it.
+//------------------------------------------------------------------------------
+MULTIVERSION
+int best_community(const double* wc, const double* arity, int k,
+                   double a, double total) {
+
+    int best = -1;
+    double best_inc = 0;
+
+    for (int i=0; i < k; i++) {
+        double inc = wc[i] - a * arity[i] / total;
+        if (inc > best_inc) {
+            best_inc = inc;
+            best = i;
+        }
+    }
+    return best;
+}
+//------------------------------------------------------------------------------
+// Builds in "start" an initial partition for a graph of n nodes from the 
+// partition "prev" of a previous graph, in which node i was node map[i] (or
+// did not exist, if map[i] < 0). With an empty "map", nodes keep their ids.
+// Communities are renumbered in [0..n-1], and new nodes get singletons.
+// Returns false if some id or community is out of range.
+//------------------------------------------------------------------------------
+template <class node>
+bool start_partition(size_t n, const vector<long long> &prev, 
+                     const vector<long long> &map, vector<node> &start) {
+
+    if (!map.empty() && map.size() != n)
+        return false;
+
+    unordered_map <long long,node> ren;
+    vector <bool> fresh(n, false);
+    start.assign(n, 0);
+    for (size_t i=0; i<n; i++) {
+        long long old = map.empty() ? (long long)i : map[i];
+        if (old < 0 || old >= (long long)prev.size()) {
+            if (!map.empty() && old >= (long long)prev.size())
+                return false;
+            fresh[i] = true;
+            continue;
+        }
+        if (prev[old] < 0)
+            return false;
+        typename unordered_map<long long,node>::iterator it = ren.find(prev[old]);
+        if (it == ren.end())
+            it = ren.insert(make_pair(prev[old], (node)ren.size())).first;
+        start[i] = it->second;
+    }
+    node next = ren.size();
+    for (size_t i=0; i<n; i++)
+        if (fresh[i])
+            start[i] = next++;
+    return true;
+}
+//------------------------------------------------------------------------------
+// Communities of a graph of type G (any GraphT instantiation)
+//------------------------------------------------------------------------------
+template <class G = Graph>
 class Community {
     
+    typedef typename G::node_t node;
+    typedef typename G::weight_t weight;
+
     // arity[i] = Sum of the arities of nodes belonging to community "i"
     vector <double> arity; 
 
     public:
 
-        Graph* g;
+        G* g;
+        // Generator of the node orders, rand() if NULL
+        Random* rng;
+        // one_level() re-evaluates only the neighbors of moved nodes
+        bool queue;
+        // Stops the local moving when exhausted, none if NULL
+        Budget* budget;
         // Assigns every node a community (community id in [0..n-1])
-        vector<int> n2c;      
-        vector<vector<int> > Comm;
-        vector<pair<int,int> > Comm_order;
+        vector<node> n2c;      
+        vector<vector<node> > Comm;
+        vector<pair<node,size_t> > Comm_order;
+        // levels[l][i] = community of node i after level l of the GFA method
+        vector<vector<node> > levels;
 
-        Community(Graph* g2) {
+        Community(G* g2) {
 
+            rng = NULL;
+            queue = false;
+            budget = NULL;
             if(g2 != NULL){
                 g = g2;
                 iterations = 0;
+                visits = 0;
+                ncomm = g->size();
 
                 arity.resize(g->size());
                 n2c.resize(g->size());
 
                 // Every node to one singleton community
-                for (int i=0; i<g->size(); i++)
+                for (node i=0; i<g->size(); i++)
                       n2c[i] = i;       
 
                 // Arity of the (singleton) community equals to arity of node
-                for (int i=0; i<g->size(); i++)
+                for (node i=0; i<g->size(); i++)
                     arity[i] = g->arity(i); 
             }
         }
           
-        Community(Graph* g2, vector<int> &n2cb){
+        Community(G* g2, vector<node> &n2cb){
             g = g2;
+            rng = NULL;
+            queue = false;
+            budget = NULL;
             iterations = 0;
+            visits = 0;
               
             arity.resize(g->size());
             n2c = n2cb;
               
-            for(int i=0; i<g->size(); i++)
+            for(node i=0; i<g->size(); i++)
                 arity[n2c[i]] += g->arity(i);
           }
 
-        int ncomm;
+        node ncomm;
         int iterations;
+        long long visits;           // Nodes evaluated for a move
+        // sweeps[k] = (nodes evaluated, nodes moved) in the k-th sweep of 
+        // the local moving, over all levels
+        vector<pair<long long,long long> > sweeps;
 
 
         //----------------------------------------------------------------------
@@ -120,18 +237,21 @@ class Community {
             double arity = 0;
             vector <double> aritym(g->size(), 0);
 
+            if (g->arity() == 0)    // No edges
+                return 0;
+
             
-            for (Graph::EdgeIter it=g->begin(); it != g->end(); it++) {
+            for (typename G::EdgeIter it=g->begin(); it != g->end(); it++) {
                 //assert(it->orig >= 0 && it->orig < n2c.size());
                 //assert(it->dest >= 0 && it->dest < n2c.size());
                 if (n2c[it->orig] == n2c[it->dest]) 
                     w += it->weight; 
             }
 
-            for (int i=0; i<g->size(); i++)
+            for (node i=0; i<g->size(); i++)
                 aritym[n2c[i]] += g->arity(i);  
 
-            for (int i=0; i<g->size(); i++)
+            for (node i=0; i<g->size(); i++)
                 arity += aritym[i] * aritym[i] / g->arity() / g->arity();
 
 
@@ -142,36 +262,46 @@ class Community {
         //----------------------------------------------------------------------
         // Given a graf "g" and a partition "n2c", improves the partition by 
         // moving nodes from one partition to another. 
-        // Modifies "arity" and "n2c". 
+        // Modifies "arity" and "n2c". Stops, in the middle of a sweep, when
+        // the budget is exhausted.
         // Returns "true" if partition changed.
         //----------------------------------------------------------------------
         bool one_level() {
 
-            bool improved = false, changed;
-            vector<int> random_order(g->size());
+            if (queue)
+                return move_queue();
+
+            bool improved = false;
+            long long moved;
+            node naux;
+            vector<node> random_order(g->size());
 
-            for (int i=0 ; i<random_order.size(); i++)
+            for (size_t i=0 ; i<random_order.size(); i++)
                 random_order[i]=i;
 
             // wc[c] = sum_{j\in c} w(n,j) for c not conected wc[c]=-1
             vector <double> wc(g->size(), -1);
-            // neigh communities
-            vector <int> nc;                  
+            // neigh communities, with their weights and arities gathered
+            vector <node> nc;                  
+            vector <double> nw, na;
             do {
                 iterations++;
-                shuffle(random_order);
-                changed = false;
-                for (int naux=0; naux<g->size(); naux++) {
-                    int n = random_order[naux];
+                shuffle(random_order, rng);
+                moved = 0;
+                for (naux=0; naux<g->size(); naux++) {
+                    if (stop())
+                        break;
+                    node n = random_order[naux];
+                    visits++;
 
                     arity[n2c[n]] -= g->arity(n);
 
-                    for (int i=0; i < nc.size(); i++)
+                    for (size_t i=0; i < nc.size(); i++)
                         wc[nc[i]] = -1;
                     nc.clear();
                     nc.resize(0);
-                    for (Graph::NeighIter it=g->begin(n); it != g->end(n); ++it) {
-                        int c = n2c[it->dest];
+                    for (typename G::NeighIter it=g->begin(n); it != g->end(n); ++it) {
+                        node c = n2c[it->dest];
                         if (it->dest != n) {
                             if (wc[c] == -1) {
                                 wc[c] = 0;
@@ -181,54 +311,288 @@ class Community {
                         }
                     }
 
-                    int best_c=n2c[n];
-                    double best_inc = 0;
-
-                    for (int i=0; i < nc.size(); i++) {
-                        double inc = wc[nc[i]] - g->arity(n) * arity[nc[i]] / g->arity();
-                        if (inc > best_inc) {
-                            best_inc = inc;
-                            best_c = nc[i];
-                        }
+                    nw.resize(nc.size());
+                    na.resize(nc.size());
+                    for (size_t i=0; i < nc.size(); i++) {
+                        nw[i] = wc[nc[i]];
+                        na[i] = arity[nc[i]];
                     }
+                    int best = best_community(nw.data(), na.data(), nc.size(),
+                                              g->arity(n), g->arity());
+                    node best_c = (best < 0) ? n2c[n] : nc[best];
                     if (best_c != n2c[n]) { 
                         //cerr << "Node " << n << " goes " << n2c[n] << " -> " <<best_c << " inc="<<2*best_inc/g->arity()<<endl;
-                        changed = true;
+                        moved++;
                         improved = true;
                         n2c[n] = best_c;
                     }
 
                     arity[best_c] += g->arity(n);
                 }
+                sweep(naux, moved);
             }
-            while (changed);
+            while (moved > 0 && naux == g->size());
             return (improved);
         }
 
+        //----------------------------------------------------------------------
+        // Same as one_level(), but instead of sweeping all nodes until none
+        // moves, keeps a queue of nodes to visit: initially all of them in 
+        // random order, and then the neighbors of the nodes that move out of
+        // their communities. Sweep k+1 are the nodes queued during sweep k.
+        // Returns "true" if partition changed.
+        //----------------------------------------------------------------------
+        bool move_queue() {
+
+            bool improved = false;
+            size_t n = g->size();
+            if (n == 0)
+                return false;
+
+            // Circular queue, where every node is at most once
+            vector<node> queue(n);
+            vector<bool> queued(n, true);
+            for (size_t i=0; i<n; i++)
+                queue[i] = i;
+            shuffle(queue, rng);
+            size_t head = 0, len = n;
+            size_t swept = n, left = n; // Nodes of the current sweep, and left
+            long long moved = 0;
+
+            vector <double> wc(n, -1);
+            vector <node> nc;
+            vector <double> nw, na;
+            iterations++;
+            while (len > 0) {
+                if (stop()) {
+                    sweep(swept - left, moved);
+                    break;
+                }
+                node v = queue[head];
+                head = (head + 1) % n;
+                len--;
+                queued[v] = false;
+                visits++;
+
+                arity[n2c[v]] -= g->arity(v);
+                for (typename G::NeighIter it=g->begin(v); it != g->end(v); ++it) {
+                    node c = n2c[it->dest];
+                    if (it->dest != v) {
+                        if (wc[c] == -1) {
+                            wc[c] = 0;
+                            nc.push_back(c);
+                        }
+                        wc[c] += (double)it->weight;
+                    }
+                }
+
+                nw.resize(nc.size());
+                na.resize(nc.size());
+                for (size_t i=0; i < nc.size(); i++) {
+                    nw[i] = wc[nc[i]];
+                    na[i] = arity[nc[i]];
+                }
+                int best = best_community(nw.data(), na.data(), nc.size(),
+                                          g->arity(v), g->arity());
+                node best_c = (best < 0) ? n2c[v] : nc[best];
+                if (best_c != n2c[v]) {
+                    improved = true;
+                    moved++;
+                    n2c[v] = best_c;
+                    for (typename G::NeighIter it=g->begin(v); it != g->end(v); ++it) {
+                        node u = it->dest;
+                        if (!queued[u] && n2c[u] != best_c) {
+                            queued[u] = true;
+                            queue[(head + len) % n] = u;
+                            len++;
+                        }
+                    }
+                }
+                arity[best_c] += g->arity(v);
+
+                for (size_t i=0; i < nc.size(); i++)
+                    wc[nc[i]] = -1;
+                nc.clear();
+
+                if (--left == 0) {
+                    sweep(swept, moved);
+                    left = swept = len;
+                    moved = 0;
+                    if (len > 0)
+                        iterations++;
+                }
+            }
+            return improved;
+        }
+
+        //----------------------------------------------------------------------
+        // Refinement phase of the Leiden method: splits every community of 
+        // "n2c" into well-connected parts, merging singleton nodes, in random
+        // order, into the part of their community with the greatest positive
+        // modularity gain among those well connected to the rest of it. 
+        // Returns the part of every node, a subset of its community.
+        //----------------------------------------------------------------------
+        vector<node> refine() {
+
+            size_t n = g->size();
+            double total = g->arity();
+            vector<node> part(n);
+            vector<double> ptot(n), pext(n), ext(n, 0);
+            vector<size_t> psize(n, 1);
+
+            // ext[v] = weight from v to the rest of its community
+            for (size_t v=0; v<n; v++) {
+                part[v] = v;
+                ptot[v] = g->arity(v);
+                for (typename G::NeighIter it=g->begin(v); it != g->end(v); ++it)
+                    if (it->dest != (node)v && n2c[it->dest] == n2c[v])
+                        ext[v] += it->weight;
+                pext[v] = ext[v];
+            }
+            if (total <= 0)
+                return part;
+
+            vector<node> order(n);
+            for (size_t i=0; i<n; i++)
+                order[i] = i;
+            shuffle(order, rng);
+
+            vector <double> wp(n, -1);
+            vector <node> np;
+            for (size_t i=0; i<n; i++) {
+                node v = order[i];
+                node c = n2c[v];
+                double a = g->arity(v);
+                if (psize[part[v]] > 1 || ext[v] < a * (arity[c] - a) / total)
+                    continue;
+
+                for (typename G::NeighIter it=g->begin(v); it != g->end(v); ++it) {
+                    node u = it->dest;
+                    if (u != v && n2c[u] == c) {
+                        if (wp[part[u]] == -1) {
+                            wp[part[u]] = 0;
+                            np.push_back(part[u]);
+                        }
+                        wp[part[u]] += it->weight;
+                    }
+                }
+
+                node best = part[v];
+                double best_inc = 0;
+                for (size_t k=0; k<np.size(); k++) {
+                    node p = np[k];
+                    if (pext[p] < ptot[p] * (arity[c] - ptot[p]) / total)
+                        continue;
+                    double inc = wp[p] - a * ptot[p] / total;
+                    if (inc > best_inc) {
+                        best_inc = inc;
+                        best = p;
+                    }
+                }
+                if (best != part[v]) {
+                    pext[best] += ext[v] - 2 * wp[best];
+                    ptot[best] += a;
+                    psize[best]++;
+                    psize[part[v]] = 0;
+                    part[v] = best;
+                }
+
+                for (size_t k=0; k<np.size(); k++)
+                    wp[np[k]] = -1;
+                np.clear();
+            }
+            return part;
+        }
+
         //----------------------------------------------------------------------
         // Given a graph "g" and a partition "n2c" generates a new graf "g2" 
         // where nodes are communities and edges are the sum of the edges 
         // between both communities.
+        // Nodes are bucketed by community, and every community accumulates 
+        // the weights towards its neighbor communities independently (in 
+        // parallel when available) into its row of "g2".
         //----------------------------------------------------------------------
-        Graph* community2graph() {
+        G* community2graph() {
 
-            vector <int> ren(n2c.size(), -1);
+            vector <node> ren(n2c.size(), (node)-1);
 
-            for (int i=0; i<n2c.size(); i++)
+            for (size_t i=0; i<n2c.size(); i++)
                 ren[n2c[i]] = 0;
             
-            int aux=0;
+            node aux=0;
             
-            for (int i=0; i<ren.size(); i++)
+            for (size_t i=0; i<ren.size(); i++)
                 if (ren[i] == 0) ren[i] = aux++;
             
-            for (int i=0; i<n2c.size(); i++)
+            for (size_t i=0; i<n2c.size(); i++)
                 n2c[i] = ren[n2c[i]];
 
-            Graph* g2 = new Graph(aux,0);
+            // members[first[c]..first[c+1]-1] = nodes of community c
+            vector <size_t> first(aux+1, 0);
+            for (size_t i=0; i<n2c.size(); i++)
+                first[n2c[i]+1]++;
+            for (node c=0; c<aux; c++)
+                first[c+1] += first[c];
+
+            vector <node> members(n2c.size());
+            vector <size_t> next(first.begin(), first.end()-1);
+            for (size_t i=0; i<n2c.size(); i++)
+                members[next[n2c[i]]++] = i;
+
+            G* g2 = new G(aux,0);
+            vector <vector <pair<node,weight> > > rows(aux);
+            bool dense = aux <= DENSE_AGGREGATION;
+
+            #pragma omp parallel
+            {
+                // wc[c] = weight towards community c, or -1 if not connected
+                vector <double> wc;
+                unordered_map <node,double> hc;
+                vector <node> nc;
+
+                if (dense) wc.resize(aux, -1);
 
-            for (Graph::EdgeIter it=g->begin(); it != g->end(); ++it)
-                g2->add_edge(n2c[it->orig], n2c[it->dest], (double)it->weight);
+                #pragma omp for schedule(dynamic,64)
+                for (long long c=0; c<(long long)aux; c++) {
+                    for (size_t k=first[c]; k<first[c+1]; k++) {
+                        node n = members[k];
+                        for (typename G::NeighIter it=g->begin(n); it != g->end(n); ++it) {
+                            node c2 = n2c[it->dest];
+                            double w = it->weight;
+                            // Inner edges are seen from both ends
+                            if (c2 == (node)c && it->dest != n) w /= 2;
+                            if (dense) {
+                                if (wc[c2] == -1) {
+                                    wc[c2] = 0;
+                                    nc.push_back(c2);
+                                }
+                                wc[c2] += w;
+                            } else {
+                                hc[c2] += w;
+                            }
+                        }
+                    }
+
+                    if (!dense) {
+                        for (typename unordered_map<node,double>::iterator it=hc.begin(); it != hc.end(); ++it)
+                            nc.push_back(it->first);
+                    }
+                    sort(nc.begin(), nc.end());
+                    rows[c].reserve(nc.size());
+                    for (size_t i=0; i<nc.size(); i++) {
+                        if (dense) {
+                            rows[c].push_back(make_pair(nc[i], (weight)wc[nc[i]]));
+                            wc[nc[i]] = -1;
+                        } else {
+                            rows[c].push_back(make_pair(nc[i], (weight)hc[nc[i]]));
+                        }
+                    }
+
+                    nc.clear();
+                    hc.clear();
+                }
+            }
+            g2->set_rows(rows);
 
             return g2;
         }
@@ -239,28 +603,140 @@ class Community {
         // into nodes applying "community2graph".
         //----------------------------------------------------------------------
         double compute_modularity_GFA(double precision) {
-
-            bool improved;
             Community* c = new Community(g);
+            c->rng = rng;
+            c->queue = queue;
+            c->budget = budget;
+            return GFA(c, precision);
+        }
 
-            do {
-                double aux = c->modularity();
-                improved = c->one_level() && abs2(c->modularity()-aux) > precision;
-                //improved = c->one_level();
-                if (improved) {
-                    c->g = c->community2graph();
-                    improved = (ncomm != c->g->size());
-                    ncomm = c->g->size();
-                    for (int i = 0; i<n2c.size(); i++) 
-                        n2c[i] = c->n2c[n2c[i]];
-                    iterations += c->iterations;
-                    c = new Community(c->g);
+        //----------------------------------------------------------------------
+        // Same as above, but starting from the partition "start" (community 
+        // in [0..n-1] of every node) instead of singletons, e.g. the one 
+        // found for a previous version of the formula. Nodes are moved from
+        // their given communities, that are collapsed even if none moves, so
+        // a near-identical graph converges in one or two sweeps.
+        //----------------------------------------------------------------------
+        double compute_modularity_GFA(double precision, vector<node> &start) {
+
+            assert(start.size() == g->size());
+            Community* c = new Community(g, start);
+            c->rng = rng;
+            c->queue = queue;
+            c->budget = budget;
+            c->one_level();
+            account(c);
+            if (budget != NULL && budget->expired())
+                return truncate(c);
+            G* g2 = c->community2graph();
+            n2c = c->n2c;
+            ncomm = g2->size();
+            levels.push_back(n2c);
+            delete c;
+            c = new Community(g2);
+            c->rng = rng;
+            c->queue = queue;
+            c->budget = budget;
+            return GFA(c, precision);
+        }
+
+        //----------------------------------------------------------------------
+        // Computes a partition "n2c" by the given CommunityMethod, from 
+        // singletons or from "start" if not NULL
+        //----------------------------------------------------------------------
+        double compute_modularity(int method, double precision, vector<node>* start = NULL) {
+            if (method == METHOD_LEIDEN)
+                return compute_modularity_Leiden(precision, start);
+            queue = (method == METHOD_LOUVAIN_QUEUE);
+            if (start != NULL)
+                return compute_modularity_GFA(precision, *start);
+            return compute_modularity_GFA(precision);
+        }
+
+        //----------------------------------------------------------------------
+        // Given a graph "g", computes a partition "n2c" by the Leiden method:
+        // as the GFA method, but moving nodes with move_queue(), and 
+        // collapsing the well-connected parts found by refine() instead of 
+        // whole communities, every part starting in its community. Starts 
+        // from "start" if given.
+        //----------------------------------------------------------------------
+        double compute_modularity_Leiden(double precision, vector<node>* start = NULL) {
+
+            Community* c = (start == NULL) ? new Community(g) : new Community(g, *start);
+            c->rng = rng;
+            c->budget = budget;
+            for (size_t i = 0; i<n2c.size(); i++)
+                n2c[i] = i;
+            double q = 0;
+            bool first = true;
+
+            while (true) {
+                c->move_queue();
+                account(c);
+
+                // Partition of the nodes of "g"
+                vector<node> part(n2c.size());
+                for (size_t i = 0; i<n2c.size(); i++)
+                    part[i] = c->n2c[n2c[i]];
+                Community p(g, part);
+                double q2 = p.modularity();
+
+                node comms = 0;
+                vector<bool> used(c->g->size(), false);
+                for (size_t i=0; i<c->n2c.size(); i++)
+                    if (!used[c->n2c[i]]) {
+                        used[c->n2c[i]] = true;
+                        comms++;
+                    }
+                bool done = comms == c->g->size() || (!first && q2 - q <= precision) ||
+                            (budget != NULL && budget->expired());
+                if (first || q2 > q) {
+                    levels.push_back(part);
+                    q = q2;
                 }
-                if(verbose)
-                    cerr <<"\tQ = "<<modularity()<<" #comm = "<<ncomm<<endl;
-                //c.g.print();
-            } while (improved);
-            return modularity();
+                first = false;
+                if (done)
+                    break;
+
+                // Collapse the parts, starting in their communities
+                vector<node> comm = c->n2c;
+                c->n2c = c->refine();
+                G* g2 = c->community2graph();
+                vector<node> start2(g2->size());
+                for (size_t i=0; i<comm.size(); i++)
+                    start2[c->n2c[i]] = comm[i];
+                for (size_t i = 0; i<n2c.size(); i++)
+                    n2c[i] = c->n2c[n2c[i]];
+                if (c->g != g) delete c->g;
+                delete c;
+
+                // Communities renumbered in [0..g2->size()-1]
+                vector<node> ren(comm.size(), (node)-1);
+                node k = 0;
+                for (size_t i=0; i<start2.size(); i++) {
+                    if (ren[start2[i]] == (node)-1) ren[start2[i]] = k++;
+                    start2[i] = ren[start2[i]];
+                }
+                c = new Community(g2, start2);
+                c->rng = rng;
+                c->budget = budget;
+            }
+
+            n2c = levels.back();
+            if (c->g != g) delete c->g;
+            delete c;
+
+            // Communities renumbered in [0..ncomm-1]
+            vector<node> ren(n2c.size(), (node)-1);
+            ncomm = 0;
+            for (size_t i=0; i<n2c.size(); i++) {
+                if (ren[n2c[i]] == (node)-1) ren[n2c[i]] = ncomm++;
+                n2c[i] = ren[n2c[i]];
+            }
+            levels.back() = n2c;
+            if(verbose)
+                cerr <<"\tQ = "<<q<<" #comm = "<<ncomm<<" visits = "<<visits<<endl;
+            return q;
         }
 
         //----------------------------------------------------------------------
@@ -277,21 +753,21 @@ class Community {
         //----------------------------------------------------------------------
         void connected() {
 
-            for(int i=0; i<n2c.size(); i++) 
-                n2c[i] = -1;
+            for(size_t i=0; i<n2c.size(); i++) 
+                n2c[i] = (node)-1;
 
-            int c=0;
+            node c=0;
 
-            stack <int> nb;
-            for(int i=0; i<g->size(); i++) {
-                if (n2c[i] == -1) {
+            stack <node> nb;
+            for(node i=0; i<g->size(); i++) {
+                if (n2c[i] == (node)-1) {
                     n2c[i] = c;
                     nb.push(i);
                     while (!nb.empty()) {
-                        int n = nb.top();
+                        node n = nb.top();
                         nb.pop();
-                        for(Graph::NeighIter it=g->begin(n); it != g->end(n); it++)
-                        if (n2c[it->dest] == -1) {
+                        for(typename G::NeighIter it=g->begin(n); it != g->end(n); it++)
+                        if (n2c[it->dest] == (node)-1) {
                             n2c[it->dest] = c;
                             nb.push(it->dest);   
                         } 
@@ -307,14 +783,14 @@ class Community {
 
 
             Comm.resize(g->size());
-            for (int i=0; i<g->size(); i++)
+            for (node i=0; i<g->size(); i++)
                 Comm[n2c[i]].push_back(i+1);
 
-            for (int i=0; i< Comm.size(); i++)
-                Comm_order.push_back(make_pair(i,Comm[i].size()));
-            sort(Comm_order.begin(), Comm_order.end(), my_bigger_communities);
+            for (size_t i=0; i< Comm.size(); i++)
+                Comm_order.push_back(make_pair((node)i,Comm[i].size()));
+            sort(Comm_order.begin(), Comm_order.end(), my_bigger_communities<node>);
 
-            int i;
+            size_t i;
             for (i=0; i< Comm.size() && Comm[Comm_order[i].first].size() >0; i++);
                 ncomm=i;
 
@@ -338,10 +814,10 @@ class Community {
                 exit(-1);
             }
             fprintf(file,"%d\n",(int)Comm.size());
-            for (int i=0; i<Comm.size(); i++) {
-                fprintf(file,"%d ",i+1);
-                for (int j=0; j<Comm[Comm_order[i].first].size(); j++)
-                    fprintf(file,"%d ", Comm[Comm_order[i].first][j]);
+            for (size_t i=0; i<Comm.size(); i++) {
+                fprintf(file,"%llu ",(unsigned long long)i+1);
+                for (size_t j=0; j<Comm[Comm_order[i].first].size(); j++)
+                    fprintf(file,"%llu ", (unsigned long long)Comm[Comm_order[i].first][j]);
                 fprintf(file,"0\n");
             }
             fclose(file);
@@ -355,7 +831,7 @@ class Community {
             cerr <<"------- COMMUNITY ------\n";
             cerr <<"Q = "<<modularity()<<endl;
             cerr <<"#C = "<<ncomm<<endl;  
-            for (int i=0; i<n2c.size(); i++) 
+            for (size_t i=0; i<n2c.size(); i++) 
                 cerr <<i<<" -> "<<n2c[i]<<endl;
             //g.print();
         }
@@ -370,9 +846,181 @@ class Community {
                 exit(-1);
             }
             
-            for(int i=0; i<n2c.size(); i++)
-                fprintf(file, "%d\n", n2c[i]);
+            for(size_t i=0; i<n2c.size(); i++)
+                fprintf(file, "%llu\n", (unsigned long long)n2c[i]);
             fclose(file);
         }
+
+    private:
+
+        // Polls the budget every BUDGET_POLL visits
+        bool stop() {
+            return budget != NULL && visits % BUDGET_POLL == 0 && budget->expired();
+        }
+
+        //----------------------------------------------------------------------
+        // Ends the GFA method stopped by the budget: takes the partition of
+        // the community "c" of the current level, the best one found, and
+        // frees it
+        //----------------------------------------------------------------------
+        double truncate(Community* c) {
+            for (size_t i = 0; i<n2c.size(); i++)
+                n2c[i] = c->n2c[n2c[i]];
+            vector<node> ren(n2c.size(), (node)-1);
+            ncomm = 0;
+            for (size_t i=0; i<n2c.size(); i++) {
+                if (ren[n2c[i]] == (node)-1) ren[n2c[i]] = ncomm++;
+                n2c[i] = ren[n2c[i]];
+            }
+            levels.push_back(n2c);
+            if (c->g != g) delete c->g;
+            delete c;
+            if(verbose)
+                cerr <<"\tTruncated: Q = "<<modularity()<<" #comm = "<<ncomm<<endl;
+            return modularity();
+        }
+
+        //----------------------------------------------------------------------
+        // Records a sweep of the local moving that evaluated "evaluated" 
+        // nodes and moved "moved" of them
+        //----------------------------------------------------------------------
+        void sweep(long long evaluated, long long moved) {
+            sweeps.push_back(make_pair(evaluated, moved));
+            if(verbose)
+                cerr <<"\t  sweep "<<sweeps.size()<<": evaluated = "<<evaluated
+                     <<" moved = "<<moved<<endl;
+        }
+
+        //----------------------------------------------------------------------
+        // Adds the work done by the community "c" of a collapsed graph
+        //----------------------------------------------------------------------
+        void account(Community* c) {
+            iterations += c->iterations;
+            visits += c->visits;
+            sweeps.insert(sweeps.end(), c->sweeps.begin(), c->sweeps.end());
+            c->iterations = 0;
+            c->visits = 0;
+            c->sweeps.clear();
+        }
+
+        //----------------------------------------------------------------------
+        // Runs the levels of the GFA method from the community "c" of a graph
+        // whose nodes are the current communities of "g", and frees it.
+        //----------------------------------------------------------------------
+        double GFA(Community* c, double precision) {
+
+            bool improved;
+
+            do {
+                double aux = c->modularity();
+                improved = c->one_level() && abs2(c->modularity()-aux) > precision;
+                //improved = c->one_level();
+                account(c);
+                if (budget != NULL && budget->expired())
+                    return truncate(c);
+                if (improved) {
+                    G* g2 = c->community2graph();
+                    if (c->g != g) delete c->g;
+                    c->g = g2;
+                    improved = (ncomm != c->g->size());
+                    ncomm = c->g->size();
+                    for (size_t i = 0; i<n2c.size(); i++) 
+                        n2c[i] = c->n2c[n2c[i]];
+                    if (improved)
+                        levels.push_back(n2c);
+                    Community* c2 = new Community(c->g);
+                    c2->rng = rng;
+                    c2->queue = queue;
+                    c2->budget = budget;
+                    delete c;
+                    c = c2;
+                }
+                if(verbose)
+                    cerr <<"\tQ = "<<modularity()<<" #comm = "<<ncomm<<endl;
+                //c.g.print();
+            } while (improved);
+
+            // Free the collapsed graphs
+            if (c->g != g) delete c->g;
+            delete c;
+            return modularity();
+        }
+};
+
+//------------------------------------------------------------------------------
+// Results of several independent runs of the GFA method on a graph
+//------------------------------------------------------------------------------
+template <class node>
+struct Ensemble {
+    vector<double> q;               // Modularity of every run
+    double best, mean, std;
+    vector<node> partition;         // Partition of the best run
+    vector<node> consensus;         // Consensus partition, if computed
+    double consensus_q;             // and its modularity in the graph
 };
+
+//------------------------------------------------------------------------------
+// Runs the GFA (or other) method "runs" times on "g", concurrently, every run shuffling
+// with its own generator seeded from "seed", so that results only depend on
+// the seed and not on the number of threads. If "consensus", also finds a 
+// consensus partition, continuing the GFA method from the core groups of 
+// nodes that all runs put together. Runs stop when "budget" is exhausted.
+//------------------------------------------------------------------------------
+template <class G>
+Ensemble<typename G::node_t> ensemble_GFA(G* g, int runs, double precision, 
+                                          uint64_t seed, bool consensus,
+                                          int method = METHOD_LOUVAIN, Budget* budget = NULL) {
+
+    typedef typename G::node_t node;
+    Ensemble<node> e;
+    vector<vector<node> > partitions(runs);
+    e.q.resize(runs);
+
+    #pragma omp parallel for schedule(dynamic,1)
+    for (int r=0; r<runs; r++) {
+        Random rng(seed + 0x9E3779B97F4A7C15ULL * r);
+        Community<G> c(g);
+        c.rng = &rng;
+        c.budget = budget;
+        e.q[r] = c.compute_modularity(method, precision);
+        partitions[r].swap(c.n2c);
+    }
+
+    e.best = e.mean = e.std = e.consensus_q = 0;
+    int best = 0;
+    for (int r=0; r<runs; r++) {
+        e.mean += e.q[r];
+        if (e.q[r] > e.q[best]) best = r;
+    }
+    e.mean /= runs;
+    for (int r=0; r<runs; r++)
+        e.std += (e.q[r] - e.mean) * (e.q[r] - e.mean) / runs;
+    e.std = sqrt(e.std);
+    if (runs > 0) {
+        e.best = e.q[best];
+        e.partition = partitions[best];
+    }
+
+    if (consensus && runs > 0) {
+        // Core groups: nodes that every run puts together
+        vector<node> core(g->size(), 0);
+        for (int r=0; r<runs; r++) {
+            unordered_map<uint64_t,node> ren;
+            for (node i=0; i<g->size(); i++) {
+                uint64_t key = (uint64_t)core[i] * g->size() + partitions[r][i];
+                typename unordered_map<uint64_t,node>::iterator it = ren.find(key);
+                if (it == ren.end())
+                    it = ren.insert(make_pair(key, (node)ren.size())).first;
+                core[i] = it->second;
+            }
+        }
+        Random rng(seed);
+        Community<G> c(g);
+        c.rng = &rng;
+        c.budget = budget;
+        e.consensus_q = c.compute_modularity(method, precision, &core);
+        e.consensus.swap(c.n2c);
+    }
+    return e;
+}
 #endif
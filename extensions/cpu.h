@@ -0,0 +1,34 @@
+/*
+    cpu.h
+
+    Runtime CPU dispatch. Functions marked as MULTIVERSION are compiled for
+    several instruction sets, and the best one supported by the CPU is
+    selected when the module is loaded, so that a portable build still runs
+    the vectorized kernels on AVX2 and AVX-512 machines.
+
+*/
+#ifndef CPU_H
+#define CPU_H
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define MULTIVERSION __attribute__((target_clones("avx512f","avx2","sse4.2","default")))
+#define CPU_DISPATCH 1
+#else
+#define MULTIVERSION
+#define CPU_DISPATCH 0
+#endif
+
+//------------------------------------------------------------------------------
+// Returns the instruction set used by the MULTIVERSION functions
+//------------------------------------------------------------------------------
+const char* cpu_level() {
+#if CPU_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return "avx512f";
+    if (__builtin_cpu_supports("avx2")) return "avx2";
+    if (__builtin_cpu_supports("sse4.2")) return "sse4.2";
+#endif
+    return "default";
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*
+    dimacs.h
+
+    Buffered reader of CNF files in DIMACS format. The file is read in large
+    chunks, and the integers of each chunk are parsed at once by a
+    vectorizable kernel. DIMACS text already in memory is parsed in place.
+
+*/
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "cpu.h"
+
+#ifndef DIMACS_H
+#define DIMACS_H
+
+using namespace std;
+
+#define DIMACS_CHUNK (1 << 20)
+
+//------------------------------------------------------------------------------
+// Parses the integers in [p, end) into "out", skipping comment lines. If the
+// text is not complete ("last" false), stops before a token that could
+// continue after "end". Stops at the first token that is not an integer,
+// setting "bad". Returns the position where parsing stopped.
+//------------------------------------------------------------------------------
+MULTIVERSION
+const char* parse_ints(const char* p, const char* end, bool last, vector<int> &out, bool &bad) {
+
+    bad = false;
+    while (true) {
+        while (p < end && (unsigned char)*p <= ' ')
+            p++;
+        if (p == end)
+            return p;
+
+        const char* token = p;
+        if (*p == 'c') {
+            const char* nl = (const char*)memchr(p, '\n', end - p);
+            if (nl == NULL)
+                return last ? end : token;
+            p = nl + 1;
+            continue;
+        }
+
+        bool neg = (*p == '-');
+        if (neg) p++;
+        const char* digits = p;
+        unsigned int v = 0;
+        while (p < end && (unsigned char)(*p - '0') < 10) {
+            v = v * 10 + (*p - '0');
+            p++;
+        }
+        if (p == end && !last)
+            return token;
+        if (p == digits || (p < end && (unsigned char)*p > ' ')) {
+            bad = true;
+            return token;
+        }
+        out.push_back(neg ? -(int)v : (int)v);
+    }
+}
+
+class DimacsReader {
+
+    FILE* source;           // NULL for text in memory
+    vector<char> buf;
+    const char* text;       // Text read and not parsed yet is [pos, len)
+    size_t pos, len;
+    bool eof, stop;
+    vector<int> ints;       // Integers parsed and not consumed yet
+    size_t next_int;
+
+    // Reads more text, keeping the unparsed one. Returns false at the end
+    bool refill() {
+        if (eof)
+            return false;
+        if (pos > 0) {
+            memmove(&buf[0], &buf[pos], len - pos);
+            len -= pos;
+            pos = 0;
+        }
+        if (len == buf.size())
+            buf.resize(2 * buf.size());
+        size_t r = fread(&buf[len], 1, buf.size() - len, source);
+        text = &buf[0];
+        len += r;
+        if (r == 0 || feof(source))
+            eof = true;
+        return true;
+    }
+
+    int getch() {
+        if (pos == len && !refill())
+            return EOF;
+        if (pos == len)
+            return getch();
+        return (unsigned char)text[pos++];
+    }
+
+    public:
+
+        DimacsReader(FILE* f) : source(f), buf(DIMACS_CHUNK), text(&buf[0]), pos(0), 
+                                len(0), eof(false), stop(false), next_int(0) {}
+
+        // Reads the DIMACS text [t, t+size), that is not copied
+        DimacsReader(const char* t, size_t size) : source(NULL), text(t), pos(0), 
+                                len(size), eof(true), stop(false), next_int(0) {}
+
+        //----------------------------------------------------------------------
+        // Skips the comments and reads the "p cnf <vars> <clauses>" line.
+        // Returns false if it is not found. An empty file is an empty formula.
+        // Sizes are 64-bit, as clauses of big instances exceed 2^31.
+        //----------------------------------------------------------------------
+        bool header(long long &vars, long long &clauses) {
+
+            vars = clauses = 0;
+            int ch = getch();
+            while (ch == 'c' || ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+                if (ch == 'c')
+                    while (ch != '\n' && ch != EOF)
+                        ch = getch();
+                ch = getch();
+            }
+            if (ch == EOF)
+                return true;
+
+            const char* expected = "p cnf";
+            for (int i=0; expected[i] != 0; i++, ch = getch()) {
+                if (ch != expected[i])
+                    return false;
+            }
+
+            long long v[2];
+            for (int i=0; i<2; i++) {
+                while (ch == ' ' || ch == '\t')
+                    ch = getch();
+                if (ch < '0' || ch > '9')
+                    return false;
+                for (v[i] = 0; ch >= '0' && ch <= '9'; ch = getch())
+                    v[i] = v[i] * 10 + (ch - '0');
+            }
+            if (ch != EOF)
+                pos--;
+            vars = v[0];
+            clauses = v[1];
+            return true;
+        }
+
+        //----------------------------------------------------------------------
+        // Reads the next integer into x. Returns false at the end of the file
+        // or at the first token that is not an integer.
+        //----------------------------------------------------------------------
+        bool next(int &x) {
+            while (next_int == ints.size()) {
+                if (stop)
+                    return false;
+                ints.clear();
+                next_int = 0;
+                if (pos == len && !refill())
+                    return false;
+                bool bad;
+                pos = parse_ints(text + pos, text + len, eof, ints, bad) - text;
+                if (bad)
+                    stop = true;
+                else if (ints.empty() && !refill() && pos == len)
+                    return false;
+            }
+            x = ints[next_int++];
+            return true;
+        }
+};
+
+#endif
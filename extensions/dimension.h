@@ -27,12 +27,12 @@ Contact: jgiraldez@iiia.csic.es
 */
 #include <vector>
 #include <stack>
-#ifndef VECTOR
-#include "graph_set.h"
-#else
-#include "graph_vector.h"
-#endif
+#include "graph.h"
+#include "budget.h"
+#include "community.h"
+#include "cpu.h"
 #include <algorithm>
+#include <math.h>
 
 #ifndef DIMENSION_H
 #define DIMENSION_H
@@ -41,26 +41,33 @@ using namespace std;
 
 typedef int diameter;
 
+// Graphs up to this number of nodes, and at least this average degree, are
+// covered with a BitMatrix (of 8 MB at most)
+#define BITSET_NODES 8192
+#define BITSET_DEGREE 8
+
 extern bool verbose;
 extern int maxx;
 
 //------------------------------------------------------------------------------
 // Computes the number of disconected components of a graph
 //------------------------------------------------------------------------------
-int components(Graph *g) {
+template <class G>
+long long components(G *g) {
 
-    stack <int> s;
+    typedef typename G::node_t node;
+    stack <node> s;
     vector <bool> covered(g->size(), false);
-    int comp = 0;
+    long long comp = 0;
 
-    for (int c=0; c<g->size(); c++) {
+    for (node c=0; c<g->size(); c++) {
         if (!covered[c]) {
             covered[c] = true;
             s.push(c);
             while(!s.empty()) {
-                int v = s.top();
+                node v = s.top();
                 s.pop();
-                for (Graph::NeighIter it=g->begin(v); it != g->end(v); it++)
+                for (typename G::NeighIter it=g->begin(v); it != g->end(v); it++)
                 if (!covered[it->dest]) {
                     covered[it->dest] = true;
                     s.push(it->dest);
@@ -72,19 +79,53 @@ int components(Graph *g) {
     return comp;
 }
 
+//------------------------------------------------------------------------------
+// Sets label[x] to the connected component of every node x, and returns the
+// size of every component
+//------------------------------------------------------------------------------
+template <class G>
+vector<size_t> label_components(G *g, vector<long long> &label) {
+
+    typedef typename G::node_t node;
+    stack <node> s;
+    vector <size_t> sizes;
+    label.assign(g->size(), -1);
+
+    for (node c=0; c<g->size(); c++) {
+        if (label[c] < 0) {
+            label[c] = sizes.size();
+            sizes.push_back(1);
+            s.push(c);
+            while(!s.empty()) {
+                node v = s.top();
+                s.pop();
+                for (typename G::NeighIter it=g->begin(v); it != g->end(v); it++)
+                if (label[it->dest] < 0) {
+                    label[it->dest] = label[c];
+                    sizes.back()++;
+                    s.push(it->dest);
+                }
+            }
+        }
+    }
+    return sizes;
+}
+
 //------------------------------------------------------------------------------
 // Given a node c and a distance d, returns the number of nodes c2 reachable 
 // from c at distance d and not marked as cover[c2]==-1
 //------------------------------------------------------------------------------
-int tile(int c, diameter d, vector <diameter> &cover, Graph *g) {
+template <class G>
+size_t tile(typename G::node_t c, diameter d, vector <diameter> &cover, G *g) {
     
-    int ncover = 0;
-    stack <pair <int, diameter> > s;
+    typedef typename G::node_t node;
+    size_t ncover = 0;
+    stack <pair <node, diameter> > s;
 
     s.push(make_pair(c,d));
     // cerr <<"center "<<c<<" "<<d<<endl;
     while(!s.empty()) {
-        int c = s.top().first;
+        node c = s.top().first;
         diameter d = s.top().second;
         s.pop();
         // cerr <<c<<" "<<d<<endl;
@@ -97,7 +138,7 @@ int tile(int c, diameter d, vector <diameter> &cover, Graph *g) {
         cover[c] = d;
 
         //push neighs of c to the stack with d-1
-        for (Graph::NeighIter it=g->begin(c); it != g->end(c); it++)
+        for (typename G::NeighIter it=g->begin(c); it != g->end(c); it++)
             if (d > 1) 
             s.push(make_pair(it->dest, d-1));
     }
@@ -107,25 +148,29 @@ int tile(int c, diameter d, vector <diameter> &cover, Graph *g) {
 
 //------------------------------------------------------------------------------
 // Given a graph g, and a diameter d, computes how many tiles of diameter d are
-// needed for covering the graph, trying tile centers as centers
+// needed for covering the graph, trying tile centers as centers. Returns -1
+// if "budget" is exhausted before.
 //------------------------------------------------------------------------------
-int needed(Graph *g, diameter d, vector <int> &centers) {  
+template <class G>
+long long needed(G *g, diameter d, vector <typename G::node_t> &centers, Budget* budget = NULL) {  
 
 
 
     if(d==1)
         return g->size();
 
-    int ncover = 0;
+    size_t ncover = 0;
     vector <diameter> cover(g->size(), -1);
-    int needed = 0;       // needed[l] = 0;
+    long long needed = 0;       // needed[l] = 0;
 
-    int i=0;
+    size_t i=0;
     while (ncover < g->size()) {
-        int c = centers[i++];
+        if (budget != NULL && i % BUDGET_POLL == 0 && budget->expired())
+            return -1;
+        typename G::node_t c = centers[i++];
         while (cover[c] != -1) 
             c = centers[i++];
-        int tc = tile(c, d, cover, g);
+        size_t tc = tile(c, d, cover, g);
         //cerr<<(double)i*100/g->size()<<" "<<(double)ncover*100/g->size()<<endl;
         if (tc > 0) {
             needed++;
@@ -137,42 +182,240 @@ int needed(Graph *g, diameter d, vector <int> &centers) {
 
 
 //------------------------------------------------------------------------------
-bool comparesecond(pair <int,int> a, pair <int,int> b) {
+// dst[0..w-1] |= src[0..w-1]
+//------------------------------------------------------------------------------
+MULTIVERSION
+void or_words(uint64_t* dst, const uint64_t* src, size_t w) {
+    #pragma omp simd
+    for (size_t i=0; i<w; i++)
+        dst[i] |= src[i];
+}
+
+//------------------------------------------------------------------------------
+// Adjacency of a graph of at most BITSET_NODES nodes as a matrix of bits,
+// row x with bit y set if y is a neighbor of x
+//------------------------------------------------------------------------------
+struct BitMatrix {
+    size_t n, words;            // Nodes, and 64-bit words of every row
+    vector <uint64_t> bits;
+
+    template <class G>
+    BitMatrix(G *g) : n(g->size()), words((g->size() + 63) / 64), bits(n * words, 0) {
+        for (size_t x=0; x<n; x++)
+            for (typename G::NeighIter it=g->begin(x); it != g->end(x); it++)
+                bits[x * words + it->dest / 64] |= (uint64_t)1 << (it->dest % 64);
+    }
+
+    const uint64_t* row(size_t x) const { return bits.data() + x * words; }
+};
+
+//------------------------------------------------------------------------------
+// Same as needed(), with the frontiers, the balls and the covered nodes as
+// bit vectors. The ball of a center grows by the OR of the rows of its
+// frontier, 64 nodes per word, and without the revisits of the DFS of tile().
+//------------------------------------------------------------------------------
+template <class node>
+long long needed_bitset(const BitMatrix &m, diameter d, vector <node> &centers, Budget* budget = NULL) {
+
+    if(d==1)
+        return m.n;
+
+    size_t w = m.words;
+    vector <uint64_t> covered(w, 0), ball(w), frontier(w), next(w);
+    size_t ncover = 0, i = 0;
+    long long needed = 0;
+
+    while (ncover < m.n) {
+        if (budget != NULL && needed % BUDGET_POLL == 0 && budget->expired())
+            return -1;
+        node c = centers[i++];
+        while (covered[c / 64] >> (c % 64) & 1)
+            c = centers[i++];
+
+        fill(ball.begin(), ball.end(), 0);
+        ball[c / 64] = (uint64_t)1 << (c % 64);
+        frontier = ball;
+        for (diameter r=1; r<d; r++) {
+            fill(next.begin(), next.end(), 0);
+            for (size_t k=0; k<w; k++)
+                for (uint64_t b=frontier[k]; b != 0; b &= b - 1)
+                    or_words(next.data(), m.row(k * 64 + __builtin_ctzll(b)), w);
+            bool grows = false;
+            for (size_t k=0; k<w; k++) {
+                frontier[k] = next[k] & ~ball[k];
+                ball[k] |= frontier[k];
+                grows |= frontier[k] != 0;
+            }
+            if (!grows)
+                break;
+        }
+        for (size_t k=0; k<w; k++) {
+            ncover += __builtin_popcountll(ball[k] & ~covered[k]);
+            covered[k] |= ball[k];
+        }
+        needed++;
+    }
+    return needed;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+bool comparesecond(pair <T,size_t> a, pair <T,size_t> b) {
     return a.second > b.second;
 }
 
 //------------------------------------------------------------------------------
 // Given a (weighted) graph g, computes needed[i] as the number of tiles 
-// of diameter i needed for covering the graph
+// of diameter i needed for covering the graph. If "budget" is exhausted, 
+// returns the diameters computed so far.
 //------------------------------------------------------------------------------
-vector <int> computeNeeded(Graph *g) {  
+template <class G>
+vector <long long> computeNeeded(G *g, Budget* budget = NULL) {  
 
+    typedef typename G::node_t node;
 
-    vector <int> v(1, g->size());     // v[0] = g->size();
+    vector <long long> v(1, g->size());     // v[0] = g->size();
 
-    int comp = components(g);
+    long long comp = components(g);
     if(verbose)
         cerr << "\tComponents: " << comp << endl;
 
-    vector <pair <int,int> > aux(g->size());
-    for (int i=0; i<g->size(); i++) {
+    vector <pair <node,size_t> > aux(g->size());
+    size_t edges = 0;
+    for (node i=0; i<g->size(); i++) {
         aux[i].first = i;
         //aux[i].second = (int)g->arity(i);
-        aux[i].second = (int)g->nNeighs(i);
+        aux[i].second = g->nNeighs(i);
+        edges += aux[i].second;
     }
-    sort(aux.begin(), aux.end(), comparesecond);
+    sort(aux.begin(), aux.end(), comparesecond<node>);
 
-    vector <int> centers(g->size());
-    for (int i=0; i<g->size(); i++) 
+    vector <node> centers(g->size());
+    for (node i=0; i<g->size(); i++) 
         centers[i] = aux[i].first;
     //shuffle(centers);
 
+    BitMatrix* m = NULL;
+    if (g->size() <= BITSET_NODES && edges >= BITSET_DEGREE * (size_t)g->size())
+        m = new BitMatrix(g);
+
     for (int d=1; d<=maxx && v[d-1]>comp; d++) {
-        v.push_back(needed(g,(diameter)d,centers)); // v[d] = needed(g,d,centers);
+        long long n = m != NULL ? needed_bitset(*m, (diameter)d, centers, budget)
+                                : needed(g, (diameter)d, centers, budget);
+        if (n < 0)
+            break;
+        v.push_back(n);     // v[d] = needed(g,d,centers);
         if(verbose)
             cerr << "\t" << d << " => " << v[d] <<endl;
     }
+    delete m;
     return v;
 }
 
+//------------------------------------------------------------------------------
+// Box covering curve estimated from balls grown around random centers
+// (cluster growing). Covering with boxes of diameter d puts every node x in
+// a box of about the size M(x) of its ball of radius d-1, so it needs about
+// the sum of 1/M(x) boxes: the size of the graph times the mean of 1/M(c)
+// over the sampled centers c.
+//------------------------------------------------------------------------------
+struct BoxEstimate {
+    vector<double> needed;              // needed[d], as in computeNeeded
+    vector<double> low, high;           // 95% confidence interval of needed[d]
+    vector<vector<double> > inverse;    // inverse[s][d] = 1/M(c) of the center of sample s
+};
+
+//------------------------------------------------------------------------------
+// Given a graph g, estimates needed[d] from "samples" centers, chosen by
+// generators seeded from "seed" so that the estimate does not depend on the
+// number of threads. Balls grow up to radius maxx-1, or until they cover
+// their component, and the curve ends, as in computeNeeded, at the first
+// diameter that needs as many boxes as components. If "budget" is exhausted,
+// uses the samples completed.
+//------------------------------------------------------------------------------
+template <class G>
+BoxEstimate estimateNeeded(G *g, int samples, uint64_t seed, Budget* budget = NULL) {
+
+    typedef typename G::node_t node;
+    size_t n = g->size();
+    BoxEstimate e;
+    vector<vector<double> > inverse(samples);
+    vector<long long> label;
+    vector<size_t> sizes = label_components(g, label);
+
+    if (n > 0) {
+        #pragma omp parallel
+        {
+            vector<diameter> dist(n, -1);   // Distance from the center, or -1
+            vector<node> ball;              // Nodes of the ball, by distance
+            long long visits = 0;
+
+            #pragma omp for schedule(dynamic,1)
+            for (int s=0; s<samples; s++) {
+                Random rng(seed + 0x9E3779B97F4A7C15ULL * s);
+                node c = rng.next() % n;
+                bool stopped = false;
+                ball.assign(1, c);
+                dist[c] = 0;
+                inverse[s].assign(2, 1.0);      // Diameters 0 and 1 are the node itself
+                size_t head = 0;
+                for (diameter r=1; r<maxx && !stopped; r++) {
+                    size_t last = ball.size();
+                    for (; head<last && !stopped; head++) {
+                        for (typename G::NeighIter it=g->begin(ball[head]); it != g->end(ball[head]); it++)
+                            if (dist[it->dest] < 0) {
+                                dist[it->dest] = r;
+                                ball.push_back(it->dest);
+                            }
+                        stopped = budget != NULL && ++visits % BUDGET_POLL == 0 && budget->expired();
+                    }
+                    if (ball.size() == last)
+                        break;
+                    inverse[s].push_back(1.0 / ball.size());
+                    if (ball.size() == sizes[label[c]])
+                        break;
+                }
+                for (size_t i=0; i<ball.size(); i++)
+                    dist[ball[i]] = -1;
+                if (stopped)
+                    inverse[s].clear();
+            }
+        }
+    }
+
+    // Completed samples, padded with the ball of their whole component
+    size_t len = 1;
+    for (int s=0; s<samples; s++) {
+        if (!inverse[s].empty()) {
+            len = max(len, inverse[s].size());
+            e.inverse.push_back(vector<double>());
+            e.inverse.back().swap(inverse[s]);
+        }
+    }
+    for (size_t s=0; s<e.inverse.size(); s++)
+        e.inverse[s].resize(len, e.inverse[s].back());
+
+    size_t k = e.inverse.size();
+    e.needed.assign(1, n);
+    e.low.assign(1, n);
+    e.high.assign(1, n);
+    for (size_t d=1; d<len && k>0; d++) {
+        double sum = 0, sum2 = 0;
+        for (size_t s=0; s<k; s++) {
+            sum += e.inverse[s][d];
+            sum2 += e.inverse[s][d] * e.inverse[s][d];
+        }
+        double mean = sum / k;
+        double err = k > 1 ? 1.96 * sqrt(max(0.0, sum2 / k - mean * mean) / (k - 1)) : 0;
+        e.needed.push_back(n * mean);
+        e.low.push_back(n * max(mean - err, 0.0));
+        e.high.push_back(n * (mean + err));
+        if(verbose)
+            cerr << "\t" << d << " => " << e.needed[d] << " [" << e.low[d] << ", " << e.high[d] << "]" << endl;
+        if (e.needed[d] <= sizes.size() + 0.5)
+            break;
+    }
+    return e;
+}
+
 #endif
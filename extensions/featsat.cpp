@@ -12,6 +12,9 @@
 #include <string.h>
 #include <getopt.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /*
 Graph Features Computation for SAT instances.
@@ -42,15 +45,11 @@ Contact: jgiraldez@iiia.csic.es
 */
 // Third party libraries
 #include <vector>
-#ifndef VECTOR
-#include "graph_set.h"
-#else
-#include "graph_vector.h"
-#endif
-#include "tools.h"
-#include "powerlaw.h"
-#include "dimension.h"
-#include "community.h"
+#include "satfeatures.h"
+#include "pyarray.h"
+#include "incremental.h"
+#include "reorder.h"
+#include "backdoors.h"
 
 // Added for Windows
 #ifdef _WIN32
@@ -62,654 +61,1959 @@ Contact: jgiraldez@iiia.csic.es
 using namespace std;
 
 
-// Global variables and Flags
+// C Extension Info Section
+
+static PyObject* FeatSatError;
 
 
-// Extra info. Debugging purposes
-bool verbose = false;
+//------------------------------------------------------------------------------
+// Formula argument of the feature functions: a file name, DIMACS text in a 
+// bytes-like object, a pair (literals, offsets) of integer arrays, or a 
+// sequence of clauses (sequences of DIMACS literals). Arrays and text are
+// read in place; their buffers are released with the FormulaInput.
+//------------------------------------------------------------------------------
+struct FormulaInput {
+    FormulaSource source;
+    PyObject* path;                 // File name encoded
+    Py_buffer views[2];
+    int nviews;
+    vector<int> lits;               // Sequences of clauses, flattened
+    vector<long long> offsets;
+
+    FormulaInput() : path(NULL), nviews(0) {}
+
+    ~FormulaInput() {
+        for (int i=0; i<nviews; i++)
+            PyBuffer_Release(&views[i]);
+        Py_XDECREF(path);
+    }
+};
 
-// Execution tunning variables 
-int minx = 0;
-int maxx = 15;
-int maxx2 = 6;
-int maxclause = 400;
-int maxxmin = 10;
-double precision = 0.000001;
+// Checks the clauses lits[offsets[i]..offsets[i+1]-1] and finds the greatest variable
+template <class L, class O>
+static int check_clauses(const L* lits, Py_ssize_t nlits, const O* offsets, Py_ssize_t m, long long &vars) {
 
-// Scale Free (Vars)
-char *var = NULL;
-char *alphavar = NULL;
-char *varint = NULL;
-char *varplot = NULL;
+    vars = 0;
+    for (Py_ssize_t i=0; i<m; i++) {
+        if (offsets[i] < 0 || offsets[i] > offsets[i+1] || offsets[i+1] > nlits) {
+            PyErr_Format(PyExc_ValueError, "Unvalid offsets of clause %zd", i);
+            return -1;
+        }
+    }
+    for (Py_ssize_t i=(m > 0 ? offsets[0] : 0); i<(m > 0 ? offsets[m] : 0); i++) {
+        long long v = lits[i] < 0 ? -(long long)lits[i] : (long long)lits[i];
+        if (v == 0 || v > INT_MAX) {
+            PyErr_Format(PyExc_ValueError, "Unvalid literal %lld", (long long)lits[i]);
+            return -1;
+        }
+        if (v > vars) vars = v;
+    }
+    return 0;
+}
 
-// Scale Free (Clauses)
-char *clau = NULL;
-char *alphaclau = NULL;
-char *clauint = NULL;
-char *clauplot = NULL;
+template <class L>
+static int check_clauses(const L* lits, Py_ssize_t nlits, Py_buffer &offsets, long long &vars) {
+    Py_ssize_t m = offsets.len / offsets.itemsize - 1;
+    if (offsets.itemsize == 4)
+        return check_clauses(lits, nlits, (const int32_t*)offsets.buf, m, vars);
+    return check_clauses(lits, nlits, (const int64_t*)offsets.buf, m, vars);
+}
 
-// Self Similarity (VIG)
-char *dim = NULL;
-char *resdim = NULL;
-char *dimplot = NULL;
+// Converter for PyArg_ParseTuple ("O&") filling a FormulaInput
+static int formula_converter(PyObject* obj, FormulaInput* in) {
 
-// Self Similarity (CVIG)
-char *dib = NULL;
-char *resdib =  NULL;
-char *dibplot = NULL;
+    if (PyUnicode_Check(obj) || PyObject_HasAttrString(obj, "__fspath__")) {
+        if (!PyUnicode_FSConverter(obj, &in->path))
+            return 0;
+        in->source = FormulaSource(PyBytes_AS_STRING(in->path));
+        return 1;
+    }
 
-// Plotting Variables (mantained, not used)
-char *mod = NULL;
-char *mob = NULL;
-char *fout = NULL;
-char *modules = NULL;
+    if (PyBytes_Check(obj) || PyByteArray_Check(obj) || PyMemoryView_Check(obj)) {
+        Py_buffer &text = in->views[0];
+        if (PyObject_GetBuffer(obj, &text, PyBUF_C_CONTIGUOUS) < 0)
+            return 0;
+        in->nviews = 1;
+        in->source = FormulaSource::dimacs((const char*)text.buf, text.len);
+        return 1;
+    }
 
+    if (PyTuple_Check(obj) && PyTuple_GET_SIZE(obj) == 2 && 
+        PyObject_CheckBuffer(PyTuple_GET_ITEM(obj, 0)) && PyObject_CheckBuffer(PyTuple_GET_ITEM(obj, 1))) {
+        bool sign[2];
+        for (int i=0; i<2; i++) {
+            if (Buffer_Integers(PyTuple_GET_ITEM(obj, i), &in->views[i], sign[i]) < 0)
+                return 0;
+            in->nviews++;
+        }
+        Py_buffer &lits = in->views[0];
+        Py_buffer &offsets = in->views[1];
+        if (!sign[0] || (lits.itemsize != 4 && lits.itemsize != 8) ||
+            (offsets.itemsize != 4 && offsets.itemsize != 8) || offsets.len == 0) {
+            PyErr_SetString(PyExc_TypeError, "literals must be 32 or 64-bit signed integers, "
+                            "and offsets 32 or 64-bit integers, one more than clauses");
+            return 0;
+        }
+        Py_ssize_t nlits = lits.len / lits.itemsize;
+        long long vars;
+        int ok = lits.itemsize == 4 ? check_clauses((const int32_t*)lits.buf, nlits, offsets, vars)
+                                    : check_clauses((const int64_t*)lits.buf, nlits, offsets, vars);
+        if (ok < 0)
+            return 0;
+        in->source = FormulaSource::clauses(lits.buf, lits.itemsize, offsets.buf, offsets.itemsize,
+                                            vars, offsets.len / offsets.itemsize - 1);
+        return 1;
+    }
 
-double modularity_vig(char* fin, int max_clauses) {
+    PyObject* seq = PySequence_Fast(obj, "expected a file name, DIMACS bytes, (literals, offsets) or a list of clauses");
+    if (seq == NULL)
+        return 0;
+    Py_ssize_t m = PySequence_Fast_GET_SIZE(seq);
+    in->offsets.push_back(0);
+    for (Py_ssize_t i=0; i<m; i++) {
+        PyObject* cl = PySequence_Fast(PySequence_Fast_GET_ITEM(seq, i), "clauses must be sequences of literals");
+        if (cl == NULL) {
+            Py_DECREF(seq);
+            return 0;
+        }
+        for (Py_ssize_t j=0; j<PySequence_Fast_GET_SIZE(cl); j++) {
+            long lit = PyLong_AsLong(PySequence_Fast_GET_ITEM(cl, j));
+            if ((lit == -1 && PyErr_Occurred()) || lit < INT_MIN || lit > INT_MAX) {
+                if (!PyErr_Occurred())
+                    PyErr_Format(PyExc_ValueError, "Unvalid literal %ld in clause %zd", lit, i);
+                Py_DECREF(cl);
+                Py_DECREF(seq);
+                return 0;
+            }
+            in->lits.push_back(lit);
+        }
+        in->offsets.push_back(in->lits.size());
+        Py_DECREF(cl);
+    }
+    Py_DECREF(seq);
+    long long vars;
+    if (check_clauses(in->lits.data(), in->lits.size(), in->offsets.data(), m, vars) < 0)
+        return 0;
+    in->source = FormulaSource::clauses(in->lits.data(), sizeof(int), in->offsets.data(), 
+                                        sizeof(long long), vars, m);
+    return 1;
+}
 
-    clock_t t_ini, t_fin;
-    double secsGraphs;
-    double secsMod;
 
-    Graph* vig = NULL;
+// Budget Object
 
-    // Build Graph
-    t_ini = clock();
-    vig = readVIG(fin, max_clauses);
-    t_fin = clock();
-    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+typedef struct {
+    PyObject_HEAD
+    Budget* budget;
+} BudgetObject;
 
-    Community c(vig);
-    double modularity=-1;
+static PyTypeObject BudgetType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "featsat.Budget",
+};
 
-    if(verbose) {
-        cerr << "Computing COMMUNITY Structure (VIG)" << endl;
-        std::cout << "max_clauses: " << max_clauses << std::endl;
-    }
+static PyObject* Budget_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
 
-    // Computation
-    t_ini = clock();
-    modularity = c.compute_modularity_GFA(precision);
-    c.compute_communities();
-    t_fin = clock();
-    secsMod = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    static const char* kwlist[] = {"timeout", NULL};
+    PyObject* timeout = Py_None;
 
-    if (verbose) {
-        cerr << "modularity = " << modularity << endl;
-        cerr << "communities = " << (int)c.ncomm << endl;
-        cerr << "largest size = " << (double)c.Comm[c.Comm_order[0].first].size()/vig->size() << endl;
-        cerr << "iterations = " << c.iterations << endl;
-        cerr << "grap loading = " << secsGraphs << endl;
-        cerr << "partition and modu time = " << secsMod << endl;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", (char**)kwlist, &timeout))
+        return NULL;
+    double seconds = -1;
+    if (timeout != Py_None) {
+        seconds = PyFloat_AsDouble(timeout);
+        if (seconds == -1 && PyErr_Occurred())
+            return NULL;
+        if (seconds < 0) {
+            PyErr_SetString(PyExc_ValueError, "timeout must not be negative");
+            return NULL;
+        }
     }
+    BudgetObject* self = (BudgetObject*)type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+    self->budget = new Budget(seconds);
+    return (PyObject*)self;
+}
 
-    return modularity;
+static void Budget_dealloc(BudgetObject* self) {
+    delete self->budget;
+    Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
+static PyObject* Budget_cancel(BudgetObject* self, PyObject* Py_UNUSED(args)) {
+    self->budget->cancel();
+    Py_RETURN_NONE;
+}
 
-double modularity_cvig(char* fin, int max_clauses) {
+static PyObject* Budget_get_truncated(BudgetObject* self, void* closure) {
+    return PyBool_FromLong(self->budget->truncated);
+}
 
-    // Time variables
-    clock_t t_ini, t_fin;
-    double secsGraphs;
-    double secsModBip;
+static PyObject* Budget_get_cancelled(BudgetObject* self, void* closure) {
+    return PyBool_FromLong(self->budget->cancelled);
+}
 
-    Graph* cvig = NULL;
-    
-    // Build Graph
-    t_ini = clock();
-    cvig = readCVIG(fin, max_clauses);
-    t_fin = clock();
-    
-    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+static PyMethodDef Budget_methods[] = {
+    {
+        "cancel",
+        (PyCFunction)Budget_cancel,
+        METH_NOARGS,
+        "Stops the computations using the budget, e.g. from a signal handler.\n"
+        "They return the results found so far, as when the timeout expires.\n\n",
+    },
+    {NULL, NULL, 0, NULL}  // sentinel
+};
 
-    // Community
-    Community c_bip(cvig);
-    double modularity_bip = -1;
+static PyGetSetDef Budget_getset[] = {
+    {(char*)"truncated", (getter)Budget_get_truncated, NULL,
+     (char*)"Whether some computation was stopped by the budget.", NULL},
+    {(char*)"cancelled", (getter)Budget_get_cancelled, NULL,
+     (char*)"Whether cancel() was called.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}  // sentinel
+};
 
-    // Compute
-    t_ini = clock();    
-    modularity_bip = c_bip.compute_modularity_GFA(precision);
-    c_bip.compute_communities();
-    t_fin = clock();
+int Budget_Ready() {
+    BudgetType.tp_basicsize = sizeof(BudgetObject);
+    BudgetType.tp_dealloc = (destructor)Budget_dealloc;
+    BudgetType.tp_flags = Py_TPFLAGS_DEFAULT;
+    BudgetType.tp_doc = "Budget(timeout=None)\n\n"
+        "Time limit, in seconds from its creation, and cancellation token of\n"
+        "the feature computations given it. They stop cooperatively and\n"
+        "return the best results found so far, setting truncated.";
+    BudgetType.tp_new = Budget_new;
+    BudgetType.tp_methods = Budget_methods;
+    BudgetType.tp_getset = Budget_getset;
+    return PyType_Ready(&BudgetType);
+}
 
-    secsModBip = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+// Polled by the kernels from the Python thread, so that Ctrl-C stops them
+static bool check_signals() {
+    return PyErr_CheckSignals() < 0;
+}
 
-    if (verbose) {
-        cerr << "modularity = " << modularity_bip << endl;
-        cerr << "communities = " << (int)c_bip.ncomm << endl;
-        cerr << "largest size = " << (double)c_bip.Comm[c_bip.Comm_order[0].first].size()/cvig->size() << endl;
-        cerr << "iterations = " << c_bip.iterations << endl;
-        cerr << "grap loading = " << secsGraphs << endl;
-        cerr << "partition and modu time = " << secsModBip << endl;
+//------------------------------------------------------------------------------
+// Budget argument of the feature functions: a featsat.Budget, or none. The
+// kernels check signals anyway; if a handler raises, they stop and the
+// exception is set (interrupted() is true).
+//------------------------------------------------------------------------------
+struct BudgetInput {
+    Budget own;
+    Budget* budget;
+
+    BudgetInput() : budget(&own) {
+        own.attach(check_signals);
     }
-        
-    return modularity_bip;
-}
 
-double scale_free_var(char* fin, int max_clauses){
+    bool interrupted() { return budget->interrupted; }
+};
 
-    // Time variables
-    clock_t t_ini, t_fin;
-    double secsAlphaVar;
-    
-    // Scale Free (Variables)
-    double alphavarexp = -1;
-  
-    if (verbose) {
-        cerr << "Computing SCALE-FREE Structure (Variables)" << endl;
-        cerr << "max_clauses: " << max_clauses << endl;
-    }
-
-    // Compute
-    t_ini = clock();
-    vector<pair <int,int> > a = arityVar(fin);
-    alphavarexp = mostlikely(a, maxxmin, alphavar, varint, varplot, true);
-    t_fin = clock();
-    
-    secsAlphaVar = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
-    
-    if (verbose) {
-        cerr << "alpha var exp = " << alphavarexp << endl;
-        cerr << "time = " << secsAlphaVar << endl;
+// Converter for PyArg_ParseTuple ("O&") filling a BudgetInput
+static int budget_converter(PyObject* obj, BudgetInput* in) {
+    if (obj == Py_None)
+        return 1;
+    if (!PyObject_TypeCheck(obj, &BudgetType)) {
+        PyErr_SetString(PyExc_TypeError, "budget must be a featsat.Budget or None");
+        return 0;
     }
+    in->budget = ((BudgetObject*)obj)->budget;
+    in->budget->attach(check_signals);
+    return 1;
+}
+
 
-    return alphavarexp;
+// Reads a CommunityMethod
+static int parse_method(const char* method) {
+    if (method == NULL || strcmp(method, "louvain") == 0)
+        return METHOD_LOUVAIN;
+    if (strcmp(method, "leiden") == 0)
+        return METHOD_LEIDEN;
+    if (strcmp(method, "louvain-queue") == 0)
+        return METHOD_LOUVAIN_QUEUE;
+    PyErr_Format(PyExc_ValueError, "Argument method=%s not valid. Choose \"louvain\", \"louvain-queue\" or \"leiden\"", method);
+    return -1;
 }
 
-double scale_free_clause(char* fin, int max_clauses){
 
-    // Time variables
-    clock_t t_ini, t_fin;
-    double secsAlphaClau;
-    
-    // Scale Free (Clauses)
-    double alphaclauexp = -1;
+//------------------------------------------------------------------------------
+// Bindings reading formulas. The readers throw a FormulaError on invalid
+// input, raised as ValueError, or as OSError if a file cannot be read or
+// written.
+//------------------------------------------------------------------------------
+static PyObject* raise_formula_error(const FormulaError &e) {
+    PyErr_SetString(e.system ? PyExc_OSError : PyExc_ValueError, e.what());
+    return NULL;
+}
 
-    if (verbose) {
-        cerr << "Computing SCALE-FREE Structure (Clauses)" << endl;
+template <PyObject* (*F)(PyObject*, PyObject*)>
+static PyObject* reading(PyObject* self, PyObject* args) {
+    try {
+        return F(self, args);
+    } catch (const FormulaError &e) {
+        return raise_formula_error(e);
     }
+}
 
-    // Compute
-    t_ini = clock();
-    vector<pair <int,int> > b = arityClause(fin);
-    alphaclauexp = mostlikely(b, maxxmin, alphaclau, clauint, clauplot, false);
-    t_fin = clock();
-    
-    secsAlphaClau = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
-    
-    if (verbose) {
-        cerr << "alpha clause exp = " << alphaclauexp << endl;
-        cerr << "time = " << secsAlphaClau << endl;
+template <PyObject* (*F)(PyTypeObject*, PyObject*, PyObject*)>
+static PyObject* reading_class(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+    try {
+        return F(type, args, kwds);
+    } catch (const FormulaError &e) {
+        return raise_formula_error(e);
     }
-
-    return alphaclauexp;
 }
 
-double self_similar_vig(char* fin, int max_clauses){
 
-    // Time management
-    clock_t t_ini, t_fin;
-    double secsGraphs;
-    double secsDim;
-    
-    // Graphs
-    Graph* vig = NULL;
+// Compute All
+static PyObject* featsat_compute_all(PyObject* self, PyObject* args) {
 
-    // Build Graph
-    t_ini = clock();
-    vig = readVIG(fin, max_clauses);
-    t_fin = clock();
-    
-    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    FormulaInput formula;
+    int max_clauses;
 
-    // Self Similarity variables
-    vector<int> needed;
-    vector <pair <double,double> > v1;
-    vector <pair <double,double> > v2;
-    
-    pair <double,double> polreg = make_pair(-1,-1);
-    pair <double,double> expreg = make_pair(-1,-1);
+    if (!PyArg_ParseTuple(args, "O&i", formula_converter, &formula, &max_clauses)) {
+        return NULL;
+    }
     
-    if(verbose){
-        cerr << "Computing SELF-SIMILAR Structure (VIG)" << endl;
-        cerr << "max_clauses: " << max_clauses << endl;
-    }
-
-    v1.clear(); 
-    v2.clear();
-   
-    // Compute
-    t_ini = clock();    
-    needed = computeNeeded(vig);
-    for(int i=1; i<needed.size(); i++){
-        if(i>=minx && i<=maxx2){
-            v1.push_back(pair<double,double>(log(i), log(needed[i])));
-            v2.push_back(pair<double,double>((double)i, log(needed[i])));   
-        }
+    double ans = compute_all(formula.source, max_clauses);
+    return Py_BuildValue("d", ans);
+}
+
+// Features selected (as in sia-feat -f) of a formula read once, as a dict
+static PyObject* featsat_features(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    const char* features = "all";
+
+    if (!PyArg_ParseTuple(args, "O&i|s", formula_converter, &formula, &max_clauses, &features)) {
+        return NULL;
+    }
+    string list(features);
+    int mask = parse_features(&list[0]);
+    if (mask <= 0) {
+        PyErr_Format(PyExc_ValueError, "Argument features=%s not valid", features);
+        return NULL;
     }
-    polreg = regresion(v1);
-    expreg = regresion(v2);
-    t_fin = clock();
 
-    secsDim = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    Features f = compute_features(formula.source, max_clauses, mask);
+
+    PyObject* ans;
+    if (mask & FEAT_BASE) {
+        BaseFeatures &b = f.base;
+        ans = Py_BuildValue("{s:L,s:L,s:d,s:d,s:d,s:L,s:L,s:d,s:d,s:d,s:d,s:d,s:d,s:d,s:d,s:d,s:d,"
+                            "s:d,s:d,s:L,s:L,s:d,s:d}",
+            "vars", b.vars, "clauses", b.clauses, "ratio", b.ratio,
+            "size_mean", b.size_mean, "size_std", b.size_std,
+            "size_min", b.size_min, "size_max", b.size_max,
+            "unit", b.unit, "binary", b.binary, "ternary", b.ternary,
+            "horn", b.horn, "dual_horn", b.dual_horn, "positive", b.positive,
+            "balance_clause_mean", b.balance_clause_mean, "balance_clause_std", b.balance_clause_std,
+            "balance_var_mean", b.balance_var_mean, "balance_var_std", b.balance_var_std,
+            "degree_mean", b.degree_mean, "degree_std", b.degree_std,
+            "degree_min", b.degree_min, "degree_max", b.degree_max,
+            "horny_mean", b.horny_mean, "horny_std", b.horny_std);
+    } else {
+        ans = PyDict_New();
+    }
+    if (ans == NULL)
+        return NULL;
 
-    if (verbose) {
-        cerr << "dimension = " << -polreg.first << endl;
-        cerr << "decay = " << -expreg.first << endl;
+    // The other features selected, by their FEAT_* flag
+    const char* names[] = {"alpha_var", "alpha_clause", "dim", "dim_bip", "modularity", "modularity_bip"};
+    double values[] = {f.alphavarexp, f.alphaclauexp, f.dim, f.dimbip, f.modularity, f.modularity_bip};
+    vector<pair<const char*,PyObject*> > items;
+    for (int i=0; i<6; i++)
+        if (mask & (1 << i))
+            items.push_back(make_pair(names[i], PyFloat_FromDouble(values[i])));
+    if (mask & FEAT_MOD_VIG)
+        items.push_back(make_pair("communities", PyLong_FromLongLong(f.ncomm)));
+    if (mask & FEAT_MOD_CVIG)
+        items.push_back(make_pair("communities_bip", PyLong_FromLongLong(f.ncomm_bip)));
+    items.push_back(make_pair("secs", PyFloat_FromDouble(f.secsTotal)));
+    items.push_back(make_pair("truncated", PyBool_FromLong(f.truncated)));
+    bool ok = true;
+    for (size_t i=0; i<items.size(); i++) {
+        if (ok && (items[i].second == NULL || PyDict_SetItemString(ans, items[i].first, items[i].second) < 0))
+            ok = false;
+        Py_XDECREF(items[i].second);
     }
-    
-    return -polreg.first;
+    if (!ok) {
+        Py_DECREF(ans);
+        return NULL;
+    }
+    return ans;
 }
 
-double self_similar_cvig(char* fin, int max_clauses){
 
-    // Time management
-    clock_t t_ini, t_fin;
-    double secsGraphs;
-    double secsDib;
-    
-    Graph* cvig = NULL;    
-    
-    // Build Graph
-    t_ini = clock();
-    cvig = readCVIG(fin, max_clauses);
-    t_fin = clock();
-    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
-    
-    // Self similarity
-    vector<int> needed;
-    vector <pair <double,double> > v1;
-    vector <pair <double,double> > v2;
-    
-    pair <double,double> polregB = make_pair(-1,-1);
-    pair <double,double> expregB = make_pair(-1,-1);
-       
-    if(verbose) {
-        cerr << "Computing SELF-SIMILAR Structure (CVIG)" << endl;
-        cerr << "max_clauses: " << max_clauses << std::endl;
+// Modularity Interfaces
+static PyObject* featsat_modularity_vig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    const char* method_str = NULL;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|sO&", formula_converter, &formula, &max_clauses, &method_str,
+                          budget_converter, &budget)) {
+        return NULL;
     }
+    int method = parse_method(method_str);
+    if (method < 0)
+        return NULL;
 
-    v1.clear(); 
-    v2.clear();
-    
-    t_ini = clock();        
-    needed = computeNeeded(cvig);
+    double ans = modularity_vig(formula.source, max_clauses, method, budget.budget);
+    if (budget.interrupted())
+        return NULL;
+    return Py_BuildValue("d", ans);
+}
 
-    for(int i=1; i<needed.size(); i++){
-        if(i>=minx && i<=maxx2){
-            v1.push_back(pair<double,double>(log(i), log(needed[i])));
-            v2.push_back(pair<double,double>((double)i, log(needed[i])));   
-        }
+static PyObject* featsat_modularity_cvig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    const char* method_str = NULL;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|sO&", formula_converter, &formula, &max_clauses, &method_str,
+                          budget_converter, &budget)) {
+        return NULL;
     }
+    int method = parse_method(method_str);
+    if (method < 0)
+        return NULL;
     
-    polregB = regresion(v1);
-    expregB = regresion(v2);
-    
-    t_fin = clock();
-    secsDib = (double)(t_fin - t_ini) / CLOCKS_PER_SEC; 
-    
-    if (verbose) {
-        cerr << "dimension bipartite = " << -polregB.first << endl;
-        cerr << "decay bipartite = " << -expregB.first << endl;
+    double ans = modularity_cvig(formula.source, max_clauses, method, budget.budget);
+    if (budget.interrupted())
+        return NULL;
+    return Py_BuildValue("d", ans);
+}
+
+static PyObject* featsat_modularity_hypergraph(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|O&", formula_converter, &formula, &max_clauses,
+                          budget_converter, &budget)) {
+        return NULL;
     }
 
-    return -polregB.first;
+    double ans = modularity_hypergraph(formula.source, max_clauses, budget.budget);
+    if (budget.interrupted())
+        return NULL;
+    return Py_BuildValue("d", ans);
 }
 
-// Test purposes
-double compute_all(char* fin, int max_clauses) {
 
-	clock_t t_ini, t_fin;
-    double secsGraphs, secsTotal;
-	double secsAlphaVar, secsAlphaClau;
-	double secsDim, secsDib;
-	double secsMod, secsModBip;
+// Scale Free Interfaces
+static PyObject* featsat_scale_free_var(PyObject* self, PyObject* args) {
 
-    t_ini = clock();
-    
-    Graph* vig = NULL;
-    Graph* cvig = NULL;
+    FormulaInput formula;
+    int max_clauses;
 
-    // Maxclauses
-    cout << "max_clause: " << max_clauses << endl;
+    if (!PyArg_ParseTuple(args, "O&i", formula_converter, &formula, &max_clauses)) {
+        return NULL;
+    }
     
-    t_ini = clock();
-    pair<Graph*,Graph*> p = readFormula(fin, max_clauses);
-    t_fin = clock();
-    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    double ans = scale_free_var(formula.source, max_clauses);
+    return Py_BuildValue("d", ans);
+}
 
-    // Graphs
-    vig = p.first;
-    cvig = p.second;
+static PyObject* featsat_scale_free_clause(PyObject* self, PyObject* args) {
 
-    
-    // Scale Free
-    double alphavarexp = -1;
-    double alphaclauexp = -1;
-
-    // Self similarity
-    vector<int> needed;
-    vector <pair <double,double> > v1;
-    vector <pair <double,double> > v2;
-    pair <double,double> polreg  = make_pair(-1,-1);
-    pair <double,double> expreg  = make_pair(-1,-1);
-    pair <double,double> polregB = make_pair(-1,-1);
-    pair <double,double> expregB = make_pair(-1,-1);
-
-    // Modularity
-    Community c(vig);
-    Community c_bip(cvig);
-    double modularity=-1;
-    double modularity_bip=-1;
-    
-    //**************************************************************************
-    // Scale Free (Variables)
-    //**************************************************************************
+    FormulaInput formula;
+    int max_clauses;
 
-    if(verbose) {
-        cerr << "Computing SCALE-FREE Structure (Variables)" << endl;
-        cerr << "max_clauses: " << max_clauses << std::endl;
+    if (!PyArg_ParseTuple(args, "O&i", formula_converter, &formula, &max_clauses)) {
+        return NULL;
     }
-
-    t_ini = clock();
-    vector<pair <int,int> > a = arityVar(fin);
-    alphavarexp = mostlikely(a, maxxmin, alphavar, varint, varplot, true);
-    t_fin = clock();
-    secsAlphaVar = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
-    
-    //**************************************************************************
-    // Scale Free (Clauses)
-    //**************************************************************************
-   
-    if(verbose) {
-       cerr << "Computing SCALE-FREE Structure (Clauses)" << endl;
-       cerr << "max_clauses: " << max_clauses << endl;
-    }
-
-    t_ini = clock();
-    vector<pair <int,int> > b = arityClause(fin);
-    alphaclauexp = mostlikely(b, maxxmin, alphaclau, clauint, clauplot, false);
-    t_fin = clock();
-    secsAlphaClau = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
     
-    //**************************************************************************
-    // Computing SELF-SIMILAR Structure (VIG)
-	//**************************************************************************          
-    
-    if(verbose){
-        cerr << "Computing SELF-SIMILAR Structure (VIG)" << endl;
-        cerr << "max_clauses: " << max_clauses << endl;
-    }
+    double ans = scale_free_clause(formula.source, max_clauses);
+    return Py_BuildValue("d", ans);
+}
 
-    v1.clear(); v2.clear();
-    
-    t_ini = clock();    
-    needed = computeNeeded(vig);
-    
-    for(int i=1; i<needed.size(); i++){
-        if(i>=minx && i<=maxx2){
-            v1.push_back(pair<double,double>(log(i), log(needed[i])));
-            v2.push_back(pair<double,double>((double)i, log(needed[i])));   
-        }
+// Self Similar Interfaces
+static PyObject* featsat_self_similar_vig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|O&", formula_converter, &formula, &max_clauses,
+                          budget_converter, &budget)) {
+        return NULL;
     }
     
-    polreg = regresion(v1);
-    expreg = regresion(v2);
-    
-    t_fin = clock();
-    secsDim = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    double ans = self_similar_vig(formula.source, max_clauses, budget.budget);
+    if (budget.interrupted())
+        return NULL;
+    return Py_BuildValue("d", ans);
+}
+
+static PyObject* featsat_self_similar_cvig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    BudgetInput budget;
 
-    if(verbose){
-        cerr << "dimension = " << -polreg.first << endl;
-        cerr << "decay = " << -expreg.first << endl;
+    if (!PyArg_ParseTuple(args, "O&i|O&", formula_converter, &formula, &max_clauses,
+                          budget_converter, &budget)) {
+        return NULL;
     }
     
-	//**************************************************************************
-    // Computing SELF-SIMILAR Structure (CVIG)
-    //**************************************************************************
-    
-	if(verbose){
-        cerr << "Computing SELF-SIMILAR Structure (CVIG)" << endl;
-        cerr << "max_clauses: " << max_clauses << endl;
-    }
+    double ans = self_similar_cvig(formula.source, max_clauses, budget.budget);
+    if (budget.interrupted())
+        return NULL;
+    return Py_BuildValue("d", ans);
+}
 
-    v1.clear(); v2.clear();
-    
-    t_ini = clock();        
-    needed = computeNeeded(cvig);
+// Community Structure Interfaces
+
+// Packs the partition and the communities of c as a dict of featsat.Array.
+// Community members are numbered from 1, as the variables of the formula.
+template <class G>
+static PyObject* community_dict(Community<G> &c, double modularity, bool truncated) {
+
+    typedef typename G::node_t node;
+    vector<node> order, members;
+    vector<long long> sizes, offsets(1, 0);
+    for (node i=0; i<c.ncomm; i++) {
+        vector<node> &comm = c.Comm[c.Comm_order[i].first];
+        order.push_back(c.Comm_order[i].first);
+        sizes.push_back(comm.size());
+        members.insert(members.end(), comm.begin(), comm.end());
+        offsets.push_back(members.size());
+    }
 
-    for(int i=1; i<needed.size(); i++){
-        if(i>=minx && i<=maxx2){
-            v1.push_back(pair<double,double>(log(i), log(needed[i])));
-            v2.push_back(pair<double,double>((double)i, log(needed[i])));   
+    PyObject* levels = PyList_New(c.levels.size());
+    if (levels == NULL)
+        return NULL;
+    for (size_t l=0; l<c.levels.size(); l++) {
+        PyObject* level = Array_FromVector(c.levels[l]);
+        if (level == NULL) {
+            Py_DECREF(levels);          // Releases the levels already set
+            return NULL;
         }
+        PyList_SET_ITEM(levels, l, level);
     }
-    
-    polregB = regresion(v1);
-    expregB = regresion(v2);
-    
-    t_fin = clock();
-    secsDib = (double)(t_fin - t_ini) / CLOCKS_PER_SEC; 
-    
-    if(verbose){
-        cerr << "dimension bipartite = " << -polregB.first << endl;
-        cerr << "decay bipartite = " << -expregB.first << endl;
-    }
-  
-    //**************************************************************************
-    // Modularity VIG
-    //**************************************************************************
-    
-    if(verbose) {
-        cerr << "Computing COMMUNITY Structure (VIG)" << endl;
-        cerr << "max_clauses: " << max_clauses << endl;
+
+    // Nodes evaluated and moved in every sweep of the local moving
+    vector<long long> evaluated, moved;
+    for (size_t k=0; k<c.sweeps.size(); k++) {
+        evaluated.push_back(c.sweeps[k].first);
+        moved.push_back(c.sweeps[k].second);
     }
 
+    return Py_BuildValue("{s:d,s:n,s:N,s:N,s:N,s:N,s:N,s:N,s:N,s:N,s:O}",
+        "modularity", modularity,
+        "ncomm", (Py_ssize_t)c.ncomm,
+        "partition", Array_FromVector(c.n2c),
+        "dendrogram", levels,
+        "order", Array_FromVector(order),
+        "sizes", Array_FromVector(sizes),
+        "members", Array_FromVector(members),
+        "offsets", Array_FromVector(offsets),
+        "evaluated", Array_FromVector(evaluated),
+        "moved", Array_FromVector(moved),
+        "truncated", truncated ? Py_True : Py_False);
+}
 
-    // Compute
-    t_ini = clock();
-    modularity = c.compute_modularity_GFA(precision);
-    c.compute_communities();
-    t_fin = clock();
-    secsMod = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+// Options of the community detection
+typedef struct {
+    int method;                     // CommunityMethod
+    bool start;                     // Continue from a partition (see start_partition)
+    vector<long long> partition;    // Community of every node of the previous graph
+    vector<long long> mapping;      // Previous id of every node, empty if unchanged
+    const vector<long long>* perm;  // Id of every node in a reordered graph, or NULL
+    Budget* budget;
+} CommunityArgs;
+
+// Reads the optional partition, mapping and method arguments into "args".
+// Returns -1 with an exception set on error
+static int parse_community_args(PyObject* partition, PyObject* mapping, const char* method,
+                                CommunityArgs &args) {
+    args.method = parse_method(method);
+    if (args.method < 0)
+        return -1;
+    args.perm = NULL;
+    args.budget = NULL;
+    args.start = partition != NULL && partition != Py_None;
+    if (!args.start)
+        return 0;
+    if (Vector_FromObject(partition, args.partition) < 0)
+        return -1;
+    if (mapping != NULL && mapping != Py_None && Vector_FromObject(mapping, args.mapping) < 0)
+        return -1;
+    return 0;
+}
 
-    if(verbose){
-        cerr << "modularity = " << modularity << endl;
-        cerr << "communities = " << (int)c.ncomm << endl;
-        cerr << "largest size = " << (double)c.Comm[c.Comm_order[0].first].size()/vig->size() << endl;
-        cerr << "iterations = " << c.iterations << endl;
+// Computations on a graph of any instantiation
+
+// Runs the community detection from singletons, or from the given partition.
+// Returns false with the exception set on errors and interruptions.
+template <class G>
+static bool graph_GFA(Community<G> &c, CommunityArgs* args, double &modularity) {
+    c.budget = args->budget;
+    if (!args->start) {
+        modularity = c.compute_modularity(args->method, precision);
+        return !args->budget->interrupted;
     }
-    
+    vector<typename G::node_t> n2c;
+    if (!start_partition(c.g->size(), args->partition, args->mapping, n2c)) {
+        PyErr_SetString(PyExc_ValueError, "partition or mapping do not match the graph");
+        return false;
+    }
+    if (args->perm != NULL) {
+        vector<typename G::node_t> start(n2c.size());
+        for (size_t x=0; x<n2c.size(); x++)
+            start[(*args->perm)[x]] = n2c[x];
+        n2c.swap(start);
+    }
+    modularity = c.compute_modularity(args->method, precision, &n2c);
+    return !args->budget->interrupted;
+}
 
-    //**************************************************************************    
-    // Modularity CVIG
-    //**************************************************************************
+template <class G>
+static PyObject* graph_modularity(G* g, CommunityArgs* args) {
+    Community<G> c(g);
+    double modularity;
+    if (!graph_GFA(c, args, modularity))
+        return NULL;
+    return Py_BuildValue("d", modularity);
+}
 
-    
-    // Compute
-    t_ini = clock();    
-    modularity_bip = c_bip.compute_modularity_GFA(precision);
-    c_bip.compute_communities();
-    t_fin = clock();
+template <class G>
+static PyObject* graph_communities(G* g, CommunityArgs* args) {
+    Community<G> c(g);
+    double modularity;
+    if (!graph_GFA(c, args, modularity))
+        return NULL;
+    if (args->perm != NULL) {
+        unpermute(c.n2c, *args->perm);
+        for (size_t l=0; l<c.levels.size(); l++)
+            unpermute(c.levels[l], *args->perm);
+    }
+    c.compute_communities();
+    return community_dict(c, modularity, args->budget->truncated);
+}
 
-    if(verbose){
-        cerr << "modularity = " << modularity_bip << endl;
-        cerr << "communities = " << (int)c_bip.ncomm << endl;
-        cerr << "largest size = " << (double)c_bip.Comm[c_bip.Comm_order[0].first].size()/cvig->size() << endl;
-        cerr << "iterations = " << c_bip.iterations << endl;
+// Arguments of an ensemble of GFA runs (see ensemble_GFA)
+typedef struct {
+    int runs;
+    unsigned long long seed;
+    int consensus;
+    int method;
+    const vector<long long>* perm;  // Id of every node in a reordered graph, or NULL
+    Budget* budget;
+} EnsembleArgs;
+
+template <class G>
+static PyObject* graph_ensemble(G* g, EnsembleArgs* args) {
+
+    typedef typename G::node_t node;
+    Ensemble<node> e = ensemble_GFA(g, args->runs, precision, args->seed, args->consensus,
+                                    args->method, args->budget);
+    if (args->budget->interrupted)
+        return NULL;
+    if (args->perm != NULL) {
+        unpermute(e.partition, *args->perm);
+        if (args->consensus)
+            unpermute(e.consensus, *args->perm);
     }
 
-    secsModBip = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    PyObject* consensus = Py_None;
+    if (args->consensus) {
+        consensus = Array_FromVector(e.consensus);
+        if (consensus == NULL)
+            return NULL;
+    } else {
+        Py_INCREF(consensus);
+    }
+    return Py_BuildValue("{s:N,s:d,s:d,s:d,s:N,s:N,s:d,s:O}",
+        "runs", Array_FromVector(e.q),
+        "best", e.best,
+        "mean", e.mean,
+        "std", e.std,
+        "partition", Array_FromVector(e.partition),
+        "consensus", consensus,
+        "consensus_modularity", e.consensus_q,
+        "truncated", args->budget->truncated ? Py_True : Py_False);
+}
 
-    //**************************************************************************
-    // End
-    //**************************************************************************
-    
-    secsTotal = secsGraphs + secsAlphaVar + secsAlphaClau + secsDim + secsDib + secsMod + secsModBip;
-    
-    char * stat_names = "#instances, time-buildGraphs, alphaVarExp, "
-                        "time-AlphaVar, alphaClauExp, time-AlphaClau, "
-                        "dim, time-dim, dim-bip, "
-                        "time-dimBip, mod, #comm-vig, "
-                        "time-mod, mod-bip, #comm-cvig, "
-                        "time-mod-bip, time-total";
+// Checks the ensemble arguments of featsat functions and Graph methods
+static int check_ensemble(EnsembleArgs &args) {
+    if (args.runs < 1) {
+        PyErr_SetString(PyExc_ValueError, "runs must be positive");
+        return -1;
+    }
+    return 0;
+}
+
+template <class G>
+static PyObject* graph_self_similarity(G* g, Budget* budget) {
+    pair <double,double> polreg, expreg;
+    vector<long long> needed = computeNeeded(g, budget);
+    if (budget->interrupted)
+        return NULL;
+    fit_needed(needed, polreg, expreg);
+    return Py_BuildValue("d", -polreg.first);
+}
 
-    cerr << "Runtime = " << secsTotal << " secs" << endl;
-    cerr << "***************************************" << endl;
-    cout << stat_names << endl;
-	cout << fin << "," << secsGraphs << "," << alphavarexp << "," << secsAlphaVar << "," << alphaclauexp << "," << secsAlphaClau << "," << -polreg.first << "," << secsDim << "," << -polregB.first << "," << secsDib << "," << modularity << "," << (int)c.ncomm << "," << secsMod << "," << modularity_bip << "," << (int)c_bip.ncomm << "," << secsModBip << ","  << secsTotal << endl;
+template <class G>
+static PyObject* graph_box_covering(G* g, Budget* budget) {
+    vector<long long> needed = computeNeeded(g, budget);
+    if (budget->interrupted)
+        return NULL;
+    return Array_FromVector(needed);
+}
 
-    return modularity;
+typedef struct {
+    int samples;
+    unsigned long long seed;
+    Budget* budget;
+} BoxArgs;
+
+template <class G>
+static PyObject* graph_estimate_box_covering(G* g, BoxArgs* args) {
+    Budget* budget = args->budget;
+    BoxEstimate e = estimateNeeded(g, args->samples, args->seed, budget);
+    if (budget->interrupted)
+        return NULL;
+    double low, high;
+    double dim = fit_estimate(e, 200, args->seed, low, high);
+    return Py_BuildValue("{s:N,s:N,s:N,s:n,s:d,s:d,s:d,s:O}",
+        "needed", Array_FromVector(e.needed),
+        "low", Array_FromVector(e.low),
+        "high", Array_FromVector(e.high),
+        "samples", (Py_ssize_t)e.inverse.size(),
+        "dimension", dim,
+        "dimension_low", low,
+        "dimension_high", high,
+        "truncated", budget->truncated ? Py_True : Py_False);
+}
 
+template <class G>
+static PyObject* graph_components(G* g) {
+    return Py_BuildValue("L", components(g));
 }
 
+template <class G>
+static PyObject* graph_degree_stats(G* g) {
 
-// C Extension Info Section
+    long long edges = 0;
+    size_t mindeg = g->size() > 0 ? g->nNeighs(0) : 0, maxdeg = mindeg;
+    double s = 0, ss = 0;
 
-static PyObject* FeatSatError;
+    for (typename G::node_t i=0; i<g->size(); i++) {
+        size_t d = g->nNeighs(i);
+        edges += d;
+        s += d;
+        ss += (double)d * d;
+        if (d < mindeg) mindeg = d;
+        if (d > maxdeg) maxdeg = d;
+    }
+    double mean = g->size() > 0 ? s / g->size() : 0;
+    double var = g->size() > 0 ? ss / g->size() - mean * mean : 0;
+
+    return Py_BuildValue("{s:n,s:L,s:n,s:n,s:d,s:d,s:d}",
+        "nodes", (Py_ssize_t)g->size(),
+        "edges", edges / 2,
+        "min_degree", (Py_ssize_t)mindeg,
+        "max_degree", (Py_ssize_t)maxdeg,
+        "mean_degree", mean,
+        "std_degree", var > 0 ? sqrt(var) : 0.0,
+        "mean_arity", g->size() > 0 ? g->arity() / g->size() : 0.0);
+}
 
+// Reads the VIG (or the CVIG if "cvig") of a formula, computes func on it and
+// frees it
+template <class G>
+static PyObject* read_and_call(const FormulaSource &file_name, int max_clauses, bool cvig, PyObject* (*func)(G*)) {
+    G* g = cvig ? readCVIG<G>(file_name, max_clauses) : readVIG<G>(file_name, max_clauses);
+    PyObject* ans = func(g);
+    delete g;
+    return ans;
+}
 
-// Compute All
-static PyObject* featsat_compute_all(PyObject* self, PyObject* args) {
+template <class G, class A>
+static PyObject* read_and_call(const FormulaSource &file_name, int max_clauses, bool cvig, PyObject* (*func)(G*, A), A arg) {
+    G* g = cvig ? readCVIG<G>(file_name, max_clauses) : readVIG<G>(file_name, max_clauses);
+    PyObject* ans = func(g, arg);
+    delete g;
+    return ans;
+}
 
-    char* file_name;
-    int max_clauses;
+#define FILE_CALL(file_name, max_clauses, cvig, ...) \
+    ((cvig) ? DISPATCH_CVIG(graph_type(file_name, true), read_and_call, file_name, max_clauses, true, __VA_ARGS__) : \
+     DISPATCH_GRAPH(graph_type(file_name, false), read_and_call, file_name, max_clauses, false, __VA_ARGS__))
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+static PyObject* featsat_communities_vig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    PyObject* partition = NULL;
+    PyObject* mapping = NULL;
+    const char* method = NULL;
+    CommunityArgs cargs;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|OOsO&", formula_converter, &formula, &max_clauses, 
+                          &partition, &mapping, &method, budget_converter, &budget)) {
         return NULL;
     }
-    
-    double ans = compute_all(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
-}
+    if (parse_community_args(partition, mapping, method, cargs) < 0)
+        return NULL;
+    cargs.budget = budget.budget;
 
+    return FILE_CALL(formula.source, max_clauses, false, graph_communities, &cargs);
+}
 
-// Modularity Interfaces
-static PyObject* featsat_modularity_vig(PyObject* self, PyObject* args) {
+static PyObject* featsat_communities_cvig(PyObject* self, PyObject* args) {
 
-    char* file_name;
+    FormulaInput formula;
     int max_clauses;
-
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+    PyObject* partition = NULL;
+    PyObject* mapping = NULL;
+    const char* method = NULL;
+    CommunityArgs cargs;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&i|OOsO&", formula_converter, &formula, &max_clauses, 
+                          &partition, &mapping, &method, budget_converter, &budget)) {
         return NULL;
     }
+    if (parse_community_args(partition, mapping, method, cargs) < 0)
+        return NULL;
+    cargs.budget = budget.budget;
 
-   	double ans = modularity_vig(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+    return FILE_CALL(formula.source, max_clauses, true, graph_communities, &cargs);
 }
 
-static PyObject* featsat_modularity_cvig(PyObject* self, PyObject* args) {
+static PyObject* featsat_ensemble(PyObject* args, bool cvig) {
 
-    char* file_name;
+    FormulaInput formula;
     int max_clauses;
+    EnsembleArgs ens = {10, 0, 0, METHOD_LOUVAIN};
+    const char* method = NULL;
+    BudgetInput budget;
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+    if (!PyArg_ParseTuple(args, "O&i|iKpsO&", formula_converter, &formula, &max_clauses,
+                          &ens.runs, &ens.seed, &ens.consensus, &method, budget_converter, &budget)) {
         return NULL;
     }
-    
-    double ans = modularity_cvig(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+    ens.method = parse_method(method);
+    if (ens.method < 0 || check_ensemble(ens) < 0)
+        return NULL;
+    ens.budget = budget.budget;
+
+    return FILE_CALL(formula.source, max_clauses, cvig, graph_ensemble, &ens);
 }
 
+static PyObject* featsat_ensemble_vig(PyObject* self, PyObject* args) {
+    return featsat_ensemble(args, false);
+}
 
-// Scale Free Interfaces
-static PyObject* featsat_scale_free_var(PyObject* self, PyObject* args) {
+static PyObject* featsat_ensemble_cvig(PyObject* self, PyObject* args) {
+    return featsat_ensemble(args, true);
+}
 
-    char* file_name;
+// Box Covering Interfaces
+static PyObject* featsat_box_covering_vig(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
     int max_clauses;
+    BudgetInput budget;
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+    if (!PyArg_ParseTuple(args, "O&i|O&", formula_converter, &formula, &max_clauses,
+                          budget_converter, &budget)) {
         return NULL;
     }
-    
-    double ans = scale_free_var(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+
+    return FILE_CALL(formula.source, max_clauses, false, graph_box_covering, budget.budget);
 }
 
-static PyObject* featsat_scale_free_clause(PyObject* self, PyObject* args) {
+static PyObject* featsat_box_covering_cvig(PyObject* self, PyObject* args) {
 
-    char* file_name;
+    FormulaInput formula;
     int max_clauses;
+    BudgetInput budget;
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+    if (!PyArg_ParseTuple(args, "O&i|O&", formula_converter, &formula, &max_clauses,
+                          budget_converter, &budget)) {
         return NULL;
     }
-    
-    double ans = scale_free_clause(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+
+    return FILE_CALL(formula.source, max_clauses, true, graph_box_covering, budget.budget);
 }
 
-// Self Similar Interfaces
-static PyObject* featsat_self_similar_vig(PyObject* self, PyObject* args) {
+static PyObject* featsat_estimate_box_covering(PyObject* args, bool cvig) {
 
-    char* file_name;
+    FormulaInput formula;
     int max_clauses;
+    BoxArgs box = {200, 0, NULL};
+    BudgetInput budget;
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
+    if (!PyArg_ParseTuple(args, "O&i|iKO&", formula_converter, &formula, &max_clauses,
+                          &box.samples, &box.seed, budget_converter, &budget)) {
         return NULL;
     }
-    
-    double ans = self_similar_vig(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+    if (box.samples < 1) {
+        PyErr_SetString(PyExc_ValueError, "samples must be positive");
+        return NULL;
+    }
+    box.budget = budget.budget;
+
+    return FILE_CALL(formula.source, max_clauses, cvig, graph_estimate_box_covering, &box);
 }
 
-static PyObject* featsat_self_similar_cvig(PyObject* self, PyObject* args) {
+static PyObject* featsat_estimate_box_covering_vig(PyObject* self, PyObject* args) {
+    return featsat_estimate_box_covering(args, false);
+}
 
-    char* file_name;
-    int max_clauses;
+static PyObject* featsat_estimate_box_covering_cvig(PyObject* self, PyObject* args) {
+    return featsat_estimate_box_covering(args, true);
+}
 
-    if (!PyArg_ParseTuple(args, "si", &file_name, &max_clauses)) {
-        return NULL;
-    }
-    
-    double ans = self_similar_cvig(file_name, max_clauses);
-    return Py_BuildValue("d", ans);
+// Progressive Sampling Interface
+
+// Reads a SampleMode
+static int parse_sample_mode(const char* mode) {
+    if (strcmp(mode, "prefix") == 0)
+        return SAMPLE_PREFIX;
+    if (strcmp(mode, "uniform") == 0)
+        return SAMPLE_UNIFORM;
+    if (strcmp(mode, "reservoir") == 0)
+        return SAMPLE_RESERVOIR;
+    PyErr_Format(PyExc_ValueError, "Argument mode=%s not valid. Choose \"prefix\", \"uniform\" or \"reservoir\"", mode);
+    return -1;
 }
 
-// Function packaging
-static PyMethodDef FeatSatMethods[] = {
-    {
-        "compute_all",
-        featsat_compute_all,
-        METH_VARARGS,
-        "Computes all available features.\n\n",
+static PyObject* featsat_progressive(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+    int max_clauses;
+    const char* features = "mod-vig,alpha-var,dim-vig";
+    const char* mode_str = "reservoir";
+    long long first = 10000, limit = 0;
+    double growth = 2, tol = 0.01;
+    unsigned long long seed = 0;
+
+    if (!PyArg_ParseTuple(args, "O&i|ssLdLdK", formula_converter, &formula, &max_clauses,
+                          &features, &mode_str, &first, &growth, &limit, &tol, &seed)) {
+        return NULL;
+    }
+    int mode = parse_sample_mode(mode_str);
+    if (mode < 0)
+        return NULL;
+    string list(features);
+    int mask = parse_features(&list[0]);
+    if (mask <= 0) {
+        PyErr_Format(PyExc_ValueError, "Argument features=%s not valid", features);
+        return NULL;
+    }
+    if (first < 1 || growth <= 1) {
+        PyErr_SetString(PyExc_ValueError, "first must be positive and growth greater than 1");
+        return NULL;
+    }
+
+    SampleTrace trace = progressive_features(formula.source, max_clauses, mask, mode,
+                                             first, growth, limit, tol, seed);
+
+    // A column per step
+    vector<long long> clauses, vars;
+    vector<double> change, secs, alphavar, alphaclau, dim, dimbip, mod, modbip;
+    for (size_t k=0; k<trace.steps.size(); k++) {
+        Features &f = trace.steps[k].f;
+        clauses.push_back(trace.steps[k].clauses);
+        vars.push_back(trace.steps[k].vars);
+        change.push_back(trace.steps[k].change);
+        secs.push_back(f.secsTotal);
+        alphavar.push_back(f.alphavarexp);
+        alphaclau.push_back(f.alphaclauexp);
+        dim.push_back(f.dim);
+        dimbip.push_back(f.dimbip);
+        mod.push_back(f.modularity);
+        modbip.push_back(f.modularity_bip);
+    }
+
+    PyObject* ans = Py_BuildValue("{s:N,s:N,s:N,s:N,s:L,s:O,s:d}",
+        "clauses", Array_FromVector(clauses),
+        "vars", Array_FromVector(vars),
+        "change", Array_FromVector(change),
+        "secs", Array_FromVector(secs),
+        "total", trace.total,
+        "converged", trace.converged ? Py_True : Py_False,
+        "secs_sample", trace.secsSample);
+    if (ans == NULL)
+        return NULL;
+    const char* names[] = {"alpha_var", "alpha_clause", "dim", "dim_bip", "modularity", "modularity_bip"};
+    vector<double>* columns[] = {&alphavar, &alphaclau, &dim, &dimbip, &mod, &modbip};
+    for (int i=0; i<6; i++) {
+        if (!(mask & (1 << i)))
+            continue;
+        PyObject* column = Array_FromVector(*columns[i]);
+        if (column == NULL || PyDict_SetItemString(ans, names[i], column) < 0) {
+            Py_XDECREF(column);
+            Py_DECREF(ans);
+            return NULL;
+        }
+        Py_DECREF(column);
+    }
+    return ans;
+}
+
+// Graph Object
+
+#define KIND_VIG  0
+#define KIND_CVIG 1
+
+typedef struct {
+    PyObject_HEAD
+    void* g;            // Graph of the instantiation given by type
+    GraphType type;
+    int kind;           // KIND_VIG or KIND_CVIG
+    IncrementalGraph<GraphDynamic>* inc;    // Owner of g in dynamic graphs
+    vector<long long>* perm;    // Id in g of every original node, NULL if not reordered
+} GraphObject;
+
+// Calls func(g, ...) with the graph of a GraphObject cast to its instantiation
+#define GRAPH_CALL(self, func, ...) \
+    ((self)->type == GRAPH_HUGE ? func((GraphHuge*)(self)->g, ##__VA_ARGS__) : \
+     (self)->type == GRAPH_LARGE ? func((GraphLarge*)(self)->g, ##__VA_ARGS__) : \
+     (self)->type == GRAPH_DYNAMIC ? func((GraphDynamic*)(self)->g, ##__VA_ARGS__) : \
+     (self)->type == GRAPH_COMPRESSED ? func((GraphCompressed*)(self)->g, ##__VA_ARGS__) : \
+     func((GraphSmall*)(self)->g, ##__VA_ARGS__))
+
+template <class G>
+static void graph_delete(G* g) {
+    delete g;
+}
+
+template <class G>
+static Py_ssize_t graph_size(G* g) {
+    return g->size();
+}
+
+static void Graph_dealloc(GraphObject* self) {
+    if (self->inc != NULL)
+        delete self->inc;
+    else if (self->g != NULL)
+        GRAPH_CALL(self, graph_delete);
+    delete self->perm;
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int parse_kind(const char* kind) {
+    if (strcmp(kind, "vig") == 0)
+        return KIND_VIG;
+    if (strcmp(kind, "cvig") == 0)
+        return KIND_CVIG;
+    PyErr_Format(PyExc_ValueError, "Argument kind=%s not valid. Choose \"vig\" or \"cvig\"", kind);
+    return -1;
+}
+
+static PyObject* Graph_wrap(PyTypeObject* type, void* g, GraphType gtype, int kind) {
+    GraphObject* self = (GraphObject*)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        GraphObject tmp;
+        tmp.g = g;
+        tmp.type = gtype;
+        GRAPH_CALL(&tmp, graph_delete);
+        return NULL;
+    }
+    self->g = g;
+    self->type = gtype;
+    self->kind = kind;
+    self->inc = NULL;
+    self->perm = NULL;
+    return (PyObject*)self;
+}
+
+template <class G>
+static void* read_graph(char* file_name, int max_clauses, int kind, bool proxy,
+                        size_t memory, const char* scratch) {
+    if (kind == KIND_VIG)
+        return readVIG<G>(file_name, max_clauses, proxy, NULL, memory, scratch);
+    return readCVIG<G>(file_name, max_clauses);
+}
+
+static PyObject* Graph_from_file(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"file_name", "kind", "max_clauses", "proxy", "memory",
+                                   "scratch", "compressed", NULL};
+    char* file_name;
+    const char* kind_str = "vig";
+    int max_clauses = maxclause;
+    int proxy = 0;
+    long long memory = 0;
+    const char* scratch = NULL;
+    int compressed = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|sipLzp", (char**)kwlist, 
+                                     &file_name, &kind_str, &max_clauses, &proxy,
+                                     &memory, &scratch, &compressed)) {
+        return NULL;
+    }
+    int kind = parse_kind(kind_str);
+    if (kind < 0)
+        return NULL;
+    if (memory < 0) {
+        PyErr_SetString(PyExc_ValueError, "memory must not be negative");
+        return NULL;
+    }
+
+    FILE* source = fopen(file_name, "r");
+    if (source == NULL)
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, file_name);
+    fclose(source);
+
+    // Scratch files are written while building, fail before
+    if (scratch != NULL && *scratch != 0) {
+        struct stat st;
+        if (stat(scratch, &st) != 0 || access(scratch, W_OK | X_OK) != 0)
+            return PyErr_SetFromErrnoWithFilename(PyExc_OSError, scratch);
+        if (!S_ISDIR(st.st_mode)) {
+            errno = ENOTDIR;
+            return PyErr_SetFromErrnoWithFilename(PyExc_OSError, scratch);
+        }
+    }
+
+    GraphType gtype = graph_type(file_name, kind == KIND_CVIG, compressed && kind == KIND_VIG);
+    void* g = DISPATCH_GRAPH(gtype, read_graph, file_name, max_clauses, kind, proxy != 0,
+                             (size_t)memory, scratch);
+    return Graph_wrap(type, g, gtype, kind);
+}
+
+// Builds the graph of a formula given as lists of variables numbered from 0
+template <class G>
+static void* build_graph(vector<vector<int> > &formula, int n, int max_clauses, int kind, bool proxy) {
+
+    G* g;
+    size_t m = formula.size();
+    if (kind == KIND_VIG) {
+        g = new G(n, 0);
+        for (size_t i=0; i<m; i++)
+            if (formula[i].size() <= (size_t)max_clauses)
+                addClauseVIG(g, formula[i]);
+            else if (proxy)
+                addClauseVIGProxy(g, formula[i], g->add_nodes(1));
+    } else {
+        g = new G(n, m);
+        for (size_t i=0; i<m; i++)
+            if (formula[i].size() <= (size_t)max_clauses && formula[i].size() > 0)
+                addClauseCVIG(g, formula[i], n+i);
+    }
+    g->finalize();
+    return g;
+}
+
+//------------------------------------------------------------------------------
+// Reads clauses (lists of DIMACS literals) as lists of variables numbered 
+// from 0. If n >= 0, variables must be at most n. Returns -1 on errors.
+//------------------------------------------------------------------------------
+static int parse_clauses(PyObject* clauses, int n, vector<vector<int> > &formula, long &maxvar) {
+
+    PyObject* seq = PySequence_Fast(clauses, "clauses must be a sequence of clauses");
+    if (seq == NULL)
+        return -1;
+
+    // Clauses as lists of variables numbered from 0
+    Py_ssize_t m = PySequence_Fast_GET_SIZE(seq);
+    formula.resize(m);
+    maxvar = 0;
+    for (Py_ssize_t i=0; i<m; i++) {
+        PyObject* cl = PySequence_Fast(PySequence_Fast_GET_ITEM(seq, i), "clauses must be sequences of literals");
+        if (cl == NULL) {
+            Py_DECREF(seq);
+            return -1;
+        }
+        for (Py_ssize_t j=0; j<PySequence_Fast_GET_SIZE(cl); j++) {
+            long lit = PyLong_AsLong(PySequence_Fast_GET_ITEM(cl, j));
+            if (lit == -1 && PyErr_Occurred()) {
+                Py_DECREF(cl);
+                Py_DECREF(seq);
+                return -1;
+            }
+            if (lit == 0 || labs(lit) > INT_MAX || (n >= 0 && labs(lit) > n)) {
+                PyErr_Format(PyExc_ValueError, "Unvalid literal %ld in clause %zd", lit, i);
+                Py_DECREF(cl);
+                Py_DECREF(seq);
+                return -1;
+            }
+            formula[i].push_back(labs(lit)-1);
+            if (labs(lit) > maxvar) maxvar = labs(lit);
+        }
+        Py_DECREF(cl);
+    }
+    Py_DECREF(seq);
+    return 0;
+}
+
+static PyObject* Graph_from_clauses(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"clauses", "kind", "max_clauses", "n", "dynamic", "proxy", NULL};
+    PyObject* clauses;
+    const char* kind_str = "vig";
+    int max_clauses = maxclause;
+    int n = -1;
+    int dynamic = 0;
+    int proxy = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|siipp", (char**)kwlist, 
+                                     &clauses, &kind_str, &max_clauses, &n, &dynamic, &proxy)) {
+        return NULL;
+    }
+    int kind = parse_kind(kind_str);
+    if (kind < 0)
+        return NULL;
+    if (dynamic && proxy) {
+        PyErr_SetString(PyExc_ValueError, "dynamic graphs do not support proxy nodes");
+        return NULL;
+    }
+
+    vector<vector<int> > formula;
+    long maxvar;
+    if (parse_clauses(clauses, n, formula, maxvar) < 0)
+        return NULL;
+    if (n < 0) n = maxvar;
+
+    if (dynamic) {
+        IncrementalGraph<GraphDynamic>* inc = new IncrementalGraph<GraphDynamic>(n, kind == KIND_CVIG, max_clauses);
+        for (size_t i=0; i<formula.size(); i++)
+            inc->add_clause(formula[i]);
+        GraphObject* self = (GraphObject*)Graph_wrap(type, inc->g, GRAPH_DYNAMIC, kind);
+        if (self == NULL)
+            return NULL;
+        self->inc = inc;
+        return (PyObject*)self;
+    }
+
+    size_t m = formula.size();
+    GraphType gtype = choose_graph(kind == KIND_VIG ? n : (long long)n + m, m, false);
+    void* g = DISPATCH_GRAPH(gtype, build_graph, formula, n, max_clauses, kind, proxy != 0);
+    return Graph_wrap(type, g, gtype, kind);
+}
+
+// Dynamic graph of a GraphObject, or NULL with an exception set
+static IncrementalGraph<GraphDynamic>* Graph_dynamic(GraphObject* self) {
+    if (self->inc == NULL)
+        PyErr_SetString(PyExc_TypeError, "graph is not dynamic, build it with from_clauses(..., dynamic=True)");
+    return self->inc;
+}
+
+static PyObject* Graph_add_clauses(GraphObject* self, PyObject* args) {
+
+    PyObject* clauses;
+    if (!PyArg_ParseTuple(args, "O", &clauses))
+        return NULL;
+    IncrementalGraph<GraphDynamic>* inc = Graph_dynamic(self);
+    if (inc == NULL)
+        return NULL;
+
+    vector<vector<int> > formula;
+    long maxvar;
+    if (parse_clauses(clauses, inc->variables(), formula, maxvar) < 0)
+        return NULL;
+    size_t first = inc->clause_count();
+    for (size_t i=0; i<formula.size(); i++)
+        inc->add_clause(formula[i]);
+    return PyLong_FromSize_t(first);
+}
+
+static PyObject* Graph_remove_clauses(GraphObject* self, PyObject* args) {
+
+    PyObject* indices;
+    if (!PyArg_ParseTuple(args, "O", &indices))
+        return NULL;
+    IncrementalGraph<GraphDynamic>* inc = Graph_dynamic(self);
+    if (inc == NULL)
+        return NULL;
+
+    vector<long long> index;
+    if (Vector_FromObject(indices, index) < 0)
+        return NULL;
+    // Checked before removing any, so that errors leave the graph unchanged
+    vector<long long> sorted(index);
+    sort(sorted.begin(), sorted.end());
+    for (size_t i=0; i<sorted.size(); i++) {
+        if (sorted[i] < 0 || !inc->is_active(sorted[i]) || (i > 0 && sorted[i] == sorted[i-1])) {
+            PyErr_Format(PyExc_ValueError, "No clause %lld to remove", sorted[i]);
+            return NULL;
+        }
+    }
+    for (size_t i=0; i<index.size(); i++)
+        inc->remove_clause(index[i]);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Graph_incremental_modularity(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"refine", NULL};
+    int refine = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", (char**)kwlist, &refine))
+        return NULL;
+    IncrementalGraph<GraphDynamic>* inc = Graph_dynamic(self);
+    if (inc == NULL)
+        return NULL;
+
+    if (!inc->is_tracking())
+        inc->track(precision);
+    else if (refine)
+        inc->refine();
+    return Py_BuildValue("d", inc->modularity());
+}
+
+// Reads a NodeOrder
+static int parse_order(const char* order) {
+    if (strcmp(order, "rcm") == 0)
+        return ORDER_RCM;
+    if (strcmp(order, "degree") == 0)
+        return ORDER_DEGREE;
+    if (strcmp(order, "community") == 0)
+        return ORDER_COMMUNITY;
+    PyErr_Format(PyExc_ValueError, "Argument order=%s not valid. Choose \"rcm\", \"degree\" or \"community\"", order);
+    return -1;
+}
+
+// Returns a copy of g relabeled in the given NodeOrder, and composes "perm"
+// (id in g of every original node) with the relabeling. The community order
+// takes "partition" (community of every original node), or finds one.
+template <class G>
+static void* graph_reorder(G* g, int order, vector<long long>* partition, vector<long long>* perm) {
+
+    typedef typename G::node_t node;
+    vector<node> p;
+    if (order == ORDER_DEGREE) {
+        p = order_degree(g);
+    } else if (order == ORDER_RCM) {
+        p = order_rcm(g);
+    } else {
+        Community<G> c(g);
+        if (partition->empty()) {
+            c.compute_modularity(METHOD_LOUVAIN, precision);
+        } else {
+            for (size_t x=0; x<partition->size(); x++)
+                c.n2c[(*perm)[x]] = (*partition)[x];
+        }
+        p = order_community(g, c.n2c);
+    }
+    for (size_t x=0; x<perm->size(); x++)
+        (*perm)[x] = p[(*perm)[x]];
+    return permute(g, p);
+}
+
+static PyObject* Graph_reorder(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"order", "partition", NULL};
+    const char* order_str = "rcm";
+    PyObject* partition = NULL;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|sO", (char**)kwlist, &order_str, &partition))
+        return NULL;
+    int order = parse_order(order_str);
+    if (order < 0)
+        return NULL;
+
+    Py_ssize_t n = GRAPH_CALL(self, graph_size);
+    vector<long long> part;
+    if (partition != NULL && partition != Py_None) {
+        if (Vector_FromObject(partition, part) < 0)
+            return NULL;
+        if ((Py_ssize_t)part.size() != n) {
+            PyErr_SetString(PyExc_ValueError, "partition does not match the graph");
+            return NULL;
+        }
+    }
+
+    vector<long long>* perm = new vector<long long>(n);
+    for (Py_ssize_t x=0; x<n; x++)
+        (*perm)[x] = (self->perm != NULL) ? (*self->perm)[x] : x;
+    void* g = GRAPH_CALL(self, graph_reorder, order, &part, perm);
+    GraphObject* ans = (GraphObject*)Graph_wrap(Py_TYPE(self), g, self->type, self->kind);
+    if (ans == NULL) {
+        delete perm;
+        return NULL;
+    }
+    ans->perm = perm;
+    return (PyObject*)ans;
+}
+
+static PyObject* Graph_get_permutation(GraphObject* self, void* closure) {
+    if (self->perm == NULL)
+        Py_RETURN_NONE;
+    vector<long long> perm(*self->perm);
+    return Array_FromVector(perm);
+}
+
+static Py_ssize_t Graph_length(GraphObject* self) {
+    return GRAPH_CALL(self, graph_size);
+}
+
+static PyObject* Graph_get_kind(GraphObject* self, void* closure) {
+    return PyUnicode_FromString(self->kind == KIND_VIG ? "vig" : "cvig");
+}
+
+static PyObject* Graph_modularity(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"partition", "mapping", "method", "budget", NULL};
+    PyObject* partition = NULL;
+    PyObject* mapping = NULL;
+    const char* method = NULL;
+    CommunityArgs cargs;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOsO&", (char**)kwlist, &partition, &mapping, &method,
+                                     budget_converter, &budget))
+        return NULL;
+    if (parse_community_args(partition, mapping, method, cargs) < 0)
+        return NULL;
+    cargs.perm = self->perm;
+    cargs.budget = budget.budget;
+    return GRAPH_CALL(self, graph_modularity, &cargs);
+}
+
+static PyObject* Graph_communities(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"partition", "mapping", "method", "budget", NULL};
+    PyObject* partition = NULL;
+    PyObject* mapping = NULL;
+    const char* method = NULL;
+    CommunityArgs cargs;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOsO&", (char**)kwlist, &partition, &mapping, &method,
+                                     budget_converter, &budget))
+        return NULL;
+    if (parse_community_args(partition, mapping, method, cargs) < 0)
+        return NULL;
+    cargs.perm = self->perm;
+    cargs.budget = budget.budget;
+    return GRAPH_CALL(self, graph_communities, &cargs);
+}
+
+static PyObject* Graph_ensemble(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"runs", "seed", "consensus", "method", "budget", NULL};
+    EnsembleArgs ens = {10, 0, 0, METHOD_LOUVAIN};
+    const char* method = NULL;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iKpsO&", (char**)kwlist, 
+                                     &ens.runs, &ens.seed, &ens.consensus, &method,
+                                     budget_converter, &budget))
+        return NULL;
+    ens.method = parse_method(method);
+    if (ens.method < 0 || check_ensemble(ens) < 0)
+        return NULL;
+    ens.perm = self->perm;
+    ens.budget = budget.budget;
+    return GRAPH_CALL(self, graph_ensemble, &ens);
+}
+
+static PyObject* Graph_self_similarity(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"budget", NULL};
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&", (char**)kwlist, budget_converter, &budget))
+        return NULL;
+    return GRAPH_CALL(self, graph_self_similarity, budget.budget);
+}
+
+static PyObject* Graph_box_covering(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"budget", NULL};
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O&", (char**)kwlist, budget_converter, &budget))
+        return NULL;
+    return GRAPH_CALL(self, graph_box_covering, budget.budget);
+}
+
+static PyObject* Graph_estimate_box_covering(GraphObject* self, PyObject* args, PyObject* kwds) {
+
+    static const char* kwlist[] = {"samples", "seed", "budget", NULL};
+    BoxArgs box = {200, 0, NULL};
+    BudgetInput budget;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iKO&", (char**)kwlist, &box.samples, &box.seed,
+                                     budget_converter, &budget))
+        return NULL;
+    if (box.samples < 1) {
+        PyErr_SetString(PyExc_ValueError, "samples must be positive");
+        return NULL;
+    }
+    box.budget = budget.budget;
+    return GRAPH_CALL(self, graph_estimate_box_covering, &box);
+}
+
+static PyObject* Graph_components(GraphObject* self, PyObject* Py_UNUSED(args)) {
+    return GRAPH_CALL(self, graph_components);
+}
+
+static PyObject* Graph_degree_stats(GraphObject* self, PyObject* Py_UNUSED(args)) {
+    return GRAPH_CALL(self, graph_degree_stats);
+}
+
+static PyMethodDef Graph_methods[] = {
+    {
+        "from_file",
+        (PyCFunction)(void(*)(void))reading_class<Graph_from_file>,
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+        "from_file(file_name, kind='vig', max_clauses=400, proxy=False, memory=0, scratch=None,\n"
+        "          compressed=False)\n\n"
+        "Builds the VIG or CVIG of a CNF file, disregarding clauses of size\n"
+        "greater than max_clauses. With proxy=True, the VIG links those\n"
+        "clauses to a proxy node instead of a clique, with edges of weight\n"
+        "1/size, so that they keep their weight in the modularity. Proxy\n"
+        "nodes are numbered after the variables. With memory > 0, the VIG is\n"
+        "built out of core: the edges read are staged in about memory bytes,\n"
+        "spilled as sorted runs to files in scratch (by default, $TMPDIR) and\n"
+        "merged into a CSR file mapped in memory; OSError is raised if they\n"
+        "cannot be written. With compressed=True, the rows of the VIG are\n"
+        "kept as varint deltas and weight indices, in about a quarter of the\n"
+        "memory, and decoded while traversed; memory applies to the edges\n"
+        "staged before compressing them.\n\n",
+    },
+    {
+        "from_clauses",
+        (PyCFunction)(void(*)(void))Graph_from_clauses,
+        METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+        "from_clauses(clauses, kind='vig', max_clauses=400, n=None, dynamic=False, proxy=False)\n\n"
+        "Builds the VIG or CVIG of a list of clauses (lists of DIMACS literals)\n"
+        "over n variables (by default, the greatest variable found). Dynamic\n"
+        "graphs allow adding and removing clauses later. proxy is as in\n"
+        "from_file.\n\n",
+    },
+    {
+        "modularity",
+        (PyCFunction)(void(*)(void))Graph_modularity,
+        METH_VARARGS | METH_KEYWORDS,
+        "modularity(partition=None, mapping=None, method='louvain', budget=None)\n\n"
+        "Computes the modularity of the graph. If a partition (community of\n"
+        "every node, e.g. from a previous run) is given, Louvain continues from\n"
+        "it instead of from singletons. mapping[i] is the node of the previous\n"
+        "graph that node i was, or -1 for new nodes. method='leiden' moves\n"
+        "nodes with a queue of the ones whose neighborhood changed, and refines\n"
+        "communities into well-connected parts before collapsing them.\n"
+        "method='louvain-queue' is Louvain moving nodes with that queue.\n"
+        "A featsat.Budget stops it when exhausted, with the partition found so\n"
+        "far.\n\n",
+    },
+    {
+        "communities",
+        (PyCFunction)(void(*)(void))Graph_communities,
+        METH_VARARGS | METH_KEYWORDS,
+        "communities(partition=None, mapping=None, method='louvain', budget=None)\n\n"
+        "Computes the community structure of the graph (see communities_vig),\n"
+        "optionally continuing from a previous partition, by the given method\n"
+        "(see modularity). 'truncated' tells if the budget stopped it.\n\n",
+    },
+    {
+        "add_clauses",
+        (PyCFunction)Graph_add_clauses,
+        METH_VARARGS,
+        "add_clauses(clauses)\n\n"
+        "Adds clauses over the variables of a dynamic graph. Clauses are\n"
+        "numbered in the order they are added, from 0 for the initial ones.\n"
+        "Returns the number of the first clause added.\n\n",
+    },
+    {
+        "remove_clauses",
+        (PyCFunction)Graph_remove_clauses,
+        METH_VARARGS,
+        "remove_clauses(indices)\n\n"
+        "Removes the clauses of the given numbers from a dynamic graph. Clause\n"
+        "nodes of the CVIG remain, without edges.\n\n",
+    },
+    {
+        "incremental_modularity",
+        (PyCFunction)(void(*)(void))Graph_incremental_modularity,
+        METH_VARARGS | METH_KEYWORDS,
+        "incremental_modularity(refine=True)\n\n"
+        "Modularity of a partition of a dynamic graph maintained along its\n"
+        "changes. The first call computes the partition as modularity() does;\n"
+        "later ones update it, moving only the nodes whose edges changed if\n"
+        "refine, in time proportional to the changes.\n\n",
+    },
+    {
+        "ensemble",
+        (PyCFunction)(void(*)(void))Graph_ensemble,
+        METH_VARARGS | METH_KEYWORDS,
+        "ensemble(runs=10, seed=0, consensus=False, method='louvain', budget=None)\n\n"
+        "Runs the community detection of modularity() runs times in parallel,\n"
+        "each one with its own generator seeded from seed. Returns a dict with\n"
+        "the modularity of every run, the best, mean and std of them, and the\n"
+        "partition of the best run. If consensus, also the consensus partition\n"
+        "of the runs and its modularity, and whether the budget truncated them.\n\n",
+    },
+    {
+        "self_similarity",
+        (PyCFunction)(void(*)(void))Graph_self_similarity,
+        METH_VARARGS | METH_KEYWORDS,
+        "self_similarity(budget=None)\n\n"
+        "Computes the fractal dimension of the graph, from the diameters of the\n"
+        "box covering computed within the budget.\n\n",
+    },
+    {
+        "reorder",
+        (PyCFunction)(void(*)(void))Graph_reorder,
+        METH_VARARGS | METH_KEYWORDS,
+        "reorder(order='rcm', partition=None)\n\n"
+        "Returns a copy of the graph with the nodes relabeled in a cache-\n"
+        "friendly order: 'rcm' (reverse Cuthill-McKee), 'degree' (decreasing\n"
+        "degree) or 'community' (grouped by the given partition, or by the\n"
+        "communities found by Louvain). Variables and clauses keep their\n"
+        "ranges. Partitions given to and returned by the copy still refer to\n"
+        "the original nodes.\n\n",
+    },
+    {
+        "box_covering",
+        (PyCFunction)(void(*)(void))Graph_box_covering,
+        METH_VARARGS | METH_KEYWORDS,
+        "box_covering(budget=None)\n\n"
+        "Computes the number of boxes of each diameter needed for covering the graph.\n"
+        "If the budget is exhausted, the diameters computed so far.\n\n",
+    },
+    {
+        "estimate_box_covering",
+        (PyCFunction)(void(*)(void))Graph_estimate_box_covering,
+        METH_VARARGS | METH_KEYWORDS,
+        "estimate_box_covering(samples=200, seed=0, budget=None)\n\n"
+        "Estimates the box covering from the balls grown around samples random\n"
+        "centers, in parallel, for graphs where box_covering is too slow.\n"
+        "Returns a dict with the estimated 'needed' boxes of every diameter, the\n"
+        "'low' and 'high' ends of their 95% confidence intervals, the fractal\n"
+        "'dimension' with its bootstrap interval ('dimension_low' and\n"
+        "'dimension_high'), the 'samples' completed within the budget and\n"
+        "whether it 'truncated' them.\n\n",
+    },
+    {
+        "components",
+        (PyCFunction)Graph_components,
+        METH_NOARGS,
+        "Computes the number of connected components of the graph.\n\n",
+    },
+    {
+        "degree_stats",
+        (PyCFunction)Graph_degree_stats,
+        METH_NOARGS,
+        "Computes the number of nodes and edges and the degree statistics of the graph.\n\n",
+    },
+    {NULL, NULL, 0, NULL}  // sentinel
+};
+
+static PyGetSetDef Graph_getset[] = {
+    {(char*)"kind", (getter)Graph_get_kind, NULL, (char*)"Graph representation, 'vig' or 'cvig'.", NULL},
+    {(char*)"permutation", (getter)Graph_get_permutation, NULL,
+     (char*)"Node of every original node in a reordered graph, or None.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}  // sentinel
+};
+
+static PySequenceMethods Graph_as_sequence = {
+    (lenfunc)Graph_length,
+};
+
+static PyTypeObject GraphType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "featsat.Graph",
+};
+
+int Graph_Ready() {
+    GraphType.tp_basicsize = sizeof(GraphObject);
+    GraphType.tp_dealloc = (destructor)Graph_dealloc;
+    GraphType.tp_as_sequence = &Graph_as_sequence;
+    GraphType.tp_flags = Py_TPFLAGS_DEFAULT;
+    GraphType.tp_doc = "VIG or CVIG of a formula, built once for computing several features.";
+    GraphType.tp_methods = Graph_methods;
+    GraphType.tp_getset = Graph_getset;
+    return PyType_Ready(&GraphType);
+}
+
+
+// Backdoors Interfaces
+
+// Reads a BackdoorClass
+static int parse_backdoor_class(const char* cls) {
+    if (strcmp(cls, "horn") == 0)
+        return BACKDOOR_HORN;
+    if (strcmp(cls, "2cnf") == 0)
+        return BACKDOOR_2CNF;
+    PyErr_Format(PyExc_ValueError, "Argument cls=%s not valid. Choose \"horn\" or \"2cnf\"", cls);
+    return -1;
+}
+
+// Reads a formula into "f". Returns false with an exception set on error
+static bool read_clause_set(FormulaInput &formula, ClauseSet &f) {
+    if (!f.read(formula.source)) {
+        PyErr_Format(PyExc_OSError, "Unable to read CNF file %s", formula.source.name().c_str());
+        return false;
+    }
+    return true;
+}
+
+static PyObject* List_FromInts(const vector<int> &v) {
+    PyObject* list = PyList_New(v.size());
+    if (list == NULL)
+        return NULL;
+    for (size_t i=0; i<v.size(); i++) {
+        PyObject* x = PyLong_FromLong(v[i]);
+        if (x == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, x);
+    }
+    return list;
+}
+
+static PyObject* featsat_renameable_horn(PyObject* self, PyObject* args) {
+
+    FormulaInput formula;
+
+    if (!PyArg_ParseTuple(args, "O&", formula_converter, &formula)) {
+        return NULL;
+    }
+    ClauseSet f;
+    if (!read_clause_set(formula, f))
+        return NULL;
+
+    vector<int> renamed;
+    if (!renameable_horn(f, renamed))
+        Py_RETURN_NONE;
+    return List_FromInts(renamed);
+}
+
+// Strong or weak backdoor, by "weak"
+static PyObject* backdoor(PyObject* args, bool weak) {
+
+    FormulaInput formula;
+    const char* cls_str = "horn";
+    int max_size = -1;
+    BudgetInput budget;
+
+    if (!PyArg_ParseTuple(args, "O&|siO&", formula_converter, &formula, &cls_str, &max_size,
+                          budget_converter, &budget)) {
+        return NULL;
+    }
+    int cls = parse_backdoor_class(cls_str);
+    if (cls < 0)
+        return NULL;
+    ClauseSet f;
+    if (!read_clause_set(formula, f))
+        return NULL;
+
+    BackdoorSearch search(f, cls, weak, budget.budget);
+    Backdoor b = search.smallest(max_size);
+    if (budget.interrupted())
+        return NULL;
+    if (!b.found)
+        Py_RETURN_NONE;
+    return List_FromInts(b.lits);
+}
+
+static PyObject* featsat_strong_backdoor(PyObject* self, PyObject* args) {
+    return backdoor(args, false);
+}
+
+static PyObject* featsat_weak_backdoor(PyObject* self, PyObject* args) {
+    return backdoor(args, true);
+}
+
+
+// CPU Dispatch Interface
+static PyObject* featsat_cpu_features(PyObject* self, PyObject* Py_UNUSED(args)) {
+    return Py_BuildValue("s", cpu_level());
+}
+
+
+// Function packaging
+static PyMethodDef FeatSatMethods[] = {
+    {
+        "compute_all",
+        reading<featsat_compute_all>,
+        METH_VARARGS,
+        "Computes all available features.\n\n",
+    },
+    {
+        "features",
+        reading<featsat_features>,
+        METH_VARARGS,
+        "features(formula, max_clauses, features='all')\n\n"
+        "Computes the features of a formula named as in sia-feat -f, reading\n"
+        "it once: the base features (sizes, literal balance, Horn and binary\n"
+        "clauses, variable occurrences) and the scale-free distributions are\n"
+        "counted while the graphs are built. Returns a dict of the features\n"
+        "selected, with the seconds taken and whether the time limit truncated\n"
+        "the graph features.\n\n",
     },
     {
         "modularity_vig",
-        featsat_modularity_vig,
+        reading<featsat_modularity_vig>,
         METH_VARARGS,
-        "Computes Modularity of a given CNF file for VIG representation.\n\n",
+        "Computes Modularity of a given CNF formula for VIG representation.\n\n"
+        "Formulas are file names, DIMACS text (bytes), pairs (literals, offsets)\n"
+        "of integer arrays, where clause i is literals[offsets[i]:offsets[i+1]],\n"
+        "or lists of clauses. Text and arrays are read in place.\n\n"
+        "The feature computations take an optional featsat.Budget as last\n"
+        "argument, and stop when it is exhausted with the result found so far.\n"
+        "Ctrl-C interrupts them.\n\n",
     },
     {
         "modularity_cvig",
-        featsat_modularity_cvig,
+        reading<featsat_modularity_cvig>,
         METH_VARARGS,
-        "Computes Modularity of a given CNF file for CVIG representation.\n\n",
+        "Computes Modularity of a given CNF formula for CVIG representation.\n\n",
+    },
+    {
+        "modularity_hypergraph",
+        reading<featsat_modularity_hypergraph>,
+        METH_VARARGS,
+        "Computes Modularity of a given CNF formula on its clause hypergraph.\n\n"
+        "Clauses weigh as in the VIG, so that the modularity of a partition is\n"
+        "the same, but Louvain runs on the clauses without building the VIG,\n"
+        "in memory linear in the size of the formula.\n\n",
     },
     {
         "scale_free_var",
-        featsat_scale_free_var,
+        reading<featsat_scale_free_var>,
         METH_VARARGS,
-        "Computes Scale Free exponent of a given CNF file in respect to variables.\n\n",
+        "Computes Scale Free exponent of a given CNF formula in respect to variables.\n\n",
     },
     {
         "scale_free_clause",
-        featsat_scale_free_clause,
+        reading<featsat_scale_free_clause>,
         METH_VARARGS,
-        "Computes Scale Free exponent of a given CNF file in respect to clauses.\n\n",
+        "Computes Scale Free exponent of a given CNF formula in respect to clauses.\n\n",
     },
     {
         "self_similar_vig",
-        featsat_self_similar_vig,
+        reading<featsat_self_similar_vig>,
         METH_VARARGS,
-        "Computes Self Similarity value of a given CNF file for VIG representation.\n\n",
+        "Computes Self Similarity value of a given CNF formula for VIG representation.\n\n",
     },
     {
         "self_similar_cvig",
-        featsat_self_similar_cvig,
+        reading<featsat_self_similar_cvig>,
         METH_VARARGS,
-        "Computes Self Similarity value of a given CNF file for CVIG representation.\n\n",
+        "Computes Self Similarity value of a given CNF formula for CVIG representation.\n\n",
+    },
+    {
+        "communities_vig",
+        reading<featsat_communities_vig>,
+        METH_VARARGS,
+        "Computes the community structure of a given CNF formula for VIG representation.\n\n"
+        "Returns a dict with the modularity, the partition, the dendrogram of\n"
+        "partitions per level and the communities as featsat.Array objects.\n"
+        "Optional partition and mapping arguments continue from a previous\n"
+        "partition, and method selects 'louvain', 'louvain-queue' or 'leiden' (see\n"
+        "Graph.modularity).\n\n",
+    },
+    {
+        "communities_cvig",
+        reading<featsat_communities_cvig>,
+        METH_VARARGS,
+        "Computes the community structure of a given CNF formula for CVIG representation.\n\n"
+        "Returns a dict with the modularity, the partition, the dendrogram of\n"
+        "partitions per level and the communities as featsat.Array objects.\n"
+        "Optional partition and mapping arguments continue from a previous\n"
+        "partition, and method selects 'louvain', 'louvain-queue' or 'leiden' (see\n"
+        "Graph.modularity).\n\n",
+    },
+    {
+        "ensemble_vig",
+        reading<featsat_ensemble_vig>,
+        METH_VARARGS,
+        "ensemble_vig(formula, max_clauses, runs=10, seed=0, consensus=False, method='louvain', budget=None)\n\n"
+        "Runs the community detection on the VIG several times in parallel\n"
+        "(see Graph.ensemble), reading the formula once.\n\n",
+    },
+    {
+        "ensemble_cvig",
+        reading<featsat_ensemble_cvig>,
+        METH_VARARGS,
+        "ensemble_cvig(formula, max_clauses, runs=10, seed=0, consensus=False, method='louvain', budget=None)\n\n"
+        "Runs the community detection on the CVIG several times in parallel\n"
+        "(see Graph.ensemble), reading the formula once.\n\n",
+    },
+    {
+        "box_covering_vig",
+        reading<featsat_box_covering_vig>,
+        METH_VARARGS,
+        "Computes the number of boxes of each diameter needed for covering the VIG.\n\n",
+    },
+    {
+        "box_covering_cvig",
+        reading<featsat_box_covering_cvig>,
+        METH_VARARGS,
+        "Computes the number of boxes of each diameter needed for covering the CVIG.\n\n",
+    },
+    {
+        "estimate_box_covering_vig",
+        reading<featsat_estimate_box_covering_vig>,
+        METH_VARARGS,
+        "estimate_box_covering_vig(formula, max_clauses, samples=200, seed=0, budget=None)\n\n"
+        "Estimates the box covering of the VIG from random centers (see\n"
+        "Graph.estimate_box_covering).\n\n",
+    },
+    {
+        "estimate_box_covering_cvig",
+        reading<featsat_estimate_box_covering_cvig>,
+        METH_VARARGS,
+        "estimate_box_covering_cvig(formula, max_clauses, samples=200, seed=0, budget=None)\n\n"
+        "Estimates the box covering of the CVIG from random centers (see\n"
+        "Graph.estimate_box_covering).\n\n",
+    },
+    {
+        "progressive",
+        reading<featsat_progressive>,
+        METH_VARARGS,
+        "progressive(formula, max_clauses, features='mod-vig,alpha-var,dim-vig', mode='reservoir',\n"
+        "            first=10000, growth=2.0, limit=0, tol=0.01, seed=0)\n\n"
+        "Estimates features (as in sia-feat -f) on growing samples of the\n"
+        "clauses of a formula: a 'prefix', a 'uniform' random sample or a\n"
+        "'reservoir' sample of at most limit clauses (0 for all), read in one\n"
+        "pass. Starts with first clauses of the sample, and grows them by\n"
+        "growth until no feature changes more than tol (relatively) or the\n"
+        "sample is exhausted. Returns a dict with an array per feature, and the\n"
+        "clauses, vars, change and secs of every step, as the convergence trace.\n\n",
+    },
+    {
+        "renameable_horn",
+        reading<featsat_renameable_horn>,
+        METH_VARARGS,
+        "renameable_horn(formula)\n\n"
+        "Returns the variables whose signs, flipped, make a formula Horn, or\n"
+        "None if it is not renameable Horn. Decided in linear time as a 2-SAT\n"
+        "problem.\n\n",
+    },
+    {
+        "strong_backdoor",
+        reading<featsat_strong_backdoor>,
+        METH_VARARGS,
+        "strong_backdoor(formula, cls='horn', max_size=-1, budget=None)\n\n"
+        "Returns a smallest set of variables whose every assignment leaves a\n"
+        "'horn' or '2cnf' formula, of at most max_size variables (any if\n"
+        "negative), or None. Sets of the variables of the clauses out of the\n"
+        "class are enumerated by size, in parallel and with pruning.\n\n",
+    },
+    {
+        "weak_backdoor",
+        reading<featsat_weak_backdoor>,
+        METH_VARARGS,
+        "weak_backdoor(formula, cls='horn', max_size=-1, budget=None)\n\n"
+        "Returns the literals of a smallest assignment leaving a satisfiable\n"
+        "'horn' or '2cnf' formula, of at most max_size variables (any if\n"
+        "negative, up to 30), or None.\n\n",
+    },
+    {
+        "cpu_features",
+        featsat_cpu_features,
+        METH_NOARGS,
+        "Returns the instruction set selected for the vectorized kernels:\n"
+        "avx512f, avx2, sse4.2 or default.\n\n",
     },
     {NULL, NULL, 0, NULL}  // sentinel
 };
@@ -726,10 +2030,19 @@ static PyModuleDef featsatmodule = {
 PyMODINIT_FUNC PyInit_featsat() {
     PyObject* module;
 
+    if (Array_Ready() < 0 || Graph_Ready() < 0 || Budget_Ready() < 0) {
+        return NULL;
+    }
     module = PyModule_Create(&featsatmodule);
     if (module == NULL) {
         return NULL;
     }
+    Py_INCREF(&ArrayType);
+    PyModule_AddObject(module, "Array", (PyObject*)&ArrayType);
+    Py_INCREF(&GraphType);
+    PyModule_AddObject(module, "Graph", (PyObject*)&GraphType);
+    Py_INCREF(&BudgetType);
+    PyModule_AddObject(module, "Budget", (PyObject*)&BudgetType);
     FeatSatError = PyErr_NewException("featsat.Error", NULL, NULL);
     Py_INCREF(FeatSatError);
     PyModule_AddObject(module, "Error", FeatSatError);
@@ -0,0 +1,151 @@
+/*
+    formula.h
+
+    Sources of formulas for the feature computations: CNF files, DIMACS text
+    in memory, or clauses in memory given as a flat array of literals and
+    the offsets of every clause. Memory sources are read in place, without
+    copying them.
+
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <stdexcept>
+#include "dimacs.h"
+
+#ifndef FORMULA_H
+#define FORMULA_H
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Error reading a formula: an invalid header or literal, or a file that
+// cannot be read or written if "system". The readers throw it instead of
+// exiting, so that the bindings raise it and sia-feat skips the instance.
+//------------------------------------------------------------------------------
+struct FormulaError : public runtime_error {
+    bool system;
+
+    FormulaError(const string &msg, bool sys = false) : runtime_error(msg), system(sys) {}
+};
+
+//------------------------------------------------------------------------------
+// A formula to read. File names convert implicitly, so that every function
+// taking a FormulaSource also takes a file name. The memory of the other
+// sources must outlive the readers.
+//------------------------------------------------------------------------------
+struct FormulaSource {
+    const char* file;           // CNF file, or NULL for formulas in memory
+    const char* text;           // DIMACS text, or NULL
+    size_t text_size;
+    const void* lits;           // Literals of clause i are lits[offsets[i]..offsets[i+1]-1]
+    const void* offsets;
+    int lit_size, offset_size;  // Bytes of each literal and offset (4 or 8)
+    long long nvars, nclauses;
+
+    FormulaSource() : file(NULL), text(NULL), text_size(0), lits(NULL), offsets(NULL),
+                      lit_size(4), offset_size(8), nvars(0), nclauses(0) {}
+
+    FormulaSource(const char* f) : file(f), text(NULL), text_size(0), lits(NULL), offsets(NULL),
+                                   lit_size(4), offset_size(8), nvars(0), nclauses(0) {}
+
+    static FormulaSource dimacs(const char* t, size_t size) {
+        FormulaSource s;
+        s.text = t;
+        s.text_size = size;
+        return s;
+    }
+
+    // Clauses over variables 1..vars, offsets has clauses+1 entries
+    static FormulaSource clauses(const void* l, int lsize, const void* o, int osize,
+                                 long long vars, long long clauses) {
+        FormulaSource s;
+        s.lits = l;
+        s.lit_size = lsize;
+        s.offsets = o;
+        s.offset_size = osize;
+        s.nvars = vars;
+        s.nclauses = clauses;
+        return s;
+    }
+
+    // Name shown in messages and feature rows
+    string name() const {
+        if (file != NULL) return file;
+        return text != NULL ? "<dimacs>" : "<clauses>";
+    }
+};
+
+//------------------------------------------------------------------------------
+// Reads the header and the literals of a FormulaSource as DimacsReader does,
+// with a 0 after every clause
+//------------------------------------------------------------------------------
+class FormulaReader {
+
+    const FormulaSource &src;
+    FILE* source;
+    DimacsReader* dimacs;
+    long long clause;           // Clause being read, and next literal of it
+    long long lit;
+    bool opened;
+
+    long long offset(long long i) {
+        if (src.offset_size == 4) return ((const int32_t*)src.offsets)[i];
+        return ((const int64_t*)src.offsets)[i];
+    }
+
+    public:
+
+        FormulaReader(const FormulaSource &s) : src(s), source(NULL), dimacs(NULL),
+                                                clause(0), lit(0), opened(false) {}
+
+        ~FormulaReader() {
+            delete dimacs;
+            if (source != NULL)
+                fclose(source);
+        }
+
+        // Returns false if the file cannot be opened
+        bool open() {
+            opened = true;
+            if (src.file != NULL) {
+                source = fopen(src.file, "r");
+                if (source == NULL)
+                    return false;
+                dimacs = new DimacsReader(source);
+            } else if (src.text != NULL) {
+                dimacs = new DimacsReader(src.text, src.text_size);
+            } else if (src.nclauses > 0) {
+                lit = offset(0);
+            }
+            return true;
+        }
+
+        bool header(long long &vars, long long &clauses) {
+            if (!opened && !open())
+                return false;
+            if (dimacs != NULL)
+                return dimacs->header(vars, clauses);
+            vars = src.nvars;
+            clauses = src.nclauses;
+            return true;
+        }
+
+        bool next(int &x) {
+            if (dimacs != NULL)
+                return dimacs->next(x);
+            if (clause == src.nclauses)
+                return false;
+            if (lit == offset(clause+1)) {
+                clause++;
+                x = 0;
+            } else if (src.lit_size == 4) {
+                x = ((const int32_t*)src.lits)[lit++];
+            } else {
+                x = (int)((const int64_t*)src.lits)[lit++];
+            }
+            return true;
+        }
+};
+
+#endif
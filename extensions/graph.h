@@ -0,0 +1,301 @@
+/*
+Graph Features Computation for SAT instances.
+
+Version 2.2
+Authors:
+  - Carlos Ansótegui (DIEI - UdL)
+  - María Luisa Bonet (LSI - UPC)
+  - Jesús Giráldez-Cru (IIIA-CSIC)
+  - Jordi Levy (IIIA-CSIC)
+
+Contact: jgiraldez@iiia.csic.es
+
+    Copyright (C) 2014  C. Ansótegui, M.L. Bonet, J. Giráldez-Cru, J. Levy
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include "graph_set.h"
+#include "graph_vector.h"
+#include "graph_csr.h"
+#include "graph_incidence.h"
+#include "graph_compressed.h"
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Weighted graph with nodes of type Node, edge weights of type Weight and 
+// neighbors kept by a Storage policy (SetStorage, VectorStorage, CSRStorage,
+// IncidenceStorage, CompressedStorage).
+// Nodes [0..typeA-1] are variables, and [typeA..size()-1] clauses in CVIGs.
+// Arities are always accumulated as doubles.
+//------------------------------------------------------------------------------
+template <class Node, class Weight, template <class, class> class Storage>
+class GraphT {
+private:
+    Node nnodes;                        // Number of nodes
+    Node typeA;
+    double tarity;                      // Sum of the arities
+    vector <double> narity;             // Arity of each node
+    Storage<Node,Weight> neigh;         // For each node, a list of its neighbors
+
+public:
+
+    typedef Node node_t;
+    typedef Weight weight_t;
+    typedef typename Storage<Node,Weight>::iterator row_iterator;
+
+    GraphT() : nnodes(0), typeA(0), tarity(0), narity(0) {}
+    GraphT(Node n, Node m) {
+        tarity = 0;
+        typeA = n;
+        narity.resize(n+m, 0); 
+        neigh.resize(n+m); 
+        nnodes = n+m;
+    }
+
+    ~GraphT(){
+        narity.clear();
+    }
+
+    double arity(Node x) {     
+        assert(x>=0 && x<= nnodes-1); 
+        return narity[x]; 
+    }
+    
+    size_t nNeighs(Node x){
+        return neigh.row_size(x);
+    }
+    
+    Node getTypeA(){
+        return typeA;
+    }
+
+    Node size() { return nnodes; }
+
+    double arity() { return tarity; }
+
+    void add_edge(Node x, Node y) { add_edge(x,y,1); };
+
+    // Edges towards clause nodes are never repeated, and are not looked up
+    void add_edge(Node x, Node y, Weight w) {
+        assert(x>=0 && x<= nnodes-1); 
+        assert(y>=0 && y<= nnodes-1); 
+        narity[x] += w;
+        narity[y] += w;
+        tarity += 2 * w;
+        neigh.add(x, y, w, y < typeA);
+    }
+
+    //--------------------------------------------------------------------------
+    // Removes weight w from edge x-y, undoing add_edge(x,y,w). The edge is
+    // dropped when no weight is left. Only for SetStorage and VectorStorage.
+    //--------------------------------------------------------------------------
+    void remove_edge(Node x, Node y, Weight w) {
+        assert(x>=0 && x<= nnodes-1); 
+        assert(y>=0 && y<= nnodes-1); 
+        narity[x] -= w;
+        narity[y] -= w;
+        tarity -= 2 * w;
+        neigh.remove(x, y, w);
+    }
+
+    //--------------------------------------------------------------------------
+    // Adds k nodes without edges, numbered from size(). Returns the first one
+    //--------------------------------------------------------------------------
+    Node add_nodes(Node k) {
+        Node first = nnodes;
+        nnodes += k;
+        narity.resize(nnodes, 0);
+        neigh.resize(nnodes);
+        return first;
+    }
+
+    //--------------------------------------------------------------------------
+    // Stages the edges in about "bytes" of memory, spilling them to scratch
+    // files in "dir". Only for CSRStorage, before adding edges.
+    //--------------------------------------------------------------------------
+    void spill(size_t bytes, const char* dir) {
+        neigh.spill(bytes, dir);
+    }
+
+    //--------------------------------------------------------------------------
+    // Makes the edges added visible to the iterators. Must be called once the 
+    // graph is built (CSRStorage sorts and compacts the edges here).
+    //--------------------------------------------------------------------------
+    void finalize() {
+        neigh.finalize();
+    }
+
+    //--------------------------------------------------------------------------
+    // Replaces the neighbors of every node x by rows[x], that must be sorted 
+    // and free of repetitions, and recomputes the arities. Rows are emptied.
+    //--------------------------------------------------------------------------
+    void set_rows(vector<vector<pair<Node,Weight> > > &rows) {
+        assert(rows.size() == nnodes);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)nnodes; x++) {
+            double a = 0;
+            for (size_t i=0; i<rows[x].size(); i++)
+                a += (rows[x][i].first == (Node)x) ? 2 * (double)rows[x][i].second : rows[x][i].second;
+            narity[x] = a;
+        }
+        neigh.set_rows(rows);
+        tarity = 0;
+        for (Node i=0; i<nnodes; i++)
+            tarity += narity[i];
+    }
+
+    double connected(Node x, Node y) {
+        assert(x>=0 && x<= nnodes-1); 
+        assert(y>=0 && y<= nnodes-1);
+        return neigh.find(x, y);
+    }
+
+    void print() {
+        cerr <<"------ GRAPH ------\n";
+        cerr << neigh.name() << "\n";
+        cerr <<"NNodes = "<<nnodes<<endl;
+        cerr <<"TArity = "<<tarity<<endl;
+        for(Node i=0; i<nnodes; i++){
+            cerr << i << " --> ";
+            for(row_iterator it=neigh.row_begin(i); it!=neigh.row_end(i); ++it)
+                //if (i <= it->first) 
+                    cerr << it->first << " (" << it->second << ") ";
+            cerr << endl;
+        }
+    }
+
+    //--------------- ITERATOR ON EDGES ----------------------------------------
+
+    typedef struct {Node orig, dest; Weight weight;} edge;
+
+    class EdgeIter;             // Iterator to traverse all EDGES of the Graph
+    friend class EdgeIter;
+
+    class EdgeIter {
+        GraphT &g;
+        row_iterator it;
+        Node node;
+        edge e;
+
+        void next() {
+            assert(node >= 0 && node < g.nnodes);
+            assert(node < g.nnodes-1 || it != g.neigh.row_end(node)); 
+            do {
+                if (++it == g.neigh.row_end(node) && node < g.nnodes-1) {
+                    do {
+                        node++; 
+                        it = g.neigh.row_begin(node); 
+                    }
+                    while (it == g.neigh.row_end(node) && node < g.nnodes-1); //skip nodes without neighs
+                }
+            }
+            while (!(it == g.neigh.row_end(node) && node == g.nnodes-1)   //skip when orig > dest
+                && node > it->first);
+        }
+
+    public:
+
+        EdgeIter(GraphT &x) : g(x){}
+        EdgeIter(GraphT &x, row_iterator y, Node n): g(x), it(y), node(n) { };
+
+        EdgeIter (const EdgeIter &x) : g(x.g), it(x.it), node(x.node) {}
+
+        EdgeIter& operator++() {
+            next();
+            return *this;
+        }
+        EdgeIter& operator++(int) {
+            next();
+            return *this;
+        }
+
+        bool operator==(const EdgeIter &rhs) {return it==rhs.it;}
+        bool operator!=(const EdgeIter &rhs) {return it!=rhs.it;}
+
+        edge& operator*() {
+            e.orig = node; 
+            e.dest = it->first; 
+            e.weight = it->second; 
+            return e;
+        }
+        edge *operator->() {
+            e.orig = node; 
+            e.dest = it->first; 
+            e.weight = it->second; 
+            return &e;
+        }
+    };
+
+    EdgeIter begin() {
+        Node node = 0;
+        while (node < nnodes-1 && neigh.row_size(node)==0) node++;
+        return EdgeIter(*this, neigh.row_begin(node), node);  
+    // First neight of first node
+    }
+
+    EdgeIter end() {
+        return EdgeIter(*this, neigh.row_end(nnodes-1), nnodes);  
+    // Last neight of last node
+    }
+
+    //--------------- ITERATOR ON NEIGHBORS ------------------------------------
+
+    class NeighIter {
+        row_iterator it;
+        edge e;
+    public:
+
+        NeighIter(row_iterator x) : it(x){}
+        edge *operator->() {
+            e.dest = it->first; 
+            e.weight = it->second; 
+            return &e;
+        }
+        NeighIter& operator++() {
+            ++it;
+            return *this;
+        }
+        NeighIter& operator++(int) {
+            it++;
+            return *this;
+        }
+        bool operator==(const NeighIter& x) {return it==x.it;}
+        bool operator!=(const NeighIter& x) {return it!=x.it;}
+    };
+
+    NeighIter begin(Node x) { 
+        assert(x>=0 && x<= nnodes-1); 
+        return NeighIter(neigh.row_begin(x)); 
+    }
+
+    NeighIter end(Node x) { 
+        assert(x>=0 && x<= nnodes-1); 
+        return NeighIter(neigh.row_end(x)); 
+    }
+};
+
+// Default graph
+typedef GraphT<int, double, SetStorage> Graph;
+
+#endif
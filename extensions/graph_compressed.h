@@ -0,0 +1,244 @@
+/*
+    graph_compressed.h
+
+    Compressed storage of the rows of a read-only graph. Every sorted row is
+    kept as the differences between consecutive neighbors, in variable-length
+    bytes (varints), and every weight as the index of its value in a table of
+    the distinct weights, most frequent first. Edges of a VIG weigh sums of
+    2/(k(k-1)) for clause sizes k, so a few values cover almost all of them,
+    and an entry usually takes 2 or 3 bytes instead of the 12 of CSRStorage.
+    Rows are decoded while iterating them.
+
+*/
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <stdint.h>
+#include <assert.h>
+#include "graph_csr.h"
+
+#ifndef GRAPH_COMPRESSED_H
+#define GRAPH_COMPRESSED_H
+
+using namespace std;
+
+// Zero bytes after the last row, so that iterators can decode an entry past
+// the end of any row without reading out of the buffer
+#define COMPRESSED_PADDING 24
+
+//------------------------------------------------------------------------------
+// Appends x to "out" as a varint: 7 bits per byte, the lowest first, with the
+// high bit set in all bytes but the last
+//------------------------------------------------------------------------------
+inline void put_varint(vector<uint8_t> &out, uint64_t x) {
+    while (x >= 0x80) {
+        out.push_back((uint8_t)(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back((uint8_t)x);
+}
+
+// Reads a varint at p, advancing it
+inline uint64_t get_varint(const uint8_t* &p) {
+    uint64_t x = *p++;
+    if (x < 0x80)
+        return x;
+    x &= 0x7f;
+    for (int shift=7; ; shift+=7) {
+        uint64_t b = *p++;
+        x |= (b & 0x7f) << shift;
+        if (b < 0x80)
+            return x;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Storage policy keeping the rows compressed. Edges added are staged in a
+// CSRStorage, that finalize() compresses and frees.
+//------------------------------------------------------------------------------
+template <class Node, class Weight>
+class CompressedStorage {
+
+    vector<size_t> offsets;     // Row of node x is bytes[offsets[x]..offsets[x+1]-1]
+    vector<uint8_t> bytes;
+    vector<uint32_t> degree;    // Entries of every row
+    vector<Weight> table;       // Distinct weights, the most frequent first
+    CSRStorage<Node,Weight>* staging;
+    size_t spill_bytes;         // Memory of the staged edges, as in CSRStorage::spill
+    string scratch;
+
+    //--------------------------------------------------------------------------
+    // Replaces the rows by rows(x) for every node x, a sorted sequence of
+    // pairs (neighbor, weight) with begin() and end()
+    //--------------------------------------------------------------------------
+    template <class Rows>
+    void encode(size_t n, Rows rows) {
+
+        // Weights by decreasing frequency, so that the frequent ones take a byte
+        unordered_map<Weight,size_t> count;
+        for (size_t x=0; x<n; x++) {
+            auto r = rows(x);
+            for (auto it=r.first; it != r.second; ++it)
+                count[it->second]++;
+        }
+        vector<pair<size_t,Weight> > freq;
+        for (auto it=count.begin(); it != count.end(); ++it)
+            freq.push_back(make_pair(it->second, it->first));
+        sort(freq.begin(), freq.end(), [](const pair<size_t,Weight> &a, const pair<size_t,Weight> &b) {
+            return a.first > b.first || (a.first == b.first && a.second < b.second);
+        });
+        unordered_map<Weight,uint64_t> index;
+        table.clear();
+        for (size_t i=0; i<freq.size(); i++) {
+            index[freq[i].second] = i;
+            table.push_back(freq[i].second);
+        }
+        if (table.empty())
+            table.push_back(0);
+        unordered_map<Weight,size_t>().swap(count);
+
+        vector<uint8_t> out;
+        vector<size_t> first(n+1, 0);
+        vector<uint32_t> deg(n, 0);
+        Weight lastw = table[0];        // Weights repeat, skip their lookup
+        uint64_t lasti = 0;
+        for (size_t x=0; x<n; x++) {
+            first[x] = out.size();
+            uint64_t prev = 0;
+            auto r = rows(x);
+            for (auto it=r.first; it != r.second; ++it) {
+                if (it->second != lastw) {
+                    lastw = it->second;
+                    lasti = index[lastw];
+                }
+                put_varint(out, (uint64_t)it->first - prev);
+                put_varint(out, lasti);
+                prev = it->first;
+                deg[x]++;
+            }
+        }
+        first[n] = out.size();
+        out.resize(out.size() + COMPRESSED_PADDING, 0);
+        out.shrink_to_fit();
+
+        bytes.swap(out);
+        offsets.swap(first);
+        degree.swap(deg);
+    }
+
+public:
+
+    //--------------------------------------------------------------------------
+    // Iterator decoding a row. The entry at p is decoded when the iterator
+    // is built or advanced, except for the ends of the rows.
+    //--------------------------------------------------------------------------
+    class iterator {
+        const uint8_t* p;       // Current entry
+        const uint8_t* next;    // Next entry
+        const Weight* table;
+        pair<Node,Weight> e;
+
+        void decode() {
+            next = p;
+            e.first += (Node)get_varint(next);
+            e.second = table[get_varint(next)];
+        }
+
+    public:
+
+        iterator() : p(NULL), next(NULL), table(NULL) {}
+        iterator(const uint8_t* q) : p(q), next(NULL), table(NULL) {}
+        iterator(const uint8_t* q, const Weight* t) : p(q), table(t), e(0, 0) { decode(); }
+
+        const pair<Node,Weight>* operator->() const { return &e; }
+        iterator& operator++() {
+            p = next;
+            decode();
+            return *this;
+        }
+        iterator& operator++(int) {
+            return ++(*this);
+        }
+        bool operator==(const iterator &x) const { return p == x.p; }
+        bool operator!=(const iterator &x) const { return p != x.p; }
+    };
+
+    CompressedStorage() : staging(NULL), spill_bytes(0) {
+        bytes.assign(COMPRESSED_PADDING, 0);
+        table.assign(1, 0);
+        offsets.assign(1, 0);
+    }
+
+    CompressedStorage(const CompressedStorage&) = delete;
+    CompressedStorage& operator=(const CompressedStorage&) = delete;
+
+    ~CompressedStorage() { delete staging; }
+
+    static const char* name() { return "--- Compressed ----"; }
+
+    // Stages the edges out of core as CSRStorage::spill does
+    void spill(size_t bytes, const char* dir) {
+        assert(staging == NULL);
+        spill_bytes = bytes;
+        scratch = dir != NULL ? dir : "";
+    }
+
+    // New nodes get empty rows
+    void resize(size_t n) {
+        offsets.resize(n+1, offsets.back());
+        degree.resize(n, 0);
+        if (staging != NULL)
+            staging->resize(n);
+    }
+
+    size_t row_size(Node x) { return degree[x]; }
+
+    iterator row_begin(Node x) {
+        assert(staging == NULL);
+        return iterator(bytes.data() + offsets[x], table.data());
+    }
+
+    iterator row_end(Node x) { return iterator(bytes.data() + offsets[x+1]); }
+
+    void add(Node x, Node y, Weight w, bool merge) {
+        if (staging == NULL) {
+            CSRStorage<Node,Weight>* s = new CSRStorage<Node,Weight>();
+            s->resize(degree.size());
+            if (spill_bytes > 0)
+                s->spill(spill_bytes, scratch.c_str());
+            // Current rows, staged again once per edge
+            for (size_t a=0; a<degree.size(); a++)
+                for (iterator it=row_begin(a); it != row_end(a); ++it)
+                    if ((size_t)it->first >= a)
+                        s->add(a, it->first, it->second, true);
+            staging = s;
+        }
+        staging->add(x, y, w, merge);
+    }
+
+    Weight find(Node x, Node y) {
+        for (iterator it=row_begin(x); it != row_end(x); ++it)
+            if (it->first >= y)
+                return it->first == y ? it->second : 0;
+        return 0;
+    }
+
+    // Sorts the staged edges as CSRStorage does, and compresses them
+    void finalize() {
+        if (staging == NULL)
+            return;
+        staging->finalize();
+        CSRStorage<Node,Weight>* s = staging;
+        encode(degree.size(), [s](size_t x) { return make_pair(s->row_begin(x), s->row_end(x)); });
+        delete staging;
+        staging = NULL;
+    }
+
+    void set_rows(vector<vector<pair<Node,Weight> > > &rows) {
+        assert(staging == NULL);
+        encode(rows.size(), [&rows](size_t x) { return make_pair(rows[x].begin(), rows[x].end()); });
+        for (size_t x=0; x<rows.size(); x++)
+            vector<pair<Node,Weight> >().swap(rows[x]);
+    }
+};
+#endif
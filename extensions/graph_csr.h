@@ -0,0 +1,403 @@
+/*
+    graph_csr.h
+
+    Compressed sparse row storage of the neighbors of a graph: the rows of
+    all nodes are consecutive in a single array, sorted by neighbor, so that
+    traversals are sequential in memory and there is no per-edge overhead.
+
+    Graphs with more edges to stage than memory (e.g. VIGs of long clauses)
+    can be built out of core: staged edges are spilled as sorted runs to
+    scratch files, merged into a CSR file and mapped in memory.
+
+*/
+#include <vector>
+#include <queue>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "formula.h"
+
+#ifndef GRAPH_CSR_H
+#define GRAPH_CSR_H
+
+using namespace std;
+
+// Entries are packed to 4 bytes, so that a row entry takes 12 bytes instead
+// of 16 with 64-bit node ids or double weights
+#pragma pack(push, 4)
+template <class Node, class Weight>
+struct csr_entry {
+    Node first;
+    Weight second;
+};
+
+template <class Node, class Weight>
+struct csr_staged {
+    Node x, y;
+    Weight w;
+    bool merge;                 // Otherwise, repetitions keep the first weight
+};
+
+template <class Node, class Weight>
+struct csr_scattered {
+    Node y;
+    Weight w;
+    bool merge;
+};
+#pragma pack(pop)
+
+//------------------------------------------------------------------------------
+// Returns a new scratch file in "dir" (or $TMPDIR, or /tmp, if NULL or empty),
+// already unlinked so that it is removed when closed, or NULL on error
+//------------------------------------------------------------------------------
+FILE* scratch_file(const char* dir) {
+
+    if (dir == NULL || *dir == 0)
+        dir = getenv("TMPDIR");
+    string path = string(dir != NULL && *dir != 0 ? dir : "/tmp") + "/sia-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0)
+        return NULL;
+    unlink(path.c_str());
+    return fdopen(fd, "w+b");
+}
+
+//------------------------------------------------------------------------------
+// Storage policy keeping the neighbors in compressed sparse rows. Edges added
+// are staged and become visible when finalize() sorts them and sums the
+// weights of repeated edges into the rows.
+//------------------------------------------------------------------------------
+template <class Node, class Weight>
+class CSRStorage {
+
+    typedef csr_entry<Node,Weight> entry;
+    typedef csr_staged<Node,Weight> staged;
+    typedef csr_scattered<Node,Weight> scattered;
+
+    vector<size_t> offsets;     // Row of node x is adj[offsets[x]..offsets[x+1]-1]
+    vector<entry> adj;
+    vector<staged> pending;     // Edges not finalized yet, stored once
+
+    size_t cap;                 // Staged edges spilled beyond this number, or 0
+    string scratch;             // Directory of the scratch files
+    vector<FILE*> runs;         // Spilled runs of staged edges, in both directions
+    entry* mapped;              // Rows mapped from a CSR file, instead of adj
+    size_t mapped_size;
+
+    // The rows, in adj or mapped
+    const entry* rows_data() const { return mapped != NULL ? mapped : adj.data(); }
+
+    // Closes the scratch file being written, if any, and throws
+    void scratch_error(FILE* f, const char* what = "Unable to write scratch file in ") {
+        if (f != NULL)
+            fclose(f);
+        throw FormulaError(what + (scratch.empty() ? string("$TMPDIR") : scratch), true);
+    }
+
+    void unmap() {
+        if (mapped != NULL)
+            munmap(mapped, mapped_size);
+        mapped = NULL;
+    }
+
+    //--------------------------------------------------------------------------
+    // Sorts the staged edges by both ends, merging repetitions as finalize()
+    // does, and writes them to a new run
+    //--------------------------------------------------------------------------
+    void spill_run() {
+
+        vector<staged> run;
+        run.reserve(2 * pending.size());
+        for (size_t i=0; i<pending.size(); i++) {
+            run.push_back(pending[i]);
+            if (pending[i].x != pending[i].y) {
+                staged s = pending[i];
+                s.x = pending[i].y;
+                s.y = pending[i].x;
+                run.push_back(s);
+            }
+        }
+        pending.clear();
+
+        stable_sort(run.begin(), run.end(), [](const staged &p, const staged &q) {
+            return p.x < q.x || (p.x == q.x && p.y < q.y);
+        });
+        size_t out = 0;
+        for (size_t i=0; i<run.size(); i++) {
+            if (out > 0 && run[out-1].x == run[i].x && run[out-1].y == run[i].y) {
+                if (run[i].merge) run[out-1].w += run[i].w;
+            } else {
+                run[out++] = run[i];
+            }
+        }
+
+        FILE* f = scratch_file(scratch.c_str());
+        if (f == NULL || fwrite(run.data(), sizeof(staged), out, f) != out)
+            scratch_error(f);
+        rewind(f);
+        runs.push_back(f);
+    }
+
+    //--------------------------------------------------------------------------
+    // Merges the runs into the rows, summing the weights of repeated edges
+    // run by run, and writes them to a CSR file that is mapped in memory.
+    // Runs are read through buffers of about "cap" edges in total.
+    //--------------------------------------------------------------------------
+    void merge_runs() {
+
+        assert(offsets.back() == 0);
+        if (!pending.empty())
+            spill_run();
+
+        size_t n = offsets.size() - 1;
+        size_t k = runs.size();
+        size_t chunk = max((size_t)1024, cap / k);
+        vector<vector<staged> > buf(k);
+        vector<size_t> pos(k, 0), len(k, 0);
+
+        // Next edge of run r at buf[r][pos[r]], refilling it; false at the end
+        auto fill = [&](size_t r) {
+            if (pos[r] < len[r])
+                return true;
+            buf[r].resize(chunk);
+            len[r] = fread(buf[r].data(), sizeof(staged), chunk, runs[r]);
+            pos[r] = 0;
+            return len[r] > 0;
+        };
+
+        typedef pair<pair<Node,Node>,size_t> head;     // Edge and run
+        priority_queue<head, vector<head>, greater<head> > heads;
+        for (size_t r=0; r<k; r++)
+            if (fill(r))
+                heads.push(make_pair(make_pair(buf[r][0].x, buf[r][0].y), r));
+
+        FILE* out = scratch_file(scratch.c_str());
+        if (out == NULL)
+            scratch_error(out);
+        vector<entry> write;
+        write.reserve(chunk);
+        size_t total = 0;
+        vector<size_t> size(n, 0);
+        bool has_last = false;
+        staged last = staged();
+
+        auto flush = [&]() {
+            if (fwrite(write.data(), sizeof(entry), write.size(), out) != write.size())
+                scratch_error(out);
+            write.clear();
+        };
+        auto emit = [&](const staged &s) {
+            entry e;
+            e.first = s.y;
+            e.second = s.w;
+            write.push_back(e);
+            size[s.x]++;
+            total++;
+            if (write.size() == chunk)
+                flush();
+        };
+
+        while (!heads.empty()) {
+            size_t r = heads.top().second;
+            heads.pop();
+            const staged &s = buf[r][pos[r]];
+            if (has_last && last.x == s.x && last.y == s.y) {
+                if (s.merge) last.w += s.w;
+            } else {
+                if (has_last)
+                    emit(last);
+                last = s;
+                has_last = true;
+            }
+            pos[r]++;
+            if (fill(r))
+                heads.push(make_pair(make_pair(buf[r][pos[r]].x, buf[r][pos[r]].y), r));
+        }
+        if (has_last)
+            emit(last);
+        flush();
+
+        for (size_t r=0; r<k; r++)
+            fclose(runs[r]);
+        runs.clear();
+
+        for (size_t x=0; x<n; x++)
+            offsets[x+1] = offsets[x] + size[x];
+        if (total > 0) {
+            fflush(out);
+            mapped_size = total * sizeof(entry);
+            void* p = mmap(NULL, mapped_size, PROT_READ, MAP_SHARED, fileno(out), 0);
+            if (p == MAP_FAILED)
+                scratch_error(out, "Unable to map the CSR file in ");
+            mapped = (entry*)p;
+        }
+        fclose(out);
+    }
+
+public:
+
+    typedef const entry* iterator;
+
+    CSRStorage() : cap(0), mapped(NULL), mapped_size(0) {}
+
+    CSRStorage(const CSRStorage&) = delete;
+    CSRStorage& operator=(const CSRStorage&) = delete;
+
+    ~CSRStorage() {
+        unmap();
+        for (size_t r=0; r<runs.size(); r++)
+            fclose(runs[r]);
+    }
+
+    static const char* name() { return "------- CSR -------"; }
+
+    //--------------------------------------------------------------------------
+    // Keeps the staged edges in about "bytes" of memory (0 for no limit),
+    // spilling sorted runs of them to scratch files in "dir" (see 
+    // scratch_file), that finalize() merges. Only before adding edges.
+    //--------------------------------------------------------------------------
+    void spill(size_t bytes, const char* dir) {
+        assert(pending.empty() && offsets.back() == 0);
+        cap = bytes / (3 * sizeof(staged));     // Edges staged and scattered to both ends
+        if (bytes > 0 && cap == 0)
+            cap = 1;
+        scratch = dir != NULL ? dir : "";
+    }
+
+    // New nodes get empty rows
+    void resize(size_t n) { offsets.resize(n+1, offsets.empty() ? 0 : offsets.back()); }
+
+    size_t row_size(Node x) { return offsets[x+1] - offsets[x]; }
+
+    iterator row_begin(Node x) {
+        assert(pending.empty() && runs.empty());
+        return rows_data() + offsets[x];
+    }
+
+    iterator row_end(Node x) { return rows_data() + offsets[x+1]; }
+
+    void add(Node x, Node y, Weight w, bool merge) {
+        staged s;
+        s.x = x; s.y = y; s.w = w; s.merge = merge;
+        pending.push_back(s);
+        if (cap > 0 && pending.size() >= cap)
+            spill_run();
+    }
+
+    Weight find(Node x, Node y) {
+        iterator first = row_begin(x), last = row_end(x);
+        while (first < last) {
+            iterator mid = first + (last - first) / 2;
+            if (mid->first < y) first = mid + 1;
+            else last = mid;
+        }
+        if (first == row_end(x) || first->first != y) return (0);
+        else return first->second;
+    }
+
+    //--------------------------------------------------------------------------
+    // Merges the staged edges with the rows. Every edge is scattered to the
+    // rows of both ends in the order it was added, and rows are sorted 
+    // stably, so that weights of repeated edges are summed in the order they
+    // were added, as SetStorage does. Peak memory is the staged edges plus 
+    // two scattered entries per edge, never a copy of the whole graph.
+    //--------------------------------------------------------------------------
+    void finalize() {
+
+        if (!runs.empty()) {
+            merge_runs();
+            return;
+        }
+        if (pending.empty())
+            return;
+
+        size_t n = offsets.size() - 1;
+
+        // Row sizes, counting repetitions
+        vector<size_t> first(n+1, 0);
+        for (size_t x=0; x<n; x++)
+            first[x+1] = offsets[x+1] - offsets[x];
+        for (size_t i=0; i<pending.size(); i++) {
+            first[pending[i].x+1]++;
+            if (pending[i].x != pending[i].y) first[pending[i].y+1]++;
+        }
+        for (size_t x=0; x<n; x++)
+            first[x+1] += first[x];
+
+        // Scatter the current rows and then the staged edges
+        vector<scattered> rows(first[n]);
+        vector<size_t> next(first.begin(), first.end()-1);
+        const entry* cur = rows_data();
+        for (size_t x=0; x<n; x++)
+            for (size_t i=offsets[x]; i<offsets[x+1]; i++) {
+                scattered &e = rows[next[x]++];
+                e.y = cur[i].first; e.w = cur[i].second; e.merge = true;
+            }
+        vector<entry>().swap(adj);
+        unmap();
+        for (size_t i=0; i<pending.size(); i++) {
+            const staged &s = pending[i];
+            scattered &e = rows[next[s.x]++];
+            e.y = s.y; e.w = s.w; e.merge = s.merge;
+            if (s.x != s.y) {
+                scattered &f = rows[next[s.y]++];
+                f.y = s.x; f.w = s.w; f.merge = s.merge;
+            }
+        }
+        vector<staged>().swap(pending);
+        vector<size_t>().swap(next);
+
+        // Sort every row and merge repetitions, in place
+        vector<size_t> size(n);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)n; x++) {
+            scattered* b = rows.data() + first[x];
+            scattered* e = rows.data() + first[x+1];
+            stable_sort(b, e, [](const scattered &p, const scattered &q) { return p.y < q.y; });
+            scattered* out = b;
+            for (scattered* it=b; it<e; it++) {
+                if (out > b && (out-1)->y == it->y) {
+                    if (it->merge) (out-1)->w += it->w;
+                } else {
+                    *out++ = *it;
+                }
+            }
+            size[x] = out - b;
+        }
+
+        offsets[0] = 0;
+        for (size_t x=0; x<n; x++)
+            offsets[x+1] = offsets[x] + size[x];
+        adj.resize(offsets[n]);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)n; x++) {
+            for (size_t i=0; i<size[x]; i++) {
+                adj[offsets[x]+i].first = rows[first[x]+i].y;
+                adj[offsets[x]+i].second = rows[first[x]+i].w;
+            }
+        }
+    }
+
+    void set_rows(vector<vector<pair<Node,Weight> > > &rows) {
+        assert(pending.empty() && runs.empty());
+        unmap();
+        offsets.assign(rows.size()+1, 0);
+        for (size_t x=0; x<rows.size(); x++)
+            offsets[x+1] = offsets[x] + rows[x].size();
+        adj.resize(offsets[rows.size()]);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)rows.size(); x++) {
+            for (size_t i=0; i<rows[x].size(); i++) {
+                adj[offsets[x]+i].first = rows[x][i].first;
+                adj[offsets[x]+i].second = rows[x][i].second;
+            }
+            vector<pair<Node,Weight> >().swap(rows[x]);
+        }
+    }
+};
+#endif
@@ -0,0 +1,185 @@
+/*
+    graph_incidence.h
+
+    Storage of a CVIG as the clause-variable incidence relation only: the
+    variables of every clause and, transposed, the clauses of every
+    variable, in compressed sparse rows of node ids without weights. The
+    weight 1/|C| of the edges of clause C is kept once per clause and looked
+    up while iterating, so that the CVIG takes about the memory of the
+    formula instead of a weighted entry per edge and direction.
+
+*/
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+#ifndef GRAPH_INCIDENCE_H
+#define GRAPH_INCIDENCE_H
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Storage policy for bipartite graphs where the edges of a node (a clause)
+// all have the same weight. Edges are added as in CSRStorage, and must go
+// from a variable to a clause node (not merged, see GraphT::add_edge).
+// Other graphs, like the collapsed graphs of the GFA method, can be set with
+// set_rows, and keep a weight per entry.
+//------------------------------------------------------------------------------
+template <class Node, class Weight>
+class IncidenceStorage {
+
+    vector<size_t> offsets;     // Row of node x is ids[offsets[x]..offsets[x+1]-1]
+    vector<Node> ids;
+    vector<Weight> own;         // Weight of the edges of every clause, 0 for variables
+    vector<Weight> weights;     // Weight of every entry, for graphs set by rows
+    bool weighted;              // Set by rows
+    vector<pair<Node,Node> > pending;   // Variable and clause of the edges not finalized
+
+public:
+
+    IncidenceStorage() : weighted(false) {}
+
+    //--------------------------------------------------------------------------
+    // Iterator on a row. The weight is taken from the next entry of a row with
+    // weights, from the clause of the row, or from the clause of the neighbor.
+    //--------------------------------------------------------------------------
+    class iterator {
+        const Node* p;
+        const Weight* w;
+        bool step;              // w advances with p, a row with weights
+        bool byDest;            // w is indexed by the neighbor, a variable row
+        pair<Node,Weight> e;
+
+    public:
+
+        iterator() : p(NULL), w(NULL), step(false), byDest(false) {}
+        iterator(const Node* p2, const Weight* w2, bool s, bool d) :
+            p(p2), w(w2), step(s), byDest(d) {}
+
+        const pair<Node,Weight>* operator->() {
+            e.first = *p;
+            e.second = byDest ? w[*p] : *w;
+            return &e;
+        }
+        iterator& operator++() {
+            ++p;
+            if (step) ++w;
+            return *this;
+        }
+        iterator& operator++(int) {
+            return ++(*this);
+        }
+        bool operator==(const iterator &x) const { return p == x.p; }
+        bool operator!=(const iterator &x) const { return p != x.p; }
+    };
+
+    static const char* name() { return "---- Incidence ----"; }
+
+    // New nodes get empty rows
+    void resize(size_t n) {
+        offsets.resize(n+1, offsets.empty() ? 0 : offsets.back());
+        if (!weighted)
+            own.resize(n, 0);
+    }
+
+    size_t row_size(Node x) { return offsets[x+1] - offsets[x]; }
+
+    iterator row_begin(Node x) {
+        assert(pending.empty());
+        const Node* p = ids.data() + offsets[x];
+        if (weighted)
+            return iterator(p, weights.data() + offsets[x], true, false);
+        if (own[x] != 0)
+            return iterator(p, own.data() + x, false, false);
+        return iterator(p, own.data(), false, true);
+    }
+
+    iterator row_end(Node x) { return iterator(ids.data() + offsets[x+1], NULL, false, false); }
+
+    void add(Node x, Node y, Weight w, bool merge) {
+        assert(!merge && !weighted);
+        pending.push_back(make_pair(x, y));
+        own[y] = w;
+    }
+
+    Weight find(Node x, Node y) {
+        const Node* first = ids.data() + offsets[x];
+        const Node* last = ids.data() + offsets[x+1];
+        const Node* it = lower_bound(first, last, y);
+        if (it == last || *it != y) return (0);
+        if (weighted) return weights[it - ids.data()];
+        return own[x] != 0 ? own[x] : own[y];
+    }
+
+    //--------------------------------------------------------------------------
+    // Scatters the staged edges to the rows of both ends, and sorts every row
+    // removing repetitions (variables repeated in a clause)
+    //--------------------------------------------------------------------------
+    void finalize() {
+
+        if (pending.empty())
+            return;
+
+        size_t n = offsets.size() - 1;
+
+        vector<size_t> first(n+1, 0);
+        for (size_t x=0; x<n; x++)
+            first[x+1] = offsets[x+1] - offsets[x];
+        for (size_t i=0; i<pending.size(); i++) {
+            first[pending[i].first+1]++;
+            first[pending[i].second+1]++;
+        }
+        for (size_t x=0; x<n; x++)
+            first[x+1] += first[x];
+
+        vector<Node> rows(first[n]);
+        vector<size_t> next(first.begin(), first.end()-1);
+        for (size_t x=0; x<n; x++)
+            for (size_t i=offsets[x]; i<offsets[x+1]; i++)
+                rows[next[x]++] = ids[i];
+        vector<Node>().swap(ids);
+        for (size_t i=0; i<pending.size(); i++) {
+            rows[next[pending[i].first]++] = pending[i].second;
+            rows[next[pending[i].second]++] = pending[i].first;
+        }
+        vector<pair<Node,Node> >().swap(pending);
+        vector<size_t>().swap(next);
+
+        vector<size_t> size(n);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)n; x++) {
+            Node* b = rows.data() + first[x];
+            Node* e = rows.data() + first[x+1];
+            sort(b, e);
+            size[x] = unique(b, e) - b;
+        }
+
+        offsets[0] = 0;
+        for (size_t x=0; x<n; x++)
+            offsets[x+1] = offsets[x] + size[x];
+        ids.resize(offsets[n]);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)n; x++)
+            copy(rows.begin() + first[x], rows.begin() + first[x] + size[x], ids.begin() + offsets[x]);
+    }
+
+    void set_rows(vector<vector<pair<Node,Weight> > > &rows) {
+        assert(pending.empty());
+        offsets.assign(rows.size()+1, 0);
+        for (size_t x=0; x<rows.size(); x++)
+            offsets[x+1] = offsets[x] + rows[x].size();
+        ids.resize(offsets[rows.size()]);
+        weights.resize(offsets[rows.size()]);
+        weighted = true;
+        vector<Weight>().swap(own);
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)rows.size(); x++) {
+            for (size_t i=0; i<rows[x].size(); i++) {
+                ids[offsets[x]+i] = rows[x][i].first;
+                weights[offsets[x]+i] = rows[x][i].second;
+            }
+            vector<pair<Node,Weight> >().swap(rows[x]);
+        }
+    }
+};
+#endif
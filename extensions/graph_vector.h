@@ -26,242 +26,96 @@ Contact: jgiraldez@iiia.csic.es
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <vector>
-#include <assert.h>
-#include <iostream>
-#include <iterator>
-#include <algorithm>
 
-#ifndef Graph_H
-#define Graph_H
+#ifndef GRAPH_VECTOR_H
+#define GRAPH_VECTOR_H
 
 using namespace std;
 
-bool mysort(pair<int,double> x, pair<int,double> y){ 
-    return x.first<y.first;}
+#ifndef EDGE_EPSILON
+#define EDGE_EPSILON 1e-9
+#endif
 
-class Graph {
+//------------------------------------------------------------------------------
+// Storage policy keeping the neighbors of each node in a vector, in insertion
+// order. Repeated edges are found by a linear search.
+//------------------------------------------------------------------------------
+template <class Node, class Weight>
+class VectorStorage {
 
-    private:
+    typedef vector<pair<Node,Weight> > row;
 
-        int nnodes;                        // Number of nodes
-        int typeA;
-        double tarity;                      // Sum of the arities
-        vector <double> narity;             // Arity of each node
-        vector <vector<pair<int, double> > > neigh;
+    vector<row> neigh;  // For each node, a list of its neighbors
 
-        vector< pair <int,double> >::iterator myfind(
-                vector<pair<int, double> >::iterator first,
-                vector<pair<int, double> >::iterator last, 
-                int x
-        ){
+    typename row::iterator myfind(
+            typename row::iterator first,
+            typename row::iterator last, 
+            Node x
+    ){
 
-            for (; first != last; first++)
-                if (first->first == x) return first;
-            return last;
-        }
+        for (; first != last; first++)
+            if (first->first == x) return first;
+        return last;
+    }
 
-    public:
+public:
 
-        Graph() : tarity(0), narity(0), nnodes(0), neigh(0) {}
-        Graph(int n, int m){
-            tarity = 0;
-            typeA = n;
-            narity.resize(n+m, 0); 
-            neigh.resize(n+m); 
-            nnodes = n+m;
-        }
+    typedef typename row::const_iterator iterator;
 
-        ~Graph(){
-            narity.clear();
-            neigh.clear();  
-        }
+    static const char* name() { return "----- VECTOR ------"; }
 
-        double arity(int x) {     
-            assert(x>=0 && x<= nnodes-1); 
-            return narity[x]; 
-        }
-        
-        int nNeighs(int x){
-            return neigh[x].size();
-        }
-        
-        int getTypeA(){
-            return typeA;
-        }
+    void resize(size_t n) { neigh.resize(n); }
 
-        int size() { return nnodes; }
+    size_t row_size(Node x) { return neigh[x].size(); }
 
-        double arity() { return tarity; }
+    iterator row_begin(Node x) { return neigh[x].begin(); }
 
-        void add_edge(int x, int y) { add_edge(x,y,1); };
+    iterator row_end(Node x) { return neigh[x].end(); }
 
-        void add_edge(int x, int y, double w) {
-            assert(x>=0 && x<= nnodes-1); 
-            assert(y>=0 && y<= nnodes-1); 
-            narity[x] += w;
-            narity[y] += w;
-            tarity += 2 * w;
-            vector<pair<int,double> >::iterator it = myfind(neigh[x].begin(), neigh[x].end(), y);
-            if (y>=typeA || it == neigh[x].end()) {
-                neigh[x].push_back(pair<int,double>(y,w));
-                if (x != y) neigh[y].push_back(pair<int,double>(x,w));
-            }
-            else {
+    void add(Node x, Node y, Weight w, bool merge) {
+        typename row::iterator it = neigh[x].end();
+        if (merge) it = myfind(neigh[x].begin(), neigh[x].end(), y);
+        if (it == neigh[x].end()) {
+            neigh[x].push_back(pair<Node,Weight>(y,w));
+            if (x != y) neigh[y].push_back(pair<Node,Weight>(x,w));
+        }
+        else {
+            it->second += w;
+            if (x != y) {
+                it = myfind(neigh[y].begin(),neigh[y].end(),x);
                 it->second += w;
-                if (x != y) {
-                    it = myfind(neigh[y].begin(),neigh[y].end(),x);
-                    it->second += w;
-                }
             }
         }
-
-        double connected(int x, int y) {
-            assert(x>=0 && x<= nnodes-1); 
-            assert(y>=0 && y<= nnodes-1); 
-            vector<pair<int,double> >::iterator it = myfind(neigh[x].begin(), neigh[x].end(), y);
-            if(it == neigh[x].end()) return (0);
-            else return it->second;
-        }
-
-        /* //CHANGED
-        void order(){
-            for(int i=0; i<nnodes; i++)
-                sort(neigh[i].begin(), neigh[i].end(), mysort);
-        }
-        */
-
-        void print() {
-            cerr <<"------ GRAPH ------\n";
-            cerr <<"----- VECTOR ------\n";
-            cerr <<"NNodes = "<<nnodes<<endl;
-            cerr <<"TArity = "<<tarity<<endl;
-            for(int i=0; i<nnodes; i++){
-                cerr << i << " --> ";
-                for(vector<pair<int,double> >::iterator it=neigh[i].begin(); it!=neigh[i].end(); ++it)
-                    //if (i <= it->first) 
-                        cerr << it->first << " (" << it->second << ") ";
-                cerr << endl;
-            }
+    }
+
+    // Subtracts w from edge x-y, erasing it when nothing is left
+    void remove(Node x, Node y, Weight w) {
+        Node ends[2] = {x, y};
+        for (int i=0; i < (x != y ? 2 : 1); i++) {
+            row &r = neigh[ends[i]];
+            typename row::iterator it = myfind(r.begin(), r.end(), ends[1-i]);
+            if (it == r.end())
+                continue;
+            it->second -= w;
+            if (!(it->second > EDGE_EPSILON * w))
+                r.erase(it);
         }
+    }
 
-        //--------------- ITERATOR ON EDGES ------------------------------------
-
-        typedef struct {int orig, dest; double weight;} edge;
-
-        class EdgeIter;                          // Iterator to traverse all EDGES of the Graph
-        friend class EdgeIter;
+    Weight find(Node x, Node y) {
+        typename row::iterator it = myfind(neigh[x].begin(), neigh[x].end(), y);
+        if(it == neigh[x].end()) return (0);
+        else return it->second;
+    }
 
-        class EdgeIter : public iterator<input_iterator_tag, edge> {
-            Graph &g;
-            vector <pair <int,double> >::iterator it;
-            int node;
-            Graph::edge e;
-
-            public:
-
-                EdgeIter(Graph &x) : g(x){}
-                EdgeIter(Graph &x, vector<pair<int,double> >::iterator y, int n): g(x), it(y), node(n) { };
-
-                EdgeIter (const EdgeIter &x) : g(x.g), it(x.it), node(x.node) {}
-
-                EdgeIter& operator++() {
-                    assert(node >= 0 && node < g.nnodes);
-                    assert(node < g.nnodes-1 || it != g.neigh[node].end()); 
-                    do {
-                        if (++it == g.neigh[node].end() && node < g.nnodes-1) {
-                            do {
-                                node++; 
-                                it = g.neigh[node].begin(); 
-                            }
-                            while (it == g.neigh[node].end() && node < g.nnodes-1); //skip nodes without neighs
-                        }
-                    }
-                    while (!(it == g.neigh[node].end() && node == g.nnodes-1)   //skip when orig > dest
-                        && node > it->first);
-                    return *this;
-                }
-                EdgeIter& operator++(int) {
-                    EdgeIter clone(*this);
-                    assert(node >= 0 && node < g.nnodes);
-                    assert(node < g.nnodes-1 || it != g.neigh[node].end()); 
-                    do {
-                        if (++it == g.neigh[node].end() && node < g.nnodes-1) {
-                            do {
-                                node++; 
-                                it = g.neigh[node].begin(); 
-                            }
-                            while (it == g.neigh[node].end() && node < g.nnodes-1); //skip nodes without neighs
-                        }
-                    }
-                    while (!(it == g.neigh[node].end() && node == g.nnodes-1)   //skip when orig > dest
-                        && node > it->first);
-                    return *this;
-                }
-
-                bool operator==(const EdgeIter &rhs) {return it==rhs.it;}
-                bool operator!=(const EdgeIter &rhs) {return it!=rhs.it;}
-
-                Graph::edge& operator*() {
-                    cerr<<"ENTER *\n";
-                    e.orig = node; 
-                    e.dest = it->first; 
-                    e.weight = it->second; 
-                    return e;
-                }
-                Graph::edge *operator->() {
-                    e.orig = node; 
-                    e.dest = it->first; 
-                    e.weight = it->second; 
-                    return &e;
-                }
-        };
-
-        EdgeIter begin() {
-            int node = 0;
-            while (neigh[node].size()==0 && node < nnodes) node++;
-            return EdgeIter(*this, neigh[node].begin(), node);  
-        // First neight of first node
-        }
-
-        EdgeIter end() {
-            return EdgeIter(*this, neigh[nnodes-1].end(), nnodes);  
-        // Last neight of last node
-        }
-
-        //--------------- ITERATOR ON NEIGHBORS --------------------------------
-
-        class NeighIter : public vector<pair<int,double> >::iterator {
-            vector<pair <int,double> >::iterator it;
-            Graph::edge e;
-            public:
-
-                NeighIter(vector<pair<int,double> >::iterator x) : it(x){}
-                
-                Graph::edge *operator->() {
-                    e.dest = it->first; 
-                    e.weight = it->second; 
-                    return &e;
-                }
-                NeighIter& operator++() {
-                    ++it;
-                    return *this;
-                }
-                NeighIter& operator++(int) {
-                    it++;
-                    return *this;
-                }
-                bool operator==(const NeighIter& x) {return it==x.it;}
-                bool operator!=(const NeighIter& x) {return it!=x.it;}
-        };
-
-        NeighIter begin(int x) { 
-            assert(x>=0 && x<= nnodes-1); 
-            return (NeighIter)neigh[x].begin(); 
-        }
+    void finalize() {}
 
-        NeighIter end(int x) { 
-            assert(x>=0 && x<= nnodes-1); 
-            return (NeighIter)neigh[x].end(); 
+    void set_rows(vector<row> &rows) {
+        #pragma omp parallel for schedule(dynamic,1024)
+        for (long long x=0; x<(long long)rows.size(); x++) {
+            neigh[x].swap(rows[x]);
+            row().swap(rows[x]);
         }
+    }
 };
-#endif
\ No newline at end of file
+#endif
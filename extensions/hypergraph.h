@@ -0,0 +1,442 @@
+/*
+    hypergraph.h
+
+    Modularity of the clause hypergraph of a formula, optimized by a Louvain
+    method that works on the clauses directly. A clause of k literals weighs
+    2/(k(k-1)) between every pair of its variables, as in the VIG, so that
+    the modularity of a partition is the one of the VIG. But the VIG is never
+    built: the memory is linear in the size of the formula, instead of
+    quadratic in the length of the clauses.
+
+*/
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "formula.h"
+#include "community.h"
+#include "budget.h"
+
+#ifndef HYPERGRAPH_H
+#define HYPERGRAPH_H
+
+using namespace std;
+
+// Edges with more pins keep the multiplicity of every community in them while
+// moving nodes, so that gathering weights is linear in the communities of an
+// edge instead of in its pins
+#define HYPER_COUNTS 16
+
+template <class node> class HyperCommunity;
+
+//------------------------------------------------------------------------------
+// Hypergraph with weighted hyperedges, whose pins are nodes with a
+// multiplicity (a variable repeated in a clause, or several nodes collapsed
+// into one). Pairs of pins of an edge of weight w are linked with weight w.
+//------------------------------------------------------------------------------
+template <class node = uint32_t>
+class Hypergraph {
+
+    node nnodes;
+    vector<size_t> efirst;              // Pins of edge e are pins[efirst[e]..efirst[e+1]-1]
+    vector<pair<node,uint32_t> > pins;  // Node and multiplicity
+    vector<double> eweight;
+    vector<size_t> nfirst;              // Pins of node x are incid[nfirst[x]..nfirst[x+1]-1]
+    vector<size_t> incid;
+    vector<node> pin_edge;              // Edge of every pin
+    vector<double> narity;              // Arity of each node
+    double tarity;                      // Sum of the arities
+
+    friend class HyperCommunity<node>;
+
+    public:
+
+        typedef node node_t;
+
+        Hypergraph(node n) : nnodes(n), efirst(1, 0), narity(n, 0), tarity(0) {}
+
+        node size() { return nnodes; }
+
+        size_t edges() { return eweight.size(); }
+
+        double arity(node x) { return narity[x]; }
+
+        double arity() { return tarity; }
+
+        //----------------------------------------------------------------------
+        // Adds an edge of weight w on the nodes of "members", that may repeat.
+        // Edges with less than two pins have no pairs and are disregarded.
+        //----------------------------------------------------------------------
+        template <class T>
+        void add_edge(vector<T> members, double w) {
+            if (members.size() < 2)
+                return;
+            sort(members.begin(), members.end());
+            size_t k = members.size();
+            for (size_t i=0; i<k; ) {
+                size_t j = i;
+                while (j < k && members[j] == members[i]) j++;
+                pins.push_back(make_pair((node)members[i], (uint32_t)(j-i)));
+                narity[members[i]] += w * (j-i) * (k-1);
+                i = j;
+            }
+            tarity += w * k * (k-1);
+            efirst.push_back(pins.size());
+            eweight.push_back(w);
+        }
+
+        // Adds a clause (variables numbered from 0) with the VIG weights
+        template <class T>
+        void add_clause(vector<T> &clause) {
+            if (clause.size() > 1)
+                add_edge(clause, 2.0 / (clause.size() * (clause.size()-1)));
+        }
+
+        //----------------------------------------------------------------------
+        // Builds the pins of every node. Must be called once the edges are added
+        //----------------------------------------------------------------------
+        void finalize() {
+            nfirst.assign(nnodes+1, 0);
+            pin_edge.resize(pins.size());
+            for (size_t e=0; e<eweight.size(); e++)
+                for (size_t p=efirst[e]; p<efirst[e+1]; p++) {
+                    pin_edge[p] = e;
+                    nfirst[pins[p].first+1]++;
+                }
+            for (node x=0; x<nnodes; x++)
+                nfirst[x+1] += nfirst[x];
+            incid.resize(pins.size());
+            vector<size_t> next(nfirst.begin(), nfirst.end()-1);
+            for (size_t p=0; p<pins.size(); p++)
+                incid[next[pins[p].first]++] = p;
+        }
+
+        //----------------------------------------------------------------------
+        // Weight of the pairs of pins inside the communities of "n2c"
+        //----------------------------------------------------------------------
+        double inner(vector<node> &n2c) {
+            double w = 0;
+            vector<double> cnt(nnodes, 0);
+            vector<node> touched;
+            for (size_t e=0; e<eweight.size(); e++) {
+                for (size_t p=efirst[e]; p<efirst[e+1]; p++) {
+                    node c = n2c[pins[p].first];
+                    if (cnt[c] == 0) touched.push_back(c);
+                    cnt[c] += pins[p].second;
+                }
+                double pairs = 0;
+                for (size_t i=0; i<touched.size(); i++) {
+                    pairs += cnt[touched[i]] * (cnt[touched[i]] - 1) / 2;
+                    cnt[touched[i]] = 0;
+                }
+                touched.clear();
+                w += eweight[e] * pairs;
+            }
+            return w;
+        }
+
+        //----------------------------------------------------------------------
+        // Returns the hypergraph whose nodes are the communities of "n2c",
+        // numbered in [0..ncomm-1]. Edges inside a community are dropped, as
+        // they do not change when nodes are moved; node arities are kept.
+        //----------------------------------------------------------------------
+        Hypergraph* collapse(vector<node> &n2c, node ncomm) {
+            Hypergraph* h = new Hypergraph(ncomm);
+            for (node x=0; x<nnodes; x++)
+                h->narity[n2c[x]] += narity[x];
+            h->tarity = tarity;
+            vector<node> members;
+            for (size_t e=0; e<eweight.size(); e++) {
+                members.clear();
+                for (size_t p=efirst[e]; p<efirst[e+1]; p++)
+                    members.insert(members.end(), pins[p].second, n2c[pins[p].first]);
+                sort(members.begin(), members.end());
+                if (members.front() == members.back())
+                    continue;
+                size_t k = members.size();
+                for (size_t i=0; i<k; ) {
+                    size_t j = i;
+                    while (j < k && members[j] == members[i]) j++;
+                    h->pins.push_back(make_pair(members[i], (uint32_t)(j-i)));
+                    i = j;
+                }
+                h->efirst.push_back(h->pins.size());
+                h->eweight.push_back(eweight[e]);
+            }
+            h->finalize();
+            return h;
+        }
+};
+
+//------------------------------------------------------------------------------
+// Communities of a Hypergraph, found by the GFA (Louvain) method: nodes are
+// moved to the community of greatest modularity gain, with the weights to
+// every community gathered from the pins of their edges, and communities
+// are collapsed into nodes while modularity improves.
+//------------------------------------------------------------------------------
+template <class node = uint32_t>
+class HyperCommunity {
+
+    typedef Hypergraph<node> H;
+
+    public:
+
+        H* h;
+        Random* rng;                // Generator of the node orders, rand() if NULL
+        Budget* budget;             // Stops the local moving when exhausted, none if NULL
+        vector<node> n2c;           // Community of every node
+        node ncomm;
+        int iterations;
+        long long visits;           // Nodes evaluated for a move
+        vector<vector<node> > levels;
+
+        HyperCommunity(H* h2) : h(h2), rng(NULL), budget(NULL), n2c(h2->size()), ncomm(h2->size()),
+                                iterations(0), visits(0) {
+            for (node i=0; i<h->size(); i++)
+                n2c[i] = i;
+        }
+
+        double modularity() {
+            if (h->arity() == 0)
+                return 0;
+            vector<double> aritym(h->size(), 0);
+            for (node i=0; i<h->size(); i++)
+                aritym[n2c[i]] += h->arity(i);
+            double a = 0;
+            for (node i=0; i<h->size(); i++)
+                a += aritym[i] * aritym[i] / h->arity() / h->arity();
+            return 2 * h->inner(n2c) / h->arity() - a;
+        }
+
+        //----------------------------------------------------------------------
+        // Computes "n2c" applying one_level() while modularity improves more
+        // than "precision", and collapsing communities into nodes. If the
+        // budget is exhausted, keeps the partition found so far.
+        //----------------------------------------------------------------------
+        double compute_modularity(double precision) {
+
+            H* g = h;
+            double q = modularity();
+            while (true) {
+                vector<node> part(g->size());
+                for (node i=0; i<g->size(); i++)
+                    part[i] = i;
+                bool moved = one_level(g, part);
+
+                // Communities renumbered in [0..k-1]
+                vector<node> ren(g->size(), (node)-1);
+                node k = 0;
+                for (node i=0; i<g->size(); i++) {
+                    if (ren[part[i]] == (node)-1) ren[part[i]] = k++;
+                    part[i] = ren[part[i]];
+                }
+                vector<node> n2c2(n2c.size());
+                for (size_t i=0; i<n2c.size(); i++)
+                    n2c2[i] = part[n2c[i]];
+                n2c.swap(n2c2);
+                double q2 = modularity();
+                if (!moved || q2 - q <= precision || k == g->size() ||
+                    (budget != NULL && budget->expired())) {
+                    if (q2 < q)
+                        n2c.swap(n2c2);
+                    else
+                        q = q2;
+                    break;
+                }
+                q = q2;
+                ncomm = k;
+                levels.push_back(n2c);
+                H* g2 = g->collapse(part, k);
+                if (g != h) delete g;
+                g = g2;
+                if(verbose)
+                    cerr <<"\tQ = "<<q<<" #comm = "<<ncomm<<endl;
+            }
+            if (g != h) delete g;
+
+            // Communities renumbered in [0..ncomm-1]
+            vector<node> ren(n2c.size(), (node)-1);
+            ncomm = 0;
+            for (size_t i=0; i<n2c.size(); i++) {
+                if (ren[n2c[i]] == (node)-1) ren[n2c[i]] = ncomm++;
+                n2c[i] = ren[n2c[i]];
+            }
+            if (levels.empty() || levels.back() != n2c)
+                levels.push_back(n2c);
+            return q;
+        }
+
+    private:
+
+        // Multiplicity of every community in the long edges (see HYPER_COUNTS)
+        vector<size_t> longid;
+        vector<vector<pair<node,uint32_t> > > counts;
+
+        void count(size_t e, node c, long long m) {
+            vector<pair<node,uint32_t> > &v = counts[longid[e]];
+            for (size_t i=0; i<v.size(); i++)
+                if (v[i].first == c) {
+                    v[i].second += m;
+                    if (v[i].second == 0) {
+                        v[i] = v.back();
+                        v.pop_back();
+                    }
+                    return;
+                }
+            v.push_back(make_pair(c, (uint32_t)m));
+        }
+
+        //----------------------------------------------------------------------
+        // Adds to wc[c] the weight from x to the other nodes of community c in
+        // "part", appending to "nc" the communities not in it yet (wc[c] == -1)
+        //----------------------------------------------------------------------
+        void neighbor_weights(H* g, node x, vector<node> &part, vector<double> &wc, vector<node> &nc) {
+            for (size_t i=g->nfirst[x]; i<g->nfirst[x+1]; i++) {
+                size_t p = g->incid[i];
+                size_t e = g->pin_edge[p];
+                uint32_t m = g->pins[p].second;
+                double w = g->eweight[e] * m;
+                if (longid[e] != (size_t)-1) {
+                    vector<pair<node,uint32_t> > &v = counts[longid[e]];
+                    for (size_t j=0; j<v.size(); j++) {
+                        node c = v[j].first;
+                        double k = v[j].second - (c == part[x] ? m : 0);
+                        if (k == 0)
+                            continue;
+                        if (wc[c] == -1) {
+                            wc[c] = 0;
+                            nc.push_back(c);
+                        }
+                        wc[c] += w * k;
+                    }
+                    continue;
+                }
+                for (size_t q=g->efirst[e]; q<g->efirst[e+1]; q++) {
+                    if (q == p)
+                        continue;
+                    node c = part[g->pins[q].first];
+                    if (wc[c] == -1) {
+                        wc[c] = 0;
+                        nc.push_back(c);
+                    }
+                    wc[c] += w * g->pins[q].second;
+                }
+            }
+        }
+
+        //----------------------------------------------------------------------
+        // Moves the nodes of "g" between the communities "part" in random
+        // order, until a sweep moves none or the budget is exhausted.
+        // Returns "true" if some node moved.
+        //----------------------------------------------------------------------
+        bool one_level(H* g, vector<node> &part) {
+
+            bool improved = false;
+            long long moved;
+            vector<node> order(g->size());
+            for (node i=0; i<g->size(); i++)
+                order[i] = i;
+            vector<double> arity(g->size()), wc(g->size(), -1);
+            for (node i=0; i<g->size(); i++)
+                arity[i] = g->arity(i);
+            vector<node> nc;
+            vector<double> nw, na;
+
+            longid.assign(g->edges(), (size_t)-1);
+            counts.clear();
+            for (size_t e=0; e<g->edges(); e++)
+                if (g->efirst[e+1] - g->efirst[e] > HYPER_COUNTS) {
+                    longid[e] = counts.size();
+                    counts.push_back(vector<pair<node,uint32_t> >());
+                    for (size_t p=g->efirst[e]; p<g->efirst[e+1]; p++)
+                        count(e, part[g->pins[p].first], g->pins[p].second);
+                }
+
+            bool stopped = false;
+            do {
+                iterations++;
+                shuffle(order, rng);
+                moved = 0;
+                for (node i=0; i<g->size(); i++) {
+                    if (budget != NULL && visits % BUDGET_POLL == 0 && budget->expired()) {
+                        stopped = true;
+                        break;
+                    }
+                    node x = order[i];
+                    visits++;
+                    arity[part[x]] -= g->arity(x);
+
+                    neighbor_weights(g, x, part, wc, nc);
+                    nw.resize(nc.size());
+                    na.resize(nc.size());
+                    for (size_t j=0; j<nc.size(); j++) {
+                        nw[j] = wc[nc[j]];
+                        na[j] = arity[nc[j]];
+                        wc[nc[j]] = -1;
+                    }
+                    int best = best_community(nw.data(), na.data(), nc.size(),
+                                              g->arity(x), g->arity());
+                    node best_c = (best < 0) ? part[x] : nc[best];
+                    if (best_c != part[x]) {
+                        moved++;
+                        improved = true;
+                        for (size_t j=g->nfirst[x]; j<g->nfirst[x+1]; j++) {
+                            size_t p = g->incid[j];
+                            if (longid[g->pin_edge[p]] != (size_t)-1) {
+                                count(g->pin_edge[p], part[x], -(long long)g->pins[p].second);
+                                count(g->pin_edge[p], best_c, g->pins[p].second);
+                            }
+                        }
+                        part[x] = best_c;
+                    }
+                    arity[best_c] += g->arity(x);
+                    nc.clear();
+                }
+            } while (moved > 0 && !stopped);
+            vector<size_t>().swap(longid);
+            counts.clear();
+            return improved;
+        }
+};
+
+//------------------------------------------------------------------------------
+// Given a CNF formula (see formula.h), creates its clause hypergraph
+// disregarding clauses of size greater than MAXCLAUSE. Throws a FormulaError
+// if it cannot be read.
+//------------------------------------------------------------------------------
+template <class node = uint32_t>
+Hypergraph<node>* readHypergraph(const FormulaSource &filename, int MAXCLAUSE) {
+
+    FormulaReader reader(filename);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filename.name(), true);
+
+    long long totVars=0, totClauses=0;
+    int var=0;
+
+    // Skip comments and read the head
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filename.name());
+
+    Hypergraph<node>* h = new Hypergraph<node>(totVars);
+    vector<int> clause;
+
+    while(reader.next(var)) {
+        if (var==0) {
+            if (clause.size() <= (size_t)MAXCLAUSE)
+                h->add_clause(clause);
+            else if(verbose)
+                cerr << "\tDisregarded clause of size " << clause.size() << endl;
+            clause.clear();
+        } else {
+            if (abs(var) > totVars) {
+                delete h;
+                throw FormulaError("Unvalid variable number " + to_string(abs(var)));
+            }
+            clause.push_back(abs(var)-1);
+        }
+    }
+    h->finalize();
+    return h;
+}
+
+#endif
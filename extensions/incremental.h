@@ -0,0 +1,255 @@
+/*
+    incremental.h
+
+    Graphs of formulas whose clauses are added and removed over time, e.g.
+    learned clauses along a solver run. The VIG or CVIG is updated in place,
+    and the modularity of a tracked partition is maintained at a cost 
+    proportional to the change, refining the partition only around the 
+    nodes whose edges changed.
+
+*/
+#include <vector>
+#include "graph.h"
+#include "tools.h"
+#include "community.h"
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+using namespace std;
+
+template <class G>
+class IncrementalGraph {
+
+    typedef typename G::node_t node;
+
+    bool cvig;
+    int max_clause;
+    vector<vector<int> > clauses;   // Variables (numbered from 0) of every clause
+    vector<bool> active;            // Clause added and not removed yet
+
+    // Tracked partition
+    bool tracking;
+    vector<node> n2c;
+    vector<double> tot;             // tot[c] = Sum of the arities of community c
+    double win;                     // Weight of the edges inside communities
+    double s2;                      // Sum of tot[c]^2
+    vector<node> queue;             // Nodes whose edges changed since last refine()
+    vector<bool> queued;
+
+    void change_tot(node c, double d) {
+        s2 -= tot[c] * tot[c];
+        tot[c] += d;
+        s2 += tot[c] * tot[c];
+    }
+
+    void touch(node x) {
+        if (!queued[x]) {
+            queued[x] = true;
+            queue.push_back(x);
+        }
+    }
+
+    // Accounts the change of weight w of edge x-y in the tracked partition
+    void update(node x, node y, double w) {
+        node cx = n2c[x], cy = n2c[y];
+        change_tot(cx, w);
+        change_tot(cy, w);
+        if (cx == cy) win += w;
+        touch(x);
+        touch(y);
+    }
+
+    bool usable(vector<int> &clause) {
+        return clause.size() <= (size_t)max_clause && (cvig ? clause.size() > 0 : clause.size() > 1);
+    }
+
+    public:
+
+        typedef node node_t;
+
+        G* g;
+        long long moves;            // Nodes moved by refine()
+        long long evaluated;        // Nodes evaluated by refine()
+
+        //----------------------------------------------------------------------
+        // Empty formula over n variables. Clauses longer than max_clause are 
+        // kept but disregarded, as in readVIG and readCVIG.
+        //----------------------------------------------------------------------
+        IncrementalGraph(int n, bool cvig2, int max_clause2) {
+            cvig = cvig2;
+            max_clause = max_clause2;
+            g = new G(n, 0);
+            queued.resize(n, false);
+            tracking = false;
+            win = s2 = 0;
+            moves = evaluated = 0;
+        }
+
+        ~IncrementalGraph() {
+            delete g;
+        }
+
+        // Number of variables of the formula
+        int variables() { return g->getTypeA(); }
+
+        // Number of clauses added, including the removed ones
+        size_t clause_count() { return clauses.size(); }
+
+        bool is_active(size_t index) { return index < clauses.size() && active[index]; }
+
+        // Edge hooks for addClauseVIG and friends
+        void add_edge(node x, node y, double w) {
+            g->add_edge(x, y, w);
+            if (tracking) update(x, y, w);
+        }
+
+        void remove_edge(node x, node y, double w) {
+            g->remove_edge(x, y, w);
+            if (tracking) update(x, y, -w);
+        }
+
+        //----------------------------------------------------------------------
+        // Adds a clause (variables numbered from 0), that in the CVIG gets a
+        // new node. Returns its index, used to remove it.
+        //----------------------------------------------------------------------
+        size_t add_clause(vector<int> &clause) {
+
+            size_t index = clauses.size();
+            clauses.push_back(clause);
+            active.push_back(true);
+            if (cvig) {
+                node c = g->add_nodes(1);
+                queued.push_back(false);
+                if (tracking) {
+                    n2c.push_back(tot.size());
+                    tot.push_back(0);
+                }
+                if (usable(clause))
+                    addClauseCVIG(this, clause, c);
+            } else if (usable(clause)) {
+                addClauseVIG(this, clause);
+            }
+            return index;
+        }
+
+        //----------------------------------------------------------------------
+        // Removes the clause of the given index. Its CVIG node is left without
+        // edges. Returns false if there is no such clause.
+        //----------------------------------------------------------------------
+        bool remove_clause(size_t index) {
+
+            if (index >= clauses.size() || !active[index])
+                return false;
+            active[index] = false;
+            if (usable(clauses[index])) {
+                if (cvig)
+                    removeClauseCVIG(this, clauses[index], (node)(variables() + index));
+                else
+                    removeClauseVIG(this, clauses[index]);
+            }
+            vector<int>().swap(clauses[index]);
+            return true;
+        }
+
+        //----------------------------------------------------------------------
+        // Starts tracking the partition found by the GFA method
+        //----------------------------------------------------------------------
+        void track(double precision) {
+
+            Community<G> c(g);
+            c.compute_modularity_GFA(precision);
+            n2c = c.n2c;
+
+            tot.assign(g->size(), 0);
+            win = 0;
+            for (node i=0; i<g->size(); i++)
+                tot[n2c[i]] += g->arity(i);
+            if (g->size() > 0)          // The edge iterators need a node
+                for (typename G::EdgeIter it=g->begin(); it != g->end(); it++)
+                    if (n2c[it->orig] == n2c[it->dest])
+                        win += it->weight;
+            s2 = 0;
+            for (size_t i=0; i<tot.size(); i++)
+                s2 += tot[i] * tot[i];
+
+            for (size_t i=0; i<queue.size(); i++)
+                queued[queue[i]] = false;
+            queue.clear();
+            tracking = true;
+        }
+
+        bool is_tracking() { return tracking; }
+
+        // Community of every node in the tracked partition
+        vector<node>& partition() { return n2c; }
+
+        //----------------------------------------------------------------------
+        // Modularity of the tracked partition, as Community::modularity()
+        //----------------------------------------------------------------------
+        double modularity() {
+            double t = g->arity();
+            if (t <= 0)
+                return 0;
+            return 2 * win / t - s2 / t / t;
+        }
+
+        //----------------------------------------------------------------------
+        // Moves the nodes whose edges changed to the neighbor community with 
+        // the greatest modularity gain, as one_level() does, revisiting the 
+        // neighbors of every node moved until no move improves.
+        //----------------------------------------------------------------------
+        void refine() {
+
+            double total = g->arity();
+            vector <double> wc(tot.size(), -1);
+            vector <node> nc;
+            vector <double> nw, na;
+
+            for (size_t q=0; q<queue.size(); q++) {
+                node n = queue[q];
+                queued[n] = false;
+                if (total <= 0)
+                    continue;
+                evaluated++;
+
+                node cur = n2c[n];
+                double a = g->arity(n);
+                for (typename G::NeighIter it=g->begin(n); it != g->end(n); ++it) {
+                    node c = n2c[it->dest];
+                    if (it->dest != n) {
+                        if (wc[c] == -1) {
+                            wc[c] = 0;
+                            nc.push_back(c);
+                        }
+                        wc[c] += (double)it->weight;
+                    }
+                }
+
+                change_tot(cur, -a);
+                nw.resize(nc.size());
+                na.resize(nc.size());
+                for (size_t i=0; i < nc.size(); i++) {
+                    nw[i] = wc[nc[i]];
+                    na[i] = tot[nc[i]];
+                }
+                int best = best_community(nw.data(), na.data(), nc.size(), a, total);
+                node best_c = (best < 0) ? cur : nc[best];
+                if (best_c != cur) {
+                    win -= (wc[cur] == -1) ? 0 : wc[cur];
+                    win += wc[best_c];
+                    n2c[n] = best_c;
+                    moves++;
+                    for (typename G::NeighIter it=g->begin(n); it != g->end(n); ++it)
+                        touch(it->dest);
+                }
+                change_tot(best_c, a);
+
+                for (size_t i=0; i < nc.size(); i++)
+                    wc[nc[i]] = -1;
+                nc.clear();
+            }
+            queue.clear();
+        }
+};
+#endif
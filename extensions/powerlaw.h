@@ -27,11 +27,8 @@ Contact: jgiraldez@iiia.csic.es
 */
 #include <stdio.h>
 #include <vector>
-#ifndef VECTOR
-#include "graph_set.h"
-#else
-#include "graph_vector.h"
-#endif
+#include "formula.h"
+#include "graph.h"
 #include <algorithm>
 
 extern bool verbose;
@@ -41,47 +38,39 @@ int abs_powerlaw(int x){
     return x;
 }
 
-vector<pair <int,int> > arityVar(char* filein){
+vector<pair <long long,long long> > arityVar(const FormulaSource &filein){
     
-    FILE *source;
-    source = fopen(filein, "r");
-    if(!source){
-        cerr << "Unable to read CNF file " << filein << endl;
-        exit(-1);
-    }
-
-    // Skip comments
-    int aux=-1;
-    while((aux=getc(source))=='c'){
-        while (getc(source)!='\n')
-            ;
-    }
-    ungetc(aux,source);
+    FormulaReader reader(filein);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filein.name(), true);
 
-    // File Head
-    int totVars=0, totClauses=0;
-    if( !fscanf(source, "p cnf %i %i", &totVars, &totClauses)) {
-        cerr << "Invalid CNF file\n";
-        exit(-1);
-    }
+    // Skip comments and read the head
+    long long totVars=0, totClauses=0;
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filein.name());
 
-    vector< pair <int,int> > v;
-    vector<int> nOccurs(totVars,0);
+    vector< pair <long long,long long> > v;
+    vector<long long> nOccurs(totVars,0);
     
     int var=-1;
-    while(fscanf(source, "%d", &var)==1) {
+    while(reader.next(var)) {
         if(var==0){
             ;
         }else{
+            if (abs_powerlaw(var) > totVars)
+                throw FormulaError("Unvalid variable number " + to_string(abs_powerlaw(var)));
             nOccurs[abs_powerlaw(var)-1]++;
         }
     }
     
+    if (nOccurs.empty())
+        return v;
+
     sort(nOccurs.begin(), nOccurs.end());
     
-    int prev = nOccurs[0];
-    int addition = 1;
-    for (int i=1; i<nOccurs.size(); i++) {
+    long long prev = nOccurs[0];
+    long long addition = 1;
+    for (size_t i=1; i<nOccurs.size(); i++) {
         if (nOccurs[i] == prev)
             addition++;
         else {
@@ -99,37 +88,23 @@ vector<pair <int,int> > arityVar(char* filein){
     return v;
 }
 
-vector<pair <int,int> > arityClause(char* filein){
+vector<pair <long long,long long> > arityClause(const FormulaSource &filein){
     
-    FILE *source;
-    source = fopen(filein, "r");
-    if(!source){
-        cerr << "Unable to read CNF file " << filein << endl;
-        exit(-1);
-    }
+    FormulaReader reader(filein);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filein.name(), true);
 
-    // Skip comments
-    int aux=-1;
-    while((aux=getc(source))=='c'){
-        while (getc(source)!='\n')
-            ;
-    }
-    ungetc(aux,source);
-
-    // File Head
-    int totVars=0, totClauses=0;
-    if( !fscanf(source, "p cnf %i %i", &totVars, &totClauses)) {
-        cerr << "Invalid CNF file\n";
-        exit(-1);
-    }
+    // Skip comments and read the head
+    long long totVars=0, totClauses=0;
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filein.name());
 
-    vector< pair <int,int> > v;
-    vector<int> nOccurs(100,0);
+    vector< pair <long long,long long> > v;
+    vector<long long> nOccurs(100,0);
     
     int var=-1;
-    int clause=0;
-    int size=0;
-    while(fscanf(source, "%d", &var)==1) {
+    size_t size=0;
+    while(reader.next(var)) {
         if(var==0){
             if(size>=nOccurs.size())
                 nOccurs.resize(size+1);
@@ -140,7 +115,7 @@ vector<pair <int,int> > arityClause(char* filein){
         }
     }
     
-    for(int i=1; i<nOccurs.size(); i++){
+    for(size_t i=1; i<nOccurs.size(); i++){
         if(nOccurs[i]>0){
             if(verbose){
                 cerr << "     " << i << " " << nOccurs[i] << endl;
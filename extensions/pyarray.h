@@ -0,0 +1,191 @@
+/*
+    pyarray.h
+
+    Read-only Python array objects exposing C++ vectors through the buffer
+    protocol, so that results can be handed over to NumPy (numpy.asarray)
+    or memoryview without copying them.
+
+*/
+#include <Python.h>
+#include <string.h>
+#include <vector>
+
+#ifndef PYARRAY_H
+#define PYARRAY_H
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+// Buffer format of the supported element types
+//------------------------------------------------------------------------------
+template <class T> struct array_format;
+template <> struct array_format<int>                { static const char* str() { return "i"; } };
+template <> struct array_format<unsigned int>       { static const char* str() { return "I"; } };
+template <> struct array_format<long>               { static const char* str() { return "l"; } };
+template <> struct array_format<unsigned long>      { static const char* str() { return "L"; } };
+template <> struct array_format<long long>          { static const char* str() { return "q"; } };
+template <> struct array_format<unsigned long long> { static const char* str() { return "Q"; } };
+template <> struct array_format<float>              { static const char* str() { return "f"; } };
+template <> struct array_format<double>             { static const char* str() { return "d"; } };
+
+template <class T>
+void array_release(void* owner) {
+    delete (vector<T>*)owner;
+}
+
+typedef struct {
+    PyObject_HEAD
+    void* owner;                // Vector holding the data
+    void (*release)(void*);     // Destroys the owner
+    void* data;
+    Py_ssize_t len;
+    Py_ssize_t itemsize;
+    const char* format;
+} ArrayObject;
+
+static void Array_dealloc(ArrayObject* self) {
+    if (self->owner != NULL)
+        self->release(self->owner);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int Array_getbuffer(ArrayObject* self, Py_buffer* view, int flags) {
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "featsat.Array is read-only");
+        view->obj = NULL;
+        return -1;
+    }
+    view->obj = (PyObject*)self;
+    Py_INCREF(self);
+    view->buf = self->data;
+    view->len = self->len * self->itemsize;
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char*)self->format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->len : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &self->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static Py_ssize_t Array_length(ArrayObject* self) {
+    return self->len;
+}
+
+static PyBufferProcs Array_as_buffer = {
+    (getbufferproc)Array_getbuffer,
+    NULL,
+};
+
+static PySequenceMethods Array_as_sequence = {
+    (lenfunc)Array_length,
+};
+
+static PyTypeObject ArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "featsat.Array",
+};
+
+//------------------------------------------------------------------------------
+// Registers the Array type. Must be called once on module initialization
+//------------------------------------------------------------------------------
+int Array_Ready() {
+    ArrayType.tp_basicsize = sizeof(ArrayObject);
+    ArrayType.tp_dealloc = (destructor)Array_dealloc;
+    ArrayType.tp_as_buffer = &Array_as_buffer;
+    ArrayType.tp_as_sequence = &Array_as_sequence;
+    ArrayType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ArrayType.tp_doc = "Read-only array supporting the buffer protocol.";
+    return PyType_Ready(&ArrayType);
+}
+
+//------------------------------------------------------------------------------
+// Creates an Array taking the contents of "v", which is left empty.
+// No element is copied.
+//------------------------------------------------------------------------------
+template <class T>
+PyObject* Array_FromVector(vector<T> &v) {
+    ArrayObject* self = PyObject_New(ArrayObject, &ArrayType);
+    if (self == NULL)
+        return NULL;
+    vector<T>* owner = new vector<T>();
+    owner->swap(v);
+    self->owner = owner;
+    self->release = array_release<T>;
+    self->data = owner->data();
+    self->len = owner->size();
+    self->itemsize = sizeof(T);
+    self->format = array_format<T>::str();
+    return (PyObject*)self;
+}
+
+//------------------------------------------------------------------------------
+// Gets the buffer of "obj" in "view", that must be a one-dimensional 
+// contiguous array of integers. Sets "sign" if they are signed. Returns -1
+// with an exception set otherwise.
+//------------------------------------------------------------------------------
+int Buffer_Integers(PyObject* obj, Py_buffer* view, bool &sign) {
+
+    if (PyObject_GetBuffer(obj, view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0)
+        return -1;
+    const char* f = view->format ? view->format : "B";
+    if (*f != 0 && strchr("@=<>!", *f) != NULL)
+        f++;
+    sign = strchr("bhilqn", *f) != NULL;
+    if (view->ndim > 1 || f[0] == 0 || f[1] != 0 || 
+        (!sign && strchr("BHILQN", *f) == NULL)) {
+        PyBuffer_Release(view);
+        PyErr_SetString(PyExc_TypeError, "expected a one-dimensional array of integers");
+        return -1;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Reads the integers of "obj" into "v". Objects supporting the buffer 
+// protocol (featsat.Array, NumPy arrays) of any integer type are read
+// directly, other ones as sequences. Returns -1 with an exception set if 
+// they are not integers.
+//------------------------------------------------------------------------------
+int Vector_FromObject(PyObject* obj, vector<long long> &v) {
+
+    v.clear();
+    if (PyObject_CheckBuffer(obj)) {
+        Py_buffer view;
+        bool sign;
+        if (Buffer_Integers(obj, &view, sign) < 0)
+            return -1;
+        Py_ssize_t n = view.len / view.itemsize;
+        v.resize(n);
+        const char* p = (const char*)view.buf;
+        for (Py_ssize_t i=0; i<n; i++, p += view.itemsize) {
+            switch (view.itemsize) {
+            case 1: v[i] = sign ? (long long)*(const signed char*)p : (long long)*(const unsigned char*)p; break;
+            case 2: { short x; memcpy(&x, p, 2); v[i] = sign ? x : (unsigned short)x; break; }
+            case 4: { int x; memcpy(&x, p, 4); v[i] = sign ? x : (unsigned int)x; break; }
+            default: { long long x; memcpy(&x, p, 8); v[i] = x; break; }
+            }
+        }
+        PyBuffer_Release(&view);
+        return 0;
+    }
+
+    PyObject* seq = PySequence_Fast(obj, "expected a sequence of integers");
+    if (seq == NULL)
+        return -1;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    v.resize(n);
+    for (Py_ssize_t i=0; i<n; i++) {
+        v[i] = PyLong_AsLongLong(PySequence_Fast_GET_ITEM(seq, i));
+        if (v[i] == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+    reorder.h
+
+    Relabeling of the nodes of a graph in a cache-friendly order. Variable
+    numbering in DIMACS is arbitrary, so neighbors of a node are usually far
+    apart in memory. Renumbering nodes by degree, by reverse Cuthill-McKee or
+    by community places nodes accessed together close to each other. Per-node
+    results of the permuted graph are mapped back with unpermute().
+
+*/
+#include <vector>
+#include <algorithm>
+#include "graph.h"
+
+#ifndef REORDER_H
+#define REORDER_H
+
+using namespace std;
+
+enum NodeOrder { ORDER_NONE, ORDER_DEGREE, ORDER_RCM, ORDER_COMMUNITY };
+
+//------------------------------------------------------------------------------
+// Given the nodes of "g" in the desired order, returns the new id of every
+// node. Variables [0..typeA-1] and clauses keep their ranges, each of them
+// numbered in the order they appear.
+//------------------------------------------------------------------------------
+template <class G>
+vector<typename G::node_t> order_to_perm(G* g, const vector<typename G::node_t> &order) {
+
+    typedef typename G::node_t node;
+    vector<node> perm(g->size());
+    node nvar = 0, nclause = g->getTypeA();
+    for (size_t i=0; i<order.size(); i++)
+        perm[order[i]] = (order[i] < g->getTypeA()) ? nvar++ : nclause++;
+    return perm;
+}
+
+//------------------------------------------------------------------------------
+// Nodes by decreasing degree, so that hubs share the first cache lines
+//------------------------------------------------------------------------------
+template <class G>
+vector<typename G::node_t> order_degree(G* g) {
+
+    typedef typename G::node_t node;
+    vector<node> order(g->size());
+    for (node i=0; i<g->size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(),
+                [g](node a, node b) { return g->nNeighs(a) > g->nNeighs(b); });
+    return order_to_perm(g, order);
+}
+
+//------------------------------------------------------------------------------
+// Reverse Cuthill-McKee: breadth-first search of every connected component,
+// starting from a node of minimum degree and visiting neighbors by
+// increasing degree, and reversed. Neighbors get close ids, so the rows
+// accessed from a node are close in memory.
+//------------------------------------------------------------------------------
+template <class G>
+vector<typename G::node_t> order_rcm(G* g) {
+
+    typedef typename G::node_t node;
+    size_t n = g->size();
+    vector<node> byDegree(n), order;
+    vector<bool> visited(n, false);
+    vector<node> next;
+    order.reserve(n);
+
+    for (size_t i=0; i<n; i++)
+        byDegree[i] = i;
+    stable_sort(byDegree.begin(), byDegree.end(),
+                [g](node a, node b) { return g->nNeighs(a) < g->nNeighs(b); });
+
+    for (size_t s=0; s<n; s++) {
+        if (visited[byDegree[s]])
+            continue;
+        size_t head = order.size();
+        order.push_back(byDegree[s]);
+        visited[byDegree[s]] = true;
+        while (head < order.size()) {
+            node x = order[head++];
+            next.clear();
+            for (typename G::NeighIter it=g->begin(x); it != g->end(x); ++it)
+                if (!visited[it->dest]) {
+                    visited[it->dest] = true;
+                    next.push_back(it->dest);
+                }
+            stable_sort(next.begin(), next.end(),
+                        [g](node a, node b) { return g->nNeighs(a) < g->nNeighs(b); });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    reverse(order.begin(), order.end());
+    return order_to_perm(g, order);
+}
+
+//------------------------------------------------------------------------------
+// Nodes grouped by their community in "n2c", e.g. found by a previous run,
+// keeping the current order inside every community
+//------------------------------------------------------------------------------
+template <class G>
+vector<typename G::node_t> order_community(G* g, const vector<typename G::node_t> &n2c) {
+
+    typedef typename G::node_t node;
+    assert(n2c.size() == g->size());
+    vector<node> order(g->size());
+    for (node i=0; i<g->size(); i++)
+        order[i] = i;
+    stable_sort(order.begin(), order.end(),
+                [&n2c](node a, node b) { return n2c[a] < n2c[b]; });
+    return order_to_perm(g, order);
+}
+
+//------------------------------------------------------------------------------
+// Returns a copy of "g" where node x is renamed perm[x]. Rows are built
+// already sorted, so it takes a sort of every row and no staging.
+//------------------------------------------------------------------------------
+template <class G>
+G* permute(G* g, const vector<typename G::node_t> &perm) {
+
+    typedef typename G::node_t node;
+    typedef typename G::weight_t weight;
+    assert(perm.size() == g->size());
+
+    G* g2 = new G(g->getTypeA(), g->size() - g->getTypeA());
+    vector<vector<pair<node,weight> > > rows(g->size());
+    #pragma omp parallel for schedule(dynamic,1024)
+    for (long long x=0; x<(long long)g->size(); x++) {
+        vector<pair<node,weight> > &row = rows[perm[x]];
+        row.reserve(g->nNeighs(x));
+        for (typename G::NeighIter it=g->begin(x); it != g->end(x); ++it)
+            row.push_back(make_pair(perm[it->dest], it->weight));
+        sort(row.begin(), row.end());
+    }
+    g2->set_rows(rows);
+    return g2;
+}
+
+//------------------------------------------------------------------------------
+// Maps a result "v" of the graph permuted by "perm" (v[perm[x]] is the value
+// of node x) back to the original ids, in place
+//------------------------------------------------------------------------------
+template <class T, class P>
+void unpermute(vector<T> &v, const vector<P> &perm) {
+    assert(v.size() == perm.size());
+    vector<T> orig(v.size());
+    for (size_t x=0; x<perm.size(); x++)
+        orig[x] = v[perm[x]];
+    v.swap(orig);
+}
+
+#endif
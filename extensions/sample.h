@@ -0,0 +1,129 @@
+/*
+    sample.h
+
+    Samples of the clauses of a formula, read in one pass: a prefix, a
+    uniform random sample (every clause kept with the same probability) or
+    a reservoir sample (of an exact size, without trusting the number of
+    clauses of the header). Random samples are shuffled, so that every
+    prefix of a sample is also a uniform sample, and the features of growing
+    samples are computed on growing prefixes of the same one.
+
+*/
+#include <vector>
+#include <stdint.h>
+#include "formula.h"
+#include "community.h"
+
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+using namespace std;
+
+enum SampleMode { SAMPLE_PREFIX, SAMPLE_UNIFORM, SAMPLE_RESERVOIR };
+
+//------------------------------------------------------------------------------
+// Clauses sampled from a formula, with the variables renumbered from 1 in
+// the order they appear, so that a prefix of the sample has no variables
+// out of it. Prefixes are read as a FormulaSource in memory.
+//------------------------------------------------------------------------------
+class ClauseSample {
+
+    vector<int> lits;               // Clause i is lits[offsets[i]..offsets[i+1]-1]
+    vector<long long> offsets;
+    long long total;                // Clauses of the formula
+
+    public:
+
+        ClauseSample() : offsets(1, 0), total(0) {}
+
+        long long size() const { return offsets.size() - 1; }
+
+        long long clauses() const { return total; }
+
+        //----------------------------------------------------------------------
+        // Reads a sample of "size" clauses of "src" (all of them if 0) by the
+        // given SampleMode. Prefixes stop reading after "size" clauses.
+        // Throws a FormulaError if the formula cannot be read.
+        //----------------------------------------------------------------------
+        void read(const FormulaSource &src, int mode, long long size, uint64_t seed) {
+
+            FormulaReader reader(src);
+            long long vars, header;
+            if (!reader.open())
+                throw FormulaError("Unable to read CNF file " + src.name(), true);
+            if (!reader.header(vars, header))
+                throw FormulaError("Invalid CNF file " + src.name());
+            if (size <= 0)
+                size = header > 0 ? header : -1;
+
+            Random rng(seed);
+            // Probability of keeping a clause in the uniform sample, over 2^64
+            double p = header > 0 ? (double)size / header : 1;
+            uint64_t threshold = p >= 1 ? UINT64_MAX : (uint64_t)(p * 18446744073709551616.0);
+
+            vector<vector<int> > sample;
+            vector<int> clause;
+            total = 0;
+            int x;
+            while (reader.next(x)) {
+                if (x != 0) {
+                    clause.push_back(x);
+                    continue;
+                }
+                total++;
+                if (mode == SAMPLE_PREFIX) {
+                    sample.push_back(clause);
+                    if ((long long)sample.size() == size)
+                        break;
+                } else if (mode == SAMPLE_UNIFORM) {
+                    if (rng.next() <= threshold)
+                        sample.push_back(clause);
+                } else if (size < 0 || (long long)sample.size() < size) {
+                    sample.push_back(clause);
+                } else {
+                    // Algorithm R: the clause replaces a random one with probability size/total
+                    uint64_t j = rng.next() % total;
+                    if ((long long)j < size)
+                        sample[j].swap(clause);
+                }
+                clause.clear();
+            }
+            if (mode == SAMPLE_PREFIX && header > total)
+                total = header;
+
+            if (mode != SAMPLE_PREFIX)
+                shuffle(sample, &rng);
+
+            // Variables renumbered in order of appearance
+            vector<int> ren(vars + 1, 0);
+            int next = 0;
+            lits.clear();
+            offsets.assign(1, 0);
+            for (size_t i=0; i<sample.size(); i++) {
+                for (size_t j=0; j<sample[i].size(); j++) {
+                    int v = abs(sample[i][j]);
+                    if (v >= (long long)ren.size())
+                        ren.resize(v + 1, 0);
+                    if (ren[v] == 0)
+                        ren[v] = ++next;
+                    lits.push_back(sample[i][j] < 0 ? -ren[v] : ren[v]);
+                }
+                offsets.push_back(lits.size());
+            }
+        }
+
+        //----------------------------------------------------------------------
+        // The first n clauses of the sample, read in place. The sample must
+        // not change while the source is in use.
+        //----------------------------------------------------------------------
+        FormulaSource prefix(long long n) const {
+            int vars = 0;
+            for (long long i=0; i<offsets[n]; i++)
+                if (abs(lits[i]) > vars)
+                    vars = abs(lits[i]);
+            return FormulaSource::clauses(lits.data(), sizeof(int), offsets.data(),
+                                          sizeof(long long), vars, n);
+        }
+};
+
+#endif
@@ -0,0 +1,948 @@
+/*
+    satfeatures.h
+
+    Feature computation routines shared by the featsat Python extension and
+    the sia-feat command line tool.
+
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "graph.h"
+#include "tools.h"
+#include "powerlaw.h"
+#include "dimension.h"
+#include "community.h"
+#include "hypergraph.h"
+#include "budget.h"
+#include "sample.h"
+
+#ifndef SATFEATURES_H
+#define SATFEATURES_H
+
+using namespace std;
+
+
+// Global variables and Flags
+
+
+// Extra info. Debugging purposes
+bool verbose = false;
+
+// Execution tunning variables 
+int minx = 0;
+int maxx = 15;
+int maxx2 = 6;
+int maxclause = 400;
+bool proxyclause = false;   // Longer clauses as proxy nodes in the VIG
+int maxxmin = 10;
+double precision = 0.000001;
+double timelimit = 0;       // Seconds for the graph features of an instance, 0 for none
+int dimsamples = 0;         // Centers for estimating the box covering, 0 for the exact one
+// Options of sia-feat, defaults of the graphs built by the functions below
+bool compressgraph = false; // Keep VIGs in compressed rows
+size_t vigmemory = 0;       // Bytes for the edges staged building a VIG, 0 for no limit
+const char* scratchdir = NULL;  // Directory of its scratch files, or NULL for $TMPDIR
+
+// Scale Free (Vars)
+char *var = NULL;
+char *alphavar = NULL;
+char *varint = NULL;
+char *varplot = NULL;
+
+// Scale Free (Clauses)
+char *clau = NULL;
+char *alphaclau = NULL;
+char *clauint = NULL;
+char *clauplot = NULL;
+
+// Self Similarity (VIG)
+char *dim = NULL;
+char *resdim = NULL;
+char *dimplot = NULL;
+
+// Self Similarity (CVIG)
+char *dib = NULL;
+char *resdib =  NULL;
+char *dibplot = NULL;
+
+// Plotting Variables (mantained, not used)
+char *mod = NULL;
+char *mob = NULL;
+char *fout = NULL;
+char *modules = NULL;
+
+
+//------------------------------------------------------------------------------
+// Graph instantiations compiled in, chosen at runtime by the instance size.
+// Small instances keep double weights, so that features are reproducible; 
+// large ones use float weights, taking 8 bytes per adjacency entry instead 
+// of 12; and 64-bit node ids are only used when 32 bits do not suffice.
+//------------------------------------------------------------------------------
+typedef GraphT<uint32_t, double, CSRStorage> GraphSmall;
+typedef GraphT<uint32_t, float, CSRStorage>  GraphLarge;
+typedef GraphT<uint64_t, float, CSRStorage>  GraphHuge;
+
+// Graphs updated clause by clause (see incremental.h), never chosen by size
+typedef GraphT<uint32_t, double, SetStorage> GraphDynamic;
+
+// VIGs with compressed rows (see graph_compressed.h), chosen by compressgraph
+typedef GraphT<uint32_t, double, CompressedStorage> GraphCompressed;
+
+// CVIGs keep the clause-variable incidence only (see graph_incidence.h)
+typedef GraphT<uint32_t, double, IncidenceStorage> CVIGSmall;
+typedef GraphT<uint32_t, float, IncidenceStorage>  CVIGLarge;
+typedef GraphT<uint64_t, float, IncidenceStorage>  CVIGHuge;
+
+// CVIG instantiation matching the instantiation G of a VIG
+template <class G> struct CVIG { typedef G type; };
+template <> struct CVIG<GraphSmall> { typedef CVIGSmall type; };
+template <> struct CVIG<GraphLarge> { typedef CVIGLarge type; };
+template <> struct CVIG<GraphHuge> { typedef CVIGHuge type; };
+template <> struct CVIG<GraphCompressed> { typedef CVIGSmall type; };
+
+enum GraphType { GRAPH_SMALL, GRAPH_LARGE, GRAPH_HUGE, GRAPH_DYNAMIC, GRAPH_COMPRESSED };
+
+// Over this number of clauses, an instance is large
+#define LARGE_INSTANCE (1 << 22)
+
+// Calls func<G>(...) with the instantiation G of the given GraphType
+#define DISPATCH_GRAPH(type, func, ...) \
+    ((type) == GRAPH_HUGE ? func<GraphHuge>(__VA_ARGS__) : \
+     (type) == GRAPH_LARGE ? func<GraphLarge>(__VA_ARGS__) : \
+     (type) == GRAPH_COMPRESSED ? func<GraphCompressed>(__VA_ARGS__) : \
+     func<GraphSmall>(__VA_ARGS__))
+
+// Same as above, with the CVIG instantiations
+#define DISPATCH_CVIG(type, func, ...) \
+    ((type) == GRAPH_HUGE ? func<CVIGHuge>(__VA_ARGS__) : \
+     (type) == GRAPH_LARGE ? func<CVIGLarge>(__VA_ARGS__) : \
+     func<CVIGSmall>(__VA_ARGS__))
+
+//------------------------------------------------------------------------------
+// Returns the instantiation for a graph of "nodes" nodes built from "clauses"
+// clauses, compressed if "compressed" and its ids take 32 bits
+//------------------------------------------------------------------------------
+GraphType choose_graph(long long nodes, long long clauses, bool compressed = compressgraph) {
+
+    if (nodes >= (long long)UINT32_MAX)
+        return GRAPH_HUGE;
+    if (compressed)
+        return GRAPH_COMPRESSED;
+    if (clauses > LARGE_INSTANCE)
+        return GRAPH_LARGE;
+    return GRAPH_SMALL;
+}
+
+//------------------------------------------------------------------------------
+// Returns the instantiation for the VIG (or the CVIG if "cvig") of a CNF 
+// file, given the sizes in its header (see choose_graph)
+//------------------------------------------------------------------------------
+GraphType graph_type(const FormulaSource &source, bool cvig, bool compressed = compressgraph) {
+
+    long long vars = 0, clauses = 0;
+    FormulaReader reader(source);
+    if (!reader.header(vars, clauses))
+        vars = clauses = 0;
+    return choose_graph(cvig ? vars + clauses : vars, clauses, compressed);
+}
+
+
+//------------------------------------------------------------------------------
+// Given the box covering curve needed[] of a graph, computes the regressions 
+// of log(needed[d]) against log(d) (polreg) and against d (expreg), for d in
+// [minx, maxx2]. The dimension is -polreg.first and the decay -expreg.first
+//------------------------------------------------------------------------------
+template <class T>
+void fit_needed(const vector<T> &needed, pair<double,double> &polreg, pair<double,double> &expreg) {
+
+    vector <pair <double,double> > v1;
+    vector <pair <double,double> > v2;
+
+    for(int i=1; i<(int)needed.size(); i++){
+        if(i>=minx && i<=maxx2){
+            v1.push_back(pair<double,double>(log(i), log((double)needed[i])));
+            v2.push_back(pair<double,double>((double)i, log((double)needed[i])));   
+        }
+    }
+
+    polreg = regresion(v1);
+    expreg = regresion(v2);
+}
+
+//------------------------------------------------------------------------------
+// Given a box covering curve estimated from random centers, fits the
+// dimension and computes its 95% confidence interval [low, high] from 
+// "resamples" bootstrap resamples of the centers
+//------------------------------------------------------------------------------
+double fit_estimate(const BoxEstimate &e, int resamples, uint64_t seed, double &low, double &high) {
+
+    pair <double,double> polreg, expreg;
+    fit_needed(e.needed, polreg, expreg);
+    low = high = -polreg.first;
+
+    size_t k = e.inverse.size();
+    if (k < 2)
+        return -polreg.first;
+
+    Random rng(seed);
+    vector<double> dims(resamples);
+    vector<double> curve(e.needed.size());
+    for (int b=0; b<resamples; b++) {
+        curve.assign(e.needed.size(), 0);
+        for (size_t i=0; i<k; i++) {
+            const vector<double> &inv = e.inverse[rng.next() % k];
+            for (size_t d=0; d<curve.size(); d++)
+                curve[d] += inv[d];
+        }
+        for (size_t d=0; d<curve.size(); d++)
+            curve[d] *= e.needed[0] / k;
+        pair <double,double> p, q;
+        fit_needed(curve, p, q);
+        dims[b] = -p.first;
+    }
+    sort(dims.begin(), dims.end());
+    low = dims[(size_t)(0.025 * (resamples - 1))];
+    high = dims[(size_t)(0.975 * (resamples - 1))];
+    return -polreg.first;
+}
+
+//------------------------------------------------------------------------------
+// Fits the box covering of "g", exact or, if dimsamples > 0, estimated
+// from that number of random centers
+//------------------------------------------------------------------------------
+template <class G>
+void fit_dimension(G* g, Budget* budget, pair<double,double> &polreg, pair<double,double> &expreg) {
+    if (dimsamples > 0) {
+        BoxEstimate e = estimateNeeded(g, dimsamples, 0, budget);
+        fit_needed(e.needed, polreg, expreg);
+    } else {
+        vector<long long> needed = computeNeeded(g, budget);
+        fit_needed(needed, polreg, expreg);
+    }
+}
+
+
+template <class G>
+double modularity_vig(const FormulaSource &fin, int max_clauses, int method, Budget* budget) {
+
+    clock_t t_ini, t_fin;
+    double secsGraphs;
+    double secsMod;
+
+    G* vig = NULL;
+
+    // Build Graph
+    t_ini = clock();
+    vig = readVIG<G>(fin, max_clauses, proxyclause);
+    t_fin = clock();
+    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    Community<G> c(vig);
+    c.budget = budget;
+    double modularity=-1;
+
+    if(verbose) {
+        cerr << "Computing COMMUNITY Structure (VIG)" << endl;
+        std::cout << "max_clauses: " << max_clauses << std::endl;
+    }
+
+    // Computation
+    t_ini = clock();
+    modularity = c.compute_modularity(method, precision);
+    c.compute_communities();
+    t_fin = clock();
+    secsMod = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    if (verbose) {
+        cerr << "modularity = " << modularity << endl;
+        cerr << "communities = " << c.ncomm << endl;
+        cerr << "largest size = " << (double)c.Comm[c.Comm_order[0].first].size()/vig->size() << endl;
+        cerr << "iterations = " << c.iterations << endl;
+        cerr << "visits = " << c.visits << " in " << c.sweeps.size() << " sweeps" << endl;
+        cerr << "grap loading = " << secsGraphs << endl;
+        cerr << "partition and modu time = " << secsMod << endl;
+    }
+
+    return modularity;
+}
+
+
+template <class G>
+double modularity_cvig(const FormulaSource &fin, int max_clauses, int method, Budget* budget) {
+
+    typedef typename CVIG<G>::type C;
+
+    // Time variables
+    clock_t t_ini, t_fin;
+    double secsGraphs;
+    double secsModBip;
+
+    C* cvig = NULL;
+    
+    // Build Graph
+    t_ini = clock();
+    cvig = readCVIG<C>(fin, max_clauses);
+    t_fin = clock();
+    
+    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    // Community
+    Community<C> c_bip(cvig);
+    c_bip.budget = budget;
+    double modularity_bip = -1;
+
+    // Compute
+    t_ini = clock();    
+    modularity_bip = c_bip.compute_modularity(method, precision);
+    c_bip.compute_communities();
+    t_fin = clock();
+
+    secsModBip = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    if (verbose) {
+        cerr << "modularity = " << modularity_bip << endl;
+        cerr << "communities = " << c_bip.ncomm << endl;
+        cerr << "largest size = " << (double)c_bip.Comm[c_bip.Comm_order[0].first].size()/cvig->size() << endl;
+        cerr << "iterations = " << c_bip.iterations << endl;
+        cerr << "visits = " << c_bip.visits << " in " << c_bip.sweeps.size() << " sweeps" << endl;
+        cerr << "grap loading = " << secsGraphs << endl;
+        cerr << "partition and modu time = " << secsModBip << endl;
+    }
+        
+    return modularity_bip;
+}
+
+double scale_free_var(const FormulaSource &fin, int max_clauses){
+
+    // Time variables
+    clock_t t_ini, t_fin;
+    double secsAlphaVar;
+    
+    // Scale Free (Variables)
+    double alphavarexp = -1;
+  
+    if (verbose) {
+        cerr << "Computing SCALE-FREE Structure (Variables)" << endl;
+        cerr << "max_clauses: " << max_clauses << endl;
+    }
+
+    // Compute
+    t_ini = clock();
+    vector<pair <long long,long long> > a = arityVar(fin);
+    alphavarexp = mostlikely(a, maxxmin, alphavar, varint, varplot, true);
+    t_fin = clock();
+    
+    secsAlphaVar = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    
+    if (verbose) {
+        cerr << "alpha var exp = " << alphavarexp << endl;
+        cerr << "time = " << secsAlphaVar << endl;
+    }
+
+    return alphavarexp;
+}
+
+double scale_free_clause(const FormulaSource &fin, int max_clauses){
+
+    // Time variables
+    clock_t t_ini, t_fin;
+    double secsAlphaClau;
+    
+    // Scale Free (Clauses)
+    double alphaclauexp = -1;
+
+    if (verbose) {
+        cerr << "Computing SCALE-FREE Structure (Clauses)" << endl;
+    }
+
+    // Compute
+    t_ini = clock();
+    vector<pair <long long,long long> > b = arityClause(fin);
+    alphaclauexp = mostlikely(b, maxxmin, alphaclau, clauint, clauplot, false);
+    t_fin = clock();
+    
+    secsAlphaClau = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    
+    if (verbose) {
+        cerr << "alpha clause exp = " << alphaclauexp << endl;
+        cerr << "time = " << secsAlphaClau << endl;
+    }
+
+    return alphaclauexp;
+}
+
+template <class G>
+double self_similar_vig(const FormulaSource &fin, int max_clauses, Budget* budget){
+
+    // Time management
+    clock_t t_ini, t_fin;
+    double secsGraphs;
+    double secsDim;
+    
+    // Graphs
+    G* vig = NULL;
+
+    // Build Graph
+    t_ini = clock();
+    vig = readVIG<G>(fin, max_clauses, proxyclause);
+    t_fin = clock();
+    
+    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    // Self Similarity variables
+    pair <double,double> polreg = make_pair(-1,-1);
+    pair <double,double> expreg = make_pair(-1,-1);
+    
+    if(verbose){
+        cerr << "Computing SELF-SIMILAR Structure (VIG)" << endl;
+        cerr << "max_clauses: " << max_clauses << endl;
+    }
+   
+    // Compute
+    t_ini = clock();    
+    fit_dimension(vig, budget, polreg, expreg);
+    t_fin = clock();
+
+    secsDim = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    if (verbose) {
+        cerr << "dimension = " << -polreg.first << endl;
+        cerr << "decay = " << -expreg.first << endl;
+    }
+    
+    return -polreg.first;
+}
+
+template <class G>
+double self_similar_cvig(const FormulaSource &fin, int max_clauses, Budget* budget){
+
+    typedef typename CVIG<G>::type C;
+
+    // Time management
+    clock_t t_ini, t_fin;
+    double secsGraphs;
+    double secsDib;
+    
+    C* cvig = NULL;    
+    
+    // Build Graph
+    t_ini = clock();
+    cvig = readCVIG<C>(fin, max_clauses);
+    t_fin = clock();
+    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+    
+    // Self similarity
+    pair <double,double> polregB = make_pair(-1,-1);
+    pair <double,double> expregB = make_pair(-1,-1);
+       
+    if(verbose) {
+        cerr << "Computing SELF-SIMILAR Structure (CVIG)" << endl;
+        cerr << "max_clauses: " << max_clauses << std::endl;
+    }
+
+    
+    t_ini = clock();        
+    fit_dimension(cvig, budget, polregB, expregB);
+    
+    t_fin = clock();
+    secsDib = (double)(t_fin - t_ini) / CLOCKS_PER_SEC; 
+    
+    if (verbose) {
+        cerr << "dimension bipartite = " << -polregB.first << endl;
+        cerr << "decay bipartite = " << -expregB.first << endl;
+    }
+
+    return -polregB.first;
+}
+
+template <class node>
+double modularity_hypergraph(const FormulaSource &fin, int max_clauses, Budget* budget) {
+
+    clock_t t_ini, t_fin;
+    double secsGraphs;
+    double secsMod;
+
+    // Build Hypergraph
+    t_ini = clock();
+    Hypergraph<node>* h = readHypergraph<node>(fin, max_clauses);
+    t_fin = clock();
+    secsGraphs = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    if(verbose)
+        cerr << "Computing COMMUNITY Structure (Hypergraph)" << endl;
+
+    // Computation
+    t_ini = clock();
+    HyperCommunity<node> c(h);
+    c.budget = budget;
+    double modularity = c.compute_modularity(precision);
+    t_fin = clock();
+    secsMod = (double)(t_fin - t_ini) / CLOCKS_PER_SEC;
+
+    if (verbose) {
+        cerr << "modularity = " << modularity << endl;
+        cerr << "communities = " << c.ncomm << endl;
+        cerr << "iterations = " << c.iterations << endl;
+        cerr << "visits = " << c.visits << endl;
+        cerr << "hypergraph loading = " << secsGraphs << endl;
+        cerr << "partition and modu time = " << secsMod << endl;
+    }
+
+    delete h;
+    return modularity;
+}
+
+//------------------------------------------------------------------------------
+// Feature computations with the graph instantiation fitting the instance.
+// They stop when "budget" (if any) is exhausted, with the result found so far.
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+double modularity_vig(const FormulaSource &fin, int max_clauses, int method = METHOD_LOUVAIN,
+                      Budget* budget = NULL) {
+    return DISPATCH_GRAPH(graph_type(fin, false), modularity_vig, fin, max_clauses, method, budget);
+}
+
+double modularity_cvig(const FormulaSource &fin, int max_clauses, int method = METHOD_LOUVAIN,
+                       Budget* budget = NULL) {
+    return DISPATCH_GRAPH(graph_type(fin, true), modularity_cvig, fin, max_clauses, method, budget);
+}
+
+double modularity_hypergraph(const FormulaSource &fin, int max_clauses, Budget* budget = NULL) {
+    if (graph_type(fin, false) == GRAPH_HUGE)
+        return modularity_hypergraph<uint64_t>(fin, max_clauses, budget);
+    return modularity_hypergraph<uint32_t>(fin, max_clauses, budget);
+}
+
+double self_similar_vig(const FormulaSource &fin, int max_clauses, Budget* budget = NULL) {
+    return DISPATCH_GRAPH(graph_type(fin, false), self_similar_vig, fin, max_clauses, budget);
+}
+
+double self_similar_cvig(const FormulaSource &fin, int max_clauses, Budget* budget = NULL) {
+    return DISPATCH_GRAPH(graph_type(fin, true), self_similar_cvig, fin, max_clauses, budget);
+}
+
+//------------------------------------------------------------------------------
+// Selectable features
+//------------------------------------------------------------------------------
+#define FEAT_ALPHA_VAR      1
+#define FEAT_ALPHA_CLAUSE   2
+#define FEAT_DIM_VIG        4
+#define FEAT_DIM_CVIG       8
+#define FEAT_MOD_VIG       16
+#define FEAT_MOD_CVIG      32
+#define FEAT_BASE          64
+#define FEAT_ALL          127
+
+//------------------------------------------------------------------------------
+// Parses a comma separated list of features into a mask of FEAT_* flags.
+// Returns -1 if some feature is unknown.
+//------------------------------------------------------------------------------
+int parse_features(char* list) {
+
+    int mask = 0;
+    for (char* tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        if (strcmp(tok, "alpha-var") == 0) mask |= FEAT_ALPHA_VAR;
+        else if (strcmp(tok, "alpha-clause") == 0) mask |= FEAT_ALPHA_CLAUSE;
+        else if (strcmp(tok, "dim-vig") == 0) mask |= FEAT_DIM_VIG;
+        else if (strcmp(tok, "dim-cvig") == 0) mask |= FEAT_DIM_CVIG;
+        else if (strcmp(tok, "mod-vig") == 0) mask |= FEAT_MOD_VIG;
+        else if (strcmp(tok, "mod-cvig") == 0) mask |= FEAT_MOD_CVIG;
+        else if (strcmp(tok, "base") == 0) mask |= FEAT_BASE;
+        else if (strcmp(tok, "all") == 0) mask |= FEAT_ALL;
+        else {
+            cerr << "Unknown feature " << tok << endl;
+            return -1;
+        }
+    }
+    return mask;
+}
+
+// Column names of the features, in the order printed by print_features_csv
+const char* feature_names = "#instances, time-buildGraphs, alphaVarExp, "
+                            "time-AlphaVar, alphaClauExp, time-AlphaClau, "
+                            "dim, time-dim, dim-bip, "
+                            "time-dimBip, mod, #comm-vig, "
+                            "time-mod, mod-bip, #comm-cvig, "
+                            "time-mod-bip, time-total, "
+                            "vars, clauses, ratio, size-mean, size-std, "
+                            "size-min, size-max, unit, binary, ternary, "
+                            "horn, dual-horn, positive, balance-clause-mean, "
+                            "balance-clause-std, balance-var-mean, balance-var-std, "
+                            "degree-mean, degree-std, degree-min, degree-max, "
+                            "horny-mean, horny-std, time-base, truncated";
+
+// Features of an instance. Those not computed are left as -1
+struct Features {
+    string instance;
+    double secsGraphs;
+    double alphavarexp, secsAlphaVar;
+    double alphaclauexp, secsAlphaClau;
+    double dim, secsDim;
+    double dimbip, secsDib;
+    double modularity; long long ncomm; double secsMod;
+    double modularity_bip; long long ncomm_bip; double secsModBip;
+    double secsTotal;
+    BaseFeatures base; double secsBase;
+    bool truncated;             // Some graph feature stopped by the time limit
+};
+
+//------------------------------------------------------------------------------
+// Elapsed (wall clock) seconds since an arbitrary point. Unlike clock(), it 
+// does not add up the time of other threads.
+//------------------------------------------------------------------------------
+double wall_time() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------
+// Computes the graph features selected in "mask" (FEAT_* flags) of a CNF file
+// into "f", building the VIG and CVIG as graphs of type G (and its CVIG
+// instantiation) only when needed and at most once. Kernels stop when
+// "budget" (if any) is exhausted. The formula read is also counted in
+// "counter", if any.
+//------------------------------------------------------------------------------
+template <class G>
+void compute_graph_features(const FormulaSource &fin, int max_clauses, int mask, Features &f,
+                            Budget* budget = NULL, BaseCounter* counter = NULL) {
+
+    typedef typename CVIG<G>::type C;
+    double t_ini, t_fin;
+
+    bool needVIG = mask & (FEAT_DIM_VIG | FEAT_MOD_VIG);
+    bool needCVIG = mask & (FEAT_DIM_CVIG | FEAT_MOD_CVIG);
+    G* vig = NULL;
+    C* cvig = NULL;
+
+    t_ini = wall_time();
+    if (needVIG && needCVIG) {
+        pair<G*,C*> p = readFormula<G,C>(fin, max_clauses, proxyclause, counter);
+        vig = p.first;
+        cvig = p.second;
+    } else if (needVIG) {
+        vig = readVIG<G>(fin, max_clauses, proxyclause, counter);
+    } else if (needCVIG) {
+        cvig = readCVIG<C>(fin, max_clauses, counter);
+    }
+    t_fin = wall_time();
+    f.secsGraphs = t_fin - t_ini;
+
+    pair <double,double> polreg, expreg;
+
+    if (mask & FEAT_DIM_VIG) {
+        if(verbose)
+            cerr << "Computing SELF-SIMILAR Structure (VIG)" << endl;
+        t_ini = wall_time();
+        fit_dimension(vig, budget, polreg, expreg);
+        f.dim = -polreg.first;
+        f.secsDim = wall_time() - t_ini;
+        if(verbose){
+            cerr << "dimension = " << -polreg.first << endl;
+            cerr << "decay = " << -expreg.first << endl;
+        }
+    }
+
+    if (mask & FEAT_DIM_CVIG) {
+        if(verbose)
+            cerr << "Computing SELF-SIMILAR Structure (CVIG)" << endl;
+        t_ini = wall_time();
+        fit_dimension(cvig, budget, polreg, expreg);
+        f.dimbip = -polreg.first;
+        f.secsDib = wall_time() - t_ini;
+        if(verbose){
+            cerr << "dimension bipartite = " << -polreg.first << endl;
+            cerr << "decay bipartite = " << -expreg.first << endl;
+        }
+    }
+
+    if (mask & FEAT_MOD_VIG) {
+        if(verbose)
+            cerr << "Computing COMMUNITY Structure (VIG)" << endl;
+        t_ini = wall_time();
+        Community<G> c(vig);
+        c.budget = budget;
+        f.modularity = c.compute_modularity_GFA(precision);
+        c.compute_communities();
+        f.ncomm = c.ncomm;
+        f.secsMod = wall_time() - t_ini;
+        if(verbose){
+            cerr << "modularity = " << f.modularity << endl;
+            cerr << "communities = " << c.ncomm << endl;
+            cerr << "iterations = " << c.iterations << endl;
+            cerr << "visits = " << c.visits << " in " << c.sweeps.size() << " sweeps" << endl;
+        }
+    }
+
+    if (mask & FEAT_MOD_CVIG) {
+        if(verbose)
+            cerr << "Computing COMMUNITY Structure (CVIG)" << endl;
+        t_ini = wall_time();
+        Community<C> c_bip(cvig);
+        c_bip.budget = budget;
+        f.modularity_bip = c_bip.compute_modularity_GFA(precision);
+        c_bip.compute_communities();
+        f.ncomm_bip = c_bip.ncomm;
+        f.secsModBip = wall_time() - t_ini;
+        if(verbose){
+            cerr << "modularity = " << f.modularity_bip << endl;
+            cerr << "communities = " << c_bip.ncomm << endl;
+            cerr << "iterations = " << c_bip.iterations << endl;
+            cerr << "visits = " << c_bip.visits << " in " << c_bip.sweeps.size() << " sweeps" << endl;
+        }
+    }
+
+    delete vig;
+    delete cvig;
+}
+
+//------------------------------------------------------------------------------
+// Computes the features selected in "mask" (FEAT_* flags) of a CNF file, 
+// with the graph instantiation fitting its size. The graph features stop
+// after "timelimit" seconds, if not 0, keeping the results found so far.
+// The file is read once: the base features and the distributions of the
+// scale-free ones are counted while the graphs are built, or in a pass of
+// their own without graphs.
+//------------------------------------------------------------------------------
+Features compute_features(const FormulaSource &fin, int max_clauses, int mask) {
+
+    double t_ini;
+    Features f;
+
+    f.instance = fin.name();
+    f.secsGraphs = f.secsAlphaVar = f.secsAlphaClau = 0;
+    f.secsDim = f.secsDib = f.secsMod = f.secsModBip = 0;
+    f.alphavarexp = f.alphaclauexp = f.dim = f.dimbip = -1;
+    f.modularity = f.modularity_bip = -1;
+    f.ncomm = f.ncomm_bip = -1;
+    f.base.clear();
+    f.secsBase = 0;
+    f.truncated = false;
+
+    BaseCounter counter;
+    BaseCounter* count = mask & (FEAT_BASE | FEAT_ALPHA_VAR | FEAT_ALPHA_CLAUSE) ? &counter : NULL;
+
+    if (mask & (FEAT_DIM_VIG | FEAT_MOD_VIG | FEAT_DIM_CVIG | FEAT_MOD_CVIG)) {
+        Budget budget(timelimit > 0 ? timelimit : -1);
+        GraphType type = graph_type(fin, mask & (FEAT_DIM_CVIG | FEAT_MOD_CVIG));
+        if (type == GRAPH_HUGE)
+            compute_graph_features<GraphHuge>(fin, max_clauses, mask, f, &budget, count);
+        else if (type == GRAPH_LARGE)
+            compute_graph_features<GraphLarge>(fin, max_clauses, mask, f, &budget, count);
+        else if (type == GRAPH_COMPRESSED)
+            compute_graph_features<GraphCompressed>(fin, max_clauses, mask, f, &budget, count);
+        else
+            compute_graph_features<GraphSmall>(fin, max_clauses, mask, f, &budget, count);
+        f.truncated = budget.truncated;
+    } else if (count != NULL) {
+        t_ini = wall_time();
+        counter.read(fin);
+        f.secsBase = wall_time() - t_ini;
+    }
+
+    if (mask & FEAT_BASE) {
+        t_ini = wall_time();
+        f.base = counter.features();
+        f.secsBase += wall_time() - t_ini;
+    }
+
+    if (mask & FEAT_ALPHA_VAR) {
+        if(verbose)
+            cerr << "Computing SCALE-FREE Structure (Variables)" << endl;
+        t_ini = wall_time();
+        vector<pair <long long,long long> > a = counter.arity_var();
+        f.alphavarexp = mostlikely(a, maxxmin, alphavar, varint, varplot, true);
+        f.secsAlphaVar = wall_time() - t_ini;
+    }
+
+    if (mask & FEAT_ALPHA_CLAUSE) {
+        if(verbose)
+            cerr << "Computing SCALE-FREE Structure (Clauses)" << endl;
+        t_ini = wall_time();
+        vector<pair <long long,long long> > b = counter.arity_clause();
+        f.alphaclauexp = mostlikely(b, maxxmin, alphaclau, clauint, clauplot, false);
+        f.secsAlphaClau = wall_time() - t_ini;
+    }
+
+    f.secsTotal = f.secsGraphs + f.secsBase + f.secsAlphaVar + f.secsAlphaClau + f.secsDim + f.secsDib + f.secsMod + f.secsModBip;
+    return f;
+}
+
+//------------------------------------------------------------------------------
+// Estimates of the features of a formula on growing samples of its clauses
+//------------------------------------------------------------------------------
+struct SampleStep {
+    long long clauses;          // Clauses of the sample
+    long long vars;             // Variables in them
+    Features f;
+    double change;              // Greatest relative change of an estimate from the previous step
+};
+
+struct SampleTrace {
+    vector<SampleStep> steps;
+    long long total;            // Clauses of the formula
+    bool converged;             // The last step changed at most the tolerance
+    double secsSample;          // Reading the sample
+};
+
+// Relative change from "a" to "b", infinite if some of them is undefined
+double relative_change(double a, double b) {
+    if (!isfinite(a) || !isfinite(b) || a == -1 || b == -1)
+        return INFINITY;
+    if (a == b)
+        return 0;
+    return fabs(b - a) / max(fabs(a), fabs(b));
+}
+
+// Greatest relative change of the features selected in "mask" from "a" to "b"
+double features_change(Features &a, Features &b, int mask) {
+    double c = 0;
+    if (mask & FEAT_ALPHA_VAR) c = max(c, relative_change(a.alphavarexp, b.alphavarexp));
+    if (mask & FEAT_ALPHA_CLAUSE) c = max(c, relative_change(a.alphaclauexp, b.alphaclauexp));
+    if (mask & FEAT_DIM_VIG) c = max(c, relative_change(a.dim, b.dim));
+    if (mask & FEAT_DIM_CVIG) c = max(c, relative_change(a.dimbip, b.dimbip));
+    if (mask & FEAT_MOD_VIG) c = max(c, relative_change(a.modularity, b.modularity));
+    if (mask & FEAT_BASE) {
+        c = max(c, relative_change(a.base.size_mean, b.base.size_mean));
+        c = max(c, relative_change(a.base.positive, b.base.positive));
+        c = max(c, relative_change(a.base.horn, b.base.horn));
+    }
+    if (mask & FEAT_MOD_CVIG) c = max(c, relative_change(a.modularity_bip, b.modularity_bip));
+    return c;
+}
+
+//------------------------------------------------------------------------------
+// Computes the features selected in "mask" on a sample of the clauses of a
+// formula (see ClauseSample) of at most "limit" clauses (0 for all of them),
+// starting with a prefix of "first" clauses of it and growing it by
+// "growth", until the features change at most "tol" (relatively) from one
+// step to the next, or the sample is exhausted. Small samples are sparser
+// than the formula, so features depending on the density (dimension and
+// alpha) only converge when samples cover most of the variables.
+//------------------------------------------------------------------------------
+SampleTrace progressive_features(const FormulaSource &fin, int max_clauses, int mask, int mode,
+                                 long long first, double growth, long long limit, double tol,
+                                 uint64_t seed) {
+
+    SampleTrace trace;
+    trace.converged = false;
+
+    double t_ini = wall_time();
+    ClauseSample sample;
+    sample.read(fin, mode, limit, seed);
+    trace.total = sample.clauses();
+    trace.secsSample = wall_time() - t_ini;
+
+    long long n = first > 0 ? first : 1;
+    while (true) {
+        if (n > sample.size())
+            n = sample.size();
+        SampleStep step;
+        FormulaSource prefix = sample.prefix(n);
+        step.clauses = n;
+        step.vars = prefix.nvars;
+        step.f = compute_features(prefix, max_clauses, mask);
+        step.f.instance = fin.name();
+        step.change = trace.steps.empty() ? INFINITY : features_change(trace.steps.back().f, step.f, mask);
+        trace.steps.push_back(step);
+        if(verbose)
+            cerr << "\tSample of " << n << " clauses: change = " << step.change << endl;
+        if (step.change <= tol) {
+            trace.converged = true;
+            break;
+        }
+        if (n == sample.size())
+            break;
+        n = max(n + 1, (long long)ceil(n * growth));
+    }
+    return trace;
+}
+
+//------------------------------------------------------------------------------
+// Prints the features as a CSV row, with the columns of feature_names
+//------------------------------------------------------------------------------
+void print_features_csv(ostream &out, Features &f) {
+
+    if (f.instance.find_first_of(",\"") == string::npos) {
+        out << f.instance;
+    } else {
+        out << '"';
+        for (size_t i=0; i<f.instance.size(); i++) {
+            if (f.instance[i] == '"') out << '"';
+            out << f.instance[i];
+        }
+        out << '"';
+    }
+    out << "," << f.secsGraphs << "," << f.alphavarexp << "," << f.secsAlphaVar << "," << f.alphaclauexp << "," << f.secsAlphaClau << "," << f.dim << "," << f.secsDim << "," << f.dimbip << "," << f.secsDib << "," << f.modularity << "," << f.ncomm << "," << f.secsMod << "," << f.modularity_bip << "," << f.ncomm_bip << "," << f.secsModBip << ","  << f.secsTotal;
+    BaseFeatures &b = f.base;
+    out << "," << b.vars << "," << b.clauses << "," << b.ratio << "," << b.size_mean << "," << b.size_std << "," << b.size_min << "," << b.size_max << "," << b.unit << "," << b.binary << "," << b.ternary << "," << b.horn << "," << b.dual_horn << "," << b.positive << "," << b.balance_clause_mean << "," << b.balance_clause_std << "," << b.balance_var_mean << "," << b.balance_var_std << "," << b.degree_mean << "," << b.degree_std << "," << b.degree_min << "," << b.degree_max << "," << b.horny_mean << "," << b.horny_std << "," << f.secsBase << "," << f.truncated << endl;
+}
+
+// A double written as a JSON number, or as null if not finite
+struct JsonNumber {
+    double x;
+    JsonNumber(double v) : x(v) {}
+};
+
+ostream& operator<<(ostream &out, const JsonNumber &n) {
+    if (isfinite(n.x))
+        return out << n.x;
+    return out << "null";
+}
+
+//------------------------------------------------------------------------------
+// Prints the features as a JSON object in a single line
+//------------------------------------------------------------------------------
+void print_features_json(ostream &out, Features &f) {
+
+    out << "{\"instance\": \"";
+    for (size_t i=0; i<f.instance.size(); i++) {
+        char ch = f.instance[i];
+        if (ch == '"' || ch == '\\') out << '\\';
+        out << ch;
+    }
+    out << "\", \"time-buildGraphs\": " << JsonNumber(f.secsGraphs) 
+        << ", \"alphaVarExp\": " << JsonNumber(f.alphavarexp) << ", \"time-AlphaVar\": " << JsonNumber(f.secsAlphaVar)
+        << ", \"alphaClauExp\": " << JsonNumber(f.alphaclauexp) << ", \"time-AlphaClau\": " << JsonNumber(f.secsAlphaClau)
+        << ", \"dim\": " << JsonNumber(f.dim) << ", \"time-dim\": " << JsonNumber(f.secsDim)
+        << ", \"dim-bip\": " << JsonNumber(f.dimbip) << ", \"time-dimBip\": " << JsonNumber(f.secsDib)
+        << ", \"mod\": " << JsonNumber(f.modularity) << ", \"#comm-vig\": " << f.ncomm << ", \"time-mod\": " << JsonNumber(f.secsMod)
+        << ", \"mod-bip\": " << JsonNumber(f.modularity_bip) << ", \"#comm-cvig\": " << f.ncomm_bip << ", \"time-mod-bip\": " << JsonNumber(f.secsModBip)
+        << ", \"time-total\": " << JsonNumber(f.secsTotal);
+    BaseFeatures &b = f.base;
+    out << ", \"vars\": " << b.vars << ", \"clauses\": " << b.clauses << ", \"ratio\": " << JsonNumber(b.ratio)
+        << ", \"size-mean\": " << JsonNumber(b.size_mean) << ", \"size-std\": " << JsonNumber(b.size_std)
+        << ", \"size-min\": " << b.size_min << ", \"size-max\": " << b.size_max
+        << ", \"unit\": " << JsonNumber(b.unit) << ", \"binary\": " << JsonNumber(b.binary) << ", \"ternary\": " << JsonNumber(b.ternary)
+        << ", \"horn\": " << JsonNumber(b.horn) << ", \"dual-horn\": " << JsonNumber(b.dual_horn) << ", \"positive\": " << JsonNumber(b.positive)
+        << ", \"balance-clause-mean\": " << JsonNumber(b.balance_clause_mean) << ", \"balance-clause-std\": " << JsonNumber(b.balance_clause_std)
+        << ", \"balance-var-mean\": " << JsonNumber(b.balance_var_mean) << ", \"balance-var-std\": " << JsonNumber(b.balance_var_std)
+        << ", \"degree-mean\": " << JsonNumber(b.degree_mean) << ", \"degree-std\": " << JsonNumber(b.degree_std)
+        << ", \"degree-min\": " << b.degree_min << ", \"degree-max\": " << b.degree_max
+        << ", \"horny-mean\": " << JsonNumber(b.horny_mean) << ", \"horny-std\": " << JsonNumber(b.horny_std)
+        << ", \"time-base\": " << JsonNumber(f.secsBase)
+        << ", \"truncated\": " << (f.truncated ? "true" : "false") << "}" << endl;
+}
+
+// Test purposes
+double compute_all(const FormulaSource &fin, int max_clauses) {
+
+    // Maxclauses
+    cout << "max_clause: " << max_clauses << endl;
+
+    Features f = compute_features(fin, max_clauses, FEAT_ALL);
+
+    cerr << "Runtime = " << f.secsTotal << " secs" << endl;
+    cerr << "***************************************" << endl;
+    cout << feature_names << endl;
+    print_features_csv(cout, f);
+
+    return f.modularity;
+}
+
+#endif
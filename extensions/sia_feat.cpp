@@ -0,0 +1,325 @@
+/*
+    sia_feat.cpp
+
+    Command line tool computing the features of many CNF instances in
+    parallel, without a Python interpreter. Instances can be given as files,
+    directories (searched recursively for .cnf and .dimacs files) or lists
+    of files. Results are streamed as every instance finishes.
+
+    Usage: sia-feat [options] <file|directory>...
+
+*/
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "satfeatures.h"
+
+using namespace std;
+
+void usage() {
+    cerr << "Usage: sia-feat [options] <file|directory>...\n"
+         << "  -l FILE     read instances from FILE, one per line ('-' for stdin)\n"
+         << "  -f LIST     comma separated features: base, alpha-var, alpha-clause,\n"
+         << "              dim-vig, dim-cvig, mod-vig, mod-cvig or all (default)\n"
+         << "  -j N        number of threads (default, number of cores)\n"
+         << "  -o FILE     output file (default, stdout)\n"
+         << "  -F FORMAT   csv (default) or json (one object per line)\n"
+         << "  -r          resume: skip instances already in the output file\n"
+         << "  -c N        disregard clauses with more than N literals (default " << maxclause << ")\n"
+         << "  -p          add those clauses to the VIG as a star around a proxy node\n"
+         << "  -t SECS     stop the graph features of an instance after SECS seconds,\n"
+         << "              keeping the results found so far\n"
+         << "  -s MODE     estimate the features on growing samples of the clauses,\n"
+         << "              prefix, uniform or reservoir, until they converge\n"
+         << "  -e TOL      relative change of the estimates to converge (default 0.01)\n"
+         << "  -d N        estimate the dimensions from the balls around N random centers\n"
+         << "  -m MB       build the VIG out of core, staging its edges in MB megabytes\n"
+         << "  -T DIR      directory of the scratch files of -m (default, $TMPDIR)\n"
+         << "  -z          keep the VIG in compressed rows, in about a quarter of the memory\n"
+         << "  -v          verbose\n";
+}
+
+//------------------------------------------------------------------------------
+// Adds to "instances" the path, or the CNF files under it if it is a directory
+//------------------------------------------------------------------------------
+void add_instances(const string &path, vector<string> &instances) {
+
+    error_code ec;
+    if (filesystem::is_directory(path, ec)) {
+        vector<string> found;
+        for (filesystem::recursive_directory_iterator it(path, ec), end; it != end; it.increment(ec)) {
+            string ext = it->path().extension().string();
+            if (it->is_regular_file(ec) && (ext == ".cnf" || ext == ".dimacs"))
+                found.push_back(it->path().string());
+        }
+        sort(found.begin(), found.end());
+        instances.insert(instances.end(), found.begin(), found.end());
+    } else {
+        instances.push_back(path);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns the instances already present in an output file, i.e. the first
+// CSV column or the "instance" member of every JSON line. Only complete rows
+// count: ended by a newline, with all the columns of feature_names, and not
+// truncated by the time limit.
+//------------------------------------------------------------------------------
+set<string> done_instances(const string &filename, bool json) {
+
+    set<string> done;
+    ifstream in(filename.c_str());
+    string line;
+    size_t columns = count(feature_names, feature_names + strlen(feature_names), ',');
+
+    while (getline(in, line)) {
+        if (in.eof())
+            break;                              // Cut before its newline
+        string name;
+        size_t i = 0;
+        if (json) {
+            const string key = "{\"instance\": \"";
+            if (line.compare(0, key.size(), key) != 0) continue;
+            for (i = key.size(); i < line.size() && line[i] != '"'; i++) {
+                if (line[i] == '\\' && i+1 < line.size()) i++;
+                name += line[i];
+            }
+            if (i == line.size()) continue;     // Truncated line
+        } else if (!line.empty() && line[0] == '"') {
+            for (i = 1; i < line.size(); i++) {
+                if (line[i] == '"') {
+                    if (i+1 < line.size() && line[i+1] == '"') i++;
+                    else break;
+                }
+                name += line[i];
+            }
+        } else {
+            name = line.substr(0, line.find(','));
+            if (name == "#instances") continue;
+            i = name.size();
+        }
+        // Commas after the name, that may have some. Truncated rows are redone.
+        size_t commas = count(line.begin() + min(i, line.size()), line.end(), ',');
+        if (json ? line[line.size()-1] != '}' || line.find("\"truncated\": true}") != string::npos
+                 : commas != columns || line.compare(line.size()-2, 2, ",1") == 0)
+            continue;
+        done.insert(name);
+    }
+    return done;
+}
+
+// Whether a file is empty or ends with a newline
+bool ends_line(const string &filename) {
+    ifstream in(filename.c_str(), ios::binary | ios::ate);
+    if (!in || in.tellg() <= 0)
+        return true;
+    in.seekg(-1, ios::end);
+    return in.get() == '\n';
+}
+
+int main(int argc, char** argv) {
+
+    vector<string> instances;
+    int mask = FEAT_ALL;
+    int jobs = thread::hardware_concurrency();
+    char* outname = NULL;
+    bool json = false;
+    bool resume = false;
+    int sampling = -1;          // SampleMode, or -1 for the whole formulas
+    double tolerance = 0.01;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "l:f:j:o:F:rc:pt:s:e:d:m:T:zvh")) != -1) {
+        switch (opt) {
+        case 'l': {
+            istream* in = &cin;
+            ifstream fin;
+            if (strcmp(optarg, "-") != 0) {
+                fin.open(optarg);
+                if (!fin) {
+                    cerr << "Unable to read list " << optarg << endl;
+                    return 1;
+                }
+                in = &fin;
+            }
+            string line;
+            while (getline(*in, line))
+                if (!line.empty()) add_instances(line, instances);
+            break;
+        }
+        case 'f':
+            if ((mask = parse_features(optarg)) < 0) return 1;
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+        case 'o':
+            outname = optarg;
+            break;
+        case 'F':
+            if (strcmp(optarg, "json") == 0) json = true;
+            else if (strcmp(optarg, "csv") != 0) {
+                cerr << "Unknown format " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'r':
+            resume = true;
+            break;
+        case 'c':
+            maxclause = atoi(optarg);
+            break;
+        case 'p':
+            proxyclause = true;
+            break;
+        case 't':
+            timelimit = atof(optarg);
+            break;
+        case 's':
+            if (strcmp(optarg, "prefix") == 0) sampling = SAMPLE_PREFIX;
+            else if (strcmp(optarg, "uniform") == 0) sampling = SAMPLE_UNIFORM;
+            else if (strcmp(optarg, "reservoir") == 0) sampling = SAMPLE_RESERVOIR;
+            else {
+                cerr << "Unknown sampling mode " << optarg << endl;
+                return 1;
+            }
+            break;
+        case 'e':
+            tolerance = atof(optarg);
+            break;
+        case 'd':
+            dimsamples = atoi(optarg);
+            break;
+        case 'm':
+            vigmemory = (size_t)(atof(optarg) * (1 << 20));
+            break;
+        case 'T':
+            scratchdir = optarg;
+            break;
+        case 'z':
+            compressgraph = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    for (int i = optind; i < argc; i++)
+        add_instances(argv[i], instances);
+
+    if (instances.empty()) {
+        usage();
+        return 1;
+    }
+    if (resume && outname == NULL) {
+        cerr << "Resuming needs an output file (-o)" << endl;
+        return 1;
+    }
+    if (jobs < 1) jobs = 1;
+
+    // Skip the instances already computed
+    set<string> done;
+    if (resume)
+        done = done_instances(outname, json);
+    vector<string> pending;
+    for (size_t i = 0; i < instances.size(); i++)
+        if (done.find(instances[i]) == done.end())
+            pending.push_back(instances[i]);
+
+    ofstream fout;
+    ostream* out = &cout;
+    if (outname != NULL) {
+        bool fresh = !resume || done.empty();
+        bool cut = !fresh && !ends_line(outname);
+        fout.open(outname, fresh ? ios::out : ios::out | ios::app);
+        if (!fout) {
+            cerr << "Unable to open file " << outname << " for writing" << endl;
+            return 1;
+        }
+        out = &fout;
+        if (fresh && !json) *out << feature_names << endl;
+        if (cut) *out << endl;          // The cut row keeps a line of its own
+    } else if (!json) {
+        *out << feature_names << endl;
+    }
+
+    if (verbose)
+        cerr << pending.size() << " instances pending, " << done.size() << " done" << endl;
+
+    // Workers take the next pending instance until none is left
+    atomic<size_t> next(0);
+    mutex out_mutex;
+    int failed = 0;
+
+    auto worker = [&]() {
+#ifdef _OPENMP
+        // Instances are already processed in parallel
+        if (jobs > 1) omp_set_num_threads(1);
+#endif
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            FILE* f = fopen(pending[i].c_str(), "r");
+            if (f == NULL) {
+                lock_guard<mutex> lock(out_mutex);
+                cerr << "Unable to read CNF file " << pending[i] << endl;
+                failed++;
+                continue;
+            }
+            fclose(f);
+
+            Features feat;
+            SampleTrace trace;
+            try {
+                if (sampling < 0) {
+                    feat = compute_features((char*)pending[i].c_str(), maxclause, mask);
+                } else {
+                    // Estimates of the last sample, with the time of all of them
+                    trace = progressive_features((char*)pending[i].c_str(), maxclause, mask, sampling,
+                                                 10000, 2, 0, tolerance, 0);
+                    feat = trace.steps.back().f;
+                    feat.secsTotal = trace.secsSample;
+                    for (size_t k=0; k<trace.steps.size(); k++)
+                        feat.secsTotal += trace.steps[k].f.secsTotal;
+                }
+            } catch (const FormulaError &e) {
+                // Malformed instances are left out, the others go on
+                lock_guard<mutex> lock(out_mutex);
+                cerr << pending[i] << ": " << e.what() << endl;
+                failed++;
+                continue;
+            }
+
+            lock_guard<mutex> lock(out_mutex);
+            if (sampling >= 0)
+                cerr << pending[i] << ": estimated on " << trace.steps.back().clauses << " of "
+                     << trace.total << " clauses" << (trace.converged ? "" : ", not converged") << endl;
+            if (feat.truncated)
+                cerr << "Time limit reached in " << pending[i] << ", features truncated" << endl;
+            if (json) print_features_json(*out, feat);
+            else print_features_csv(*out, feat);
+            out->flush();
+        }
+    };
+
+    vector<thread> pool;
+    for (size_t t = 0; t < (size_t)jobs && t < pending.size(); t++)
+        pool.push_back(thread(worker));
+    for (size_t t = 0; t < pool.size(); t++)
+        pool[t].join();
+
+    if (failed > 0)
+        cerr << failed << " instances failed" << endl;
+    return failed > 0 ? 2 : 0;
+}
@@ -33,11 +33,11 @@ Contact: jgiraldez@iiia.csic.es
 #include <stdlib.h>
 #include <string.h>
 #include <string>
-#ifndef VECTOR
-#include "graph_set.h"
-#else
-#include "graph_vector.h"
-#endif
+#include <memory>
+#include "cpu.h"
+#include "formula.h"
+#include "graph.h"
+#include "basefeatures.h"
 
 #ifndef TOOLS_H
 #define TOOLS_H
@@ -45,6 +45,8 @@ Contact: jgiraldez@iiia.csic.es
 using namespace std;
 
 extern bool verbose;
+extern size_t vigmemory;           // Defaults of the out of core VIGs (see spill_edges)
+extern const char* scratchdir;
 
 
 
@@ -63,6 +65,7 @@ double abs_tools(double x) {
 // Computes sum_{i=x}^{\infty} x^{alpha} / sum_{i=xmin}^{\infty} x^{alpha} 
 // or approximates it as (x/xmin)^(alpha+1)
 //-----------------------------------------------------------------------------
+MULTIVERSION
 double powlawc(int x, int xmin, double alpha) {
 
     assert(alpha < -1);
@@ -73,8 +76,10 @@ double powlawc(int x, int xmin, double alpha) {
   
     if (xmin < 25) {
     
-    for (i=xmin; i<x; i++)
-        den += pow(i, alpha);
+    #pragma omp simd reduction(+:den)
+    for (int k=xmin; k<x; k++)
+        den += pow(k, alpha);
+    i = x;
     
     double pold = -2, p = -1;
     int n = 0;
@@ -104,7 +109,8 @@ double exponc(int x, int xmin, double beta) {
 //------------------------------------------------------------------------------
 // Compute vectors x, y, sxy, sylogx
 //------------------------------------------------------------------------------
-double mostlikely(vector <pair <int,int> > v, int maxxmin, char* fileout, char *nint, char *nplot, bool var) {
+MULTIVERSION
+double mostlikely(vector <pair <long long,long long> > v, int maxxmin, char* fileout, char *nint, char *nplot, bool var) {
 
     int n=v.size();
     vector <double> x(n), y(n+1), syx(n+1), sylogx(n+1);
@@ -290,12 +296,15 @@ return -bestalpha;
 //------------------------------------------------------------------------------
 // Given a vector of points, computes the alpha and beta of a regression
 //------------------------------------------------------------------------------
+MULTIVERSION
 pair <double,double> regresion(vector <pair <double,double> > &v) {
     //std::cout << "Empieza regresion\n";
     double Sx = 0, Sy = 0, Sxx = 0, Syy = 0, Sxy = 0;
-    for (vector<pair <double,double> >::iterator it=v.begin(); it != v.end(); it++) {
-        double x = it->first;
-        double y = it->second;
+    pair <double,double>* p = v.data();
+    #pragma omp simd reduction(+:Sx,Sy,Sxx,Syy,Sxy)
+    for (int i=0; i < (int)v.size(); i++) {
+        double x = p[i].first;
+        double y = p[i].second;
         Sx += x;
         Sy += y;
         Sxx += x * x;
@@ -326,58 +335,142 @@ void shuffle(vector <int> &x) {
 
 
 //------------------------------------------------------------------------------
-// Given a CNF file (filename) in DIMACS format, creates it correspondent 
-// formula disregarding clauses of size greater than MAXCLAUSE
-//------------------------------------------------------------------------------        
-pair<Graph*,Graph*> readFormula(char* filename, int MAXCLAUSE){
+// Adds a clause (list of variables numbered from 0) to the VIG as a clique 
+// with edges of weight 2/(k(k-1)), k being the size of the clause
+//------------------------------------------------------------------------------
+template <class G, class T>
+void addClauseVIG(G* vig, vector<T> &clause) {
+
+    if (clause.size() > 1) {
+        double weight_vig = 2.0 / (clause.size() * (clause.size()-1) );
+        for (size_t i=0; i<clause.size()-1; i++){
+            for (size_t j=i+1; j<clause.size(); j++){
+                vig->add_edge(clause[i], clause[j], weight_vig);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Adds a clause (list of variables numbered from 0) to the VIG as a star 
+// around a proxy node p, with edges of weight 1/k. The edges are linear in
+// k, instead of quadratic, and a community with the clause and its proxy 
+// gets the same internal weight (1) and arity (2) as with the clique.
+//------------------------------------------------------------------------------
+template <class G, class T>
+void addClauseVIGProxy(G* vig, vector<T> &clause, typename G::node_t p) {
 
-    FILE *source;
-    source = fopen(filename, "r");
-    if(!source){
-        cerr << "Unable to read CNF file " << filename << endl;
-        exit(-1);
+    double weight_proxy = 1.0/clause.size();
+    for (size_t i=0; i<clause.size(); i++){
+        vig->add_edge(clause[i], p, weight_proxy);
     }
+}
 
-    int totVars=0, totClauses=0;
-    int var=0;
-    int aux=-1;
+//------------------------------------------------------------------------------
+// Adds a clause (list of variables numbered from 0) to the CVIG, linking the
+// clause node c with its variables by edges of weight 1/k
+//------------------------------------------------------------------------------
+template <class G, class T>
+void addClauseCVIG(G* cvig, vector<T> &clause, typename G::node_t c) {
+
+    double weight_cvig = 1.0/clause.size();
+    for (size_t i=0; i<clause.size(); i++){
+        cvig->add_edge(clause[i], c, weight_cvig);
+    }
+}
 
-    // Skip comments
-    while((aux=getc(source))=='c'){
-        while(getc(source)!='\n');
+//------------------------------------------------------------------------------
+// Removes a clause added by addClauseVIG from the VIG
+//------------------------------------------------------------------------------
+template <class G, class T>
+void removeClauseVIG(G* vig, vector<T> &clause) {
+
+    if (clause.size() > 1) {
+        double weight_vig = 2.0 / (clause.size() * (clause.size()-1) );
+        for (size_t i=0; i<clause.size()-1; i++){
+            for (size_t j=i+1; j<clause.size(); j++){
+                vig->remove_edge(clause[i], clause[j], weight_vig);
+            }
+        }
     }
-    ungetc(aux,source);
+}
 
-    // File Head
-    if( !fscanf(source, "p cnf %i %i", &totVars, &totClauses)) {
-        cerr << "Invalid CNF file\n";
-        exit(-1);
+//------------------------------------------------------------------------------
+// Removes a clause added by addClauseCVIG as clause node c from the CVIG
+//------------------------------------------------------------------------------
+template <class G, class T>
+void removeClauseCVIG(G* cvig, vector<T> &clause, typename G::node_t c) {
+
+    double weight_cvig = 1.0/clause.size();
+    for (size_t i=0; i<clause.size(); i++){
+        cvig->remove_edge(clause[i], c, weight_cvig);
     }
+}
+
+//------------------------------------------------------------------------------
+// Builds a VIG kept in compressed sparse rows (or in compressed rows, staged
+// in sparse rows) out of core, staging its edges in at most "memory" bytes
+// (if positive) and spilling the rest to files in "dir". Other storages
+// stage their edges in memory.
+//------------------------------------------------------------------------------
+template <class G>
+void spill_edges(G* vig, size_t memory, const char* dir) {}
 
-    Graph* vig  = new Graph(totVars, 0);
-    Graph* cvig = new Graph(totVars, totClauses);
+template <class Node, class Weight>
+void spill_edges(GraphT<Node,Weight,CSRStorage>* vig, size_t memory, const char* dir) {
+    if (memory > 0)
+        vig->spill(memory, dir);
+}
+
+template <class Node, class Weight>
+void spill_edges(GraphT<Node,Weight,CompressedStorage>* vig, size_t memory, const char* dir) {
+    if (memory > 0)
+        vig->spill(memory, dir);
+}
+
+//------------------------------------------------------------------------------
+// Given a CNF formula (filename), a DIMACS file or a formula in memory (see 
+// formula.h), creates it correspondent formula disregarding clauses of size 
+// greater than MAXCLAUSE, or adding them to the VIG with a proxy node if
+// "proxies" (see readVIG). Every literal read is also fed to "counter", if
+// any, with all the clauses. The VIG is built out of core as spill_edges
+// does, by default as set by sia-feat.
+//------------------------------------------------------------------------------        
+template <class G = Graph, class C = G>
+pair<G*,C*> readFormula(const FormulaSource &filename, int MAXCLAUSE, bool proxies = false,
+                        BaseCounter* counter = NULL, size_t memory = vigmemory,
+                        const char* dir = scratchdir){
+
+    FormulaReader reader(filename);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filename.name(), true);
+
+    long long totVars=0, totClauses=0;
+    int var=0;
+
+    // Skip comments and read the head
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filename.name());
+    if (counter != NULL)
+        counter->resize(totVars);
+
+    unique_ptr<G> vig(new G(totVars, 0));     // Deleted if reading throws
+    unique_ptr<C> cvig(new C(totVars, totClauses));
+    spill_edges(vig.get(), memory, dir);
     
     // Read the clauses
     vector<int> clause;
-    int nclauses=0;
+    typename C::node_t nclauses=0;
 
-    while(fscanf(source, "%i", &var)==1) {
+    while(reader.next(var)) {
+        if (counter != NULL)
+            counter->next(var);
         if (var==0) {
-            if (clause.size() <= MAXCLAUSE && clause.size()>0) {    
-                double weight_vig = 0;
-                double weight_cvig = 1.0/clause.size();
-                if(clause.size()>1){
-                    weight_vig = 2.0 / (clause.size() * (clause.size()-1) );
-                    for (int i=0; i<clause.size()-1; i++){
-                        cvig->add_edge(clause[i], totVars+nclauses, weight_cvig);
-                        for (int j=i+1; j<clause.size(); j++){
-                            vig->add_edge(clause[i], clause[j], weight_vig);
-                        }
-                    }
-                    cvig->add_edge(clause[clause.size()-1], totVars+nclauses, weight_cvig);
-                }else if(clause.size()==1){
-                    cvig->add_edge(clause[0], totVars+nclauses, weight_cvig);   
-                }
+            if (clause.size() <= (size_t)MAXCLAUSE && clause.size()>0) {    
+                addClauseVIG(vig.get(), clause);
+                addClauseCVIG(cvig.get(), clause, totVars+nclauses);
+            } else if (proxies && clause.size()>0) {
+                addClauseVIGProxy(vig.get(), clause, vig->add_nodes(1));
             } else {
                 if(verbose)
                     cerr << "\tDisregarded clause of size " << clause.size() << endl;
@@ -385,126 +478,108 @@ pair<Graph*,Graph*> readFormula(char* filename, int MAXCLAUSE){
             nclauses++;
             clause.clear();
         } else {
-            if (abs(var) > totVars) {
-                cerr << "Unvalid variable number " << abs(var) << endl;
-                exit(-1);
-            }
+            if (abs(var) > totVars)
+                throw FormulaError("Unvalid variable number " + to_string(abs(var)));
             clause.push_back(abs(var)-1);
         }
     }
     
-    fclose(source);
+    vig->finalize();
+    cvig->finalize();
     
-    return make_pair(vig,cvig);
+    return make_pair(vig.release(),cvig.release());
 }
 
 //------------------------------------------------------------------------------
-// Given a CNF file (filename) in DIMACS format, creates it correspondent 
-// formula disregarding clauses of size greater than MAXCLAUSE
+// Given a CNF formula (filename), a DIMACS file or a formula in memory (see 
+// formula.h), creates it correspondent formula disregarding clauses of size 
+// greater than MAXCLAUSE. If "proxies", those clauses are added as a star
+// around a new node instead, numbered after the variables. Every literal
+// read is also fed to "counter", if any. The VIG is built out of core as
+// spill_edges does, by default as set by sia-feat.
 //------------------------------------------------------------------------------    
-Graph* readVIG(char* filename, int MAXCLAUSE){
+template <class G = Graph>
+G* readVIG(const FormulaSource &filename, int MAXCLAUSE, bool proxies = false,
+           BaseCounter* counter = NULL, size_t memory = vigmemory, const char* dir = scratchdir){
     
-    FILE *source;
-    source = fopen(filename, "r");
-    if(!source){
-        cerr << "Unable to read CNF file " << filename << endl;
-        exit(-1);
-    }
+    FormulaReader reader(filename);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filename.name(), true);
 
-    int totVars=0, totClauses=0;
+    long long totVars=0, totClauses=0;
     int var=0;
-    int aux=-1;
 
-    // Skip comments
-    while((aux=getc(source))=='c'){
-        while (getc(source)!='\n')
-            ;
-    }
-    ungetc(aux,source);
+    // Skip comments and read the head
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filename.name());
+    if (counter != NULL)
+        counter->resize(totVars);
 
-    // File Head
-    if( !fscanf(source, "p cnf %i %i", &totVars, &totClauses)) {
-        cerr << "Invalid CNF file\n";
-        exit(-1);
-    }
-
-    Graph* vig = new Graph(totVars, 0);
+    unique_ptr<G> vig(new G(totVars, 0));     // Deleted if reading throws
+    spill_edges(vig.get(), memory, dir);
     
     // Read the clauses
     vector<int> clause;
 
-    while(fscanf(source, "%i", &var)==1) {
+    while(reader.next(var)) {
+        if (counter != NULL)
+            counter->next(var);
         if (var==0) {
-            if (clause.size() <= MAXCLAUSE && clause.size()>1) {    
-                double weight_vig = 2.0 / (clause.size() * (clause.size()-1) );
-                for (int i=0; i<clause.size()-1; i++){
-                    for (int j=i+1; j<clause.size(); j++){
-                        vig->add_edge(clause[i], clause[j], weight_vig);
-                    }
-                }
+            if (clause.size() <= (size_t)MAXCLAUSE && clause.size()>1) {    
+                addClauseVIG(vig.get(), clause);
+            } else if (proxies && clause.size()>1) {
+                addClauseVIGProxy(vig.get(), clause, vig->add_nodes(1));
             } else {
                 if(verbose && clause.size()>1)
                     cerr << "\tDisregarded clause of size " << clause.size() << endl;
             }
             clause.clear();
         } else {
-            if (abs(var) > totVars) {
-                cerr << "Unvalid variable number " << abs(var) << endl;
-                exit(-1);
-            }
+            if (abs(var) > totVars)
+                throw FormulaError("Unvalid variable number " + to_string(abs(var)));
             clause.push_back(abs(var)-1);
         }
     }
     
-    fclose(source);
+    vig->finalize();
     
-    return vig;
+    return vig.release();
 }
 
 
 //------------------------------------------------------------------------------
-// Given a CNF file (filename) in DIMACS format, creates it correspondent 
-// formula disregarding clauses of size greater than MAXCLAUSE
+// Given a CNF formula (filename), a DIMACS file or a formula in memory (see 
+// formula.h), creates it correspondent formula disregarding clauses of size 
+// greater than MAXCLAUSE. Every literal read is also fed to "counter", if any.
 //------------------------------------------------------------------------------
-Graph* readCVIG(char* filename, int MAXCLAUSE){
+template <class G = Graph>
+G* readCVIG(const FormulaSource &filename, int MAXCLAUSE, BaseCounter* counter = NULL){
 
-    FILE *source;
-    source = fopen(filename, "r");
-    if(!source){
-        cerr << "Unable to read CNF file " << filename << endl;
-        exit(-1);
-    }
+    FormulaReader reader(filename);
+    if(!reader.open())
+        throw FormulaError("Unable to read CNF file " + filename.name(), true);
 
-    int totVars=0, totClauses=0;
+    long long totVars=0, totClauses=0;
     int var=0;
-    int aux=-1;
 
-    // Skip comments
-    while((aux=getc(source))=='c'){
-        while (getc(source)!='\n')
-            ;
-    }
-    ungetc(aux,source);
+    // Skip comments and read the head
+    if (!reader.header(totVars, totClauses))
+        throw FormulaError("Invalid CNF file " + filename.name());
+    if (counter != NULL)
+        counter->resize(totVars);
 
-    // File Head
-    if( !fscanf(source, "p cnf %i %i", &totVars, &totClauses)) {
-        cerr << "Invalid CNF file\n";
-        exit(-1);
-    }
-
-    Graph* cvig = new Graph(totVars,totClauses);
+    G* cvig = new G(totVars,totClauses);
     
     // Read the clauses
     vector<int> clause;
-    int nclauses=0;
+    typename G::node_t nclauses=0;
 
-    while(fscanf(source, "%i", &var)==1) {
+    while(reader.next(var)) {
+        if (counter != NULL)
+            counter->next(var);
         if (var==0) {
-            if (clause.size() <= MAXCLAUSE && clause.size()>0) {    
-                double weight_cvig = 1.0/clause.size();
-                for (int i=0; i<clause.size(); i++){
-                    cvig->add_edge(clause[i], totVars+nclauses, weight_cvig);
-                }
+            if (clause.size() <= (size_t)MAXCLAUSE && clause.size()>0) {    
+                addClauseCVIG(cvig, clause, totVars+nclauses);
             } else {
                 if(verbose)
                     cerr << "\tDisregarded clause of size " << clause.size() << endl;
@@ -513,14 +588,14 @@ Graph* readCVIG(char* filename, int MAXCLAUSE){
             clause.clear();
         } else {
             if (abs(var) > totVars) {
-                cerr << "Unvalid variable number " << abs(var) << endl;
-                exit(-1);
+                delete cvig;
+                throw FormulaError("Unvalid variable number " + to_string(abs(var)));
             }
             clause.push_back(abs(var)-1);
         }
     }
     
-    fclose(source);
+    cvig->finalize();
     
     return cvig;
 }
@@ -31,11 +31,22 @@ if platform.system() == 'Linux':
 
 featsat_sources = ['extensions/featsat.cpp']
 
+# No -march flags: vectorized kernels are compiled for several instruction
+# sets and the best one is selected at import time (see extensions/cpu.h)
+featsat_compile_args = ['-Wall', '-O3']
+featsat_link_args = []
+
+# OpenMP (parallel community aggregation); Apple's clang lacks it by default
+if platform.system() != 'Darwin':
+    featsat_compile_args.append('-fopenmp')
+    featsat_link_args.append('-fopenmp')
+
 featsat_ext = Extension(
     'featsat',
     sources=featsat_sources,
     include_dirs=['extensions'],
-    extra_compile_args=['-Wall'])
+    extra_compile_args=featsat_compile_args,
+    extra_link_args=featsat_link_args)
 
 # Setup Configuration
 
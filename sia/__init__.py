@@ -8,3 +8,5 @@ from . import backdoors
 from . import cnf
 from . import feat
 from . import io
+
+from featsat import Budget, Graph
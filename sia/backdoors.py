@@ -4,7 +4,10 @@ Module that implements propositional formula backdoors related functions.
 '''
 import itertools as it
 
+import featsat
+
 from . import cnf
+from . import feat
 
 
 class SynClass:
@@ -19,6 +22,7 @@ class SynClass:
 
         - Horn formulas
         - Dual Horn formulas
+        - Renameable Horn formulas
 
     '''
 
@@ -30,36 +34,50 @@ class SynClass:
     @staticmethod
     def is_horn(clauses):
         '''Checks if a formula belongs to the family of Horn formulas'''
-        flag = False
-        for clause in clauses:
-            for literal in clause:
-                if literal > 0:
-                    if not flag:
-                        flag = True
-                    else:
-                        return False
-            flag = False
-        return True
+        return not clauses or feat.features(clauses, 'base')['horn'] == 1
 
     @staticmethod
     def is_dual_horn(clauses):
         '''Checks if a formula belongs to the family of DualHorn formulas'''
-        flag = False
-        for clause in clauses:
-            for literal in clause:
-                if literal < 0:
-                    if not flag:
-                        flag = True
-                    else:
-                        return False
-            flag = False
-        return True
+        return not clauses or feat.features(clauses, 'base')['dual_horn'] == 1
 
     @staticmethod
     def is_renameable_horn(clauses):
-        '''Checks if a formula belongs to the family of RenameableHOrn formulas'''
-        # TODO
-        pass
+        '''Checks if a formula belongs to the family of RenameableHorn formulas'''
+        return horn_renaming(clauses) is not None
+
+
+def horn_renaming(formula):
+    '''
+    Returns the variables whose signs, flipped, make a formula (a file name,
+    DIMACS text, (literals, offsets) arrays or a list of clauses) Horn, or
+    None if it is not renameable Horn. Decided in linear time as 2-SAT.
+    '''
+    return featsat.renameable_horn(feat._formula(formula)[0])
+
+
+def strong_backdoor(formula, cls='horn', max_size=None, budget=None):
+    '''
+    Returns a smallest strong backdoor of a formula into the 'horn' or
+    '2cnf' class: a set of variables such that any assignment of them leaves
+    a formula of the class. Returns None if there is none of at most
+    max_size variables, or the sia.Budget expires first (setting
+    budget.truncated). Clauses are taken as sets of literals, and
+    tautologies are disregarded.
+    '''
+    size = -1 if max_size is None else max_size
+    return featsat.strong_backdoor(feat._formula(formula)[0], cls, size, budget)
+
+
+def weak_backdoor(formula, cls='horn', max_size=None, budget=None):
+    '''
+    Returns the literals of a smallest weak backdoor of a formula into the
+    'horn' or '2cnf' class: an assignment leaving a satisfiable formula of
+    the class, of at most max_size variables (and 30). Returns None as
+    strong_backdoor does, and for unsatisfiable formulas.
+    '''
+    size = -1 if max_size is None else max_size
+    return featsat.weak_backdoor(feat._formula(formula)[0], cls, size, budget)
 
 
 def all_subsets(n, size=None):
@@ -1,46 +1,101 @@
 '''
 This module interfaces the featsat C extension for a better control
+
+Formulas are given as file names, DIMACS text (bytes), pairs (literals,
+offsets) of integer arrays or lists of clauses (see _formula).
 '''
 
+import os
+import re
+from pathlib import Path
+
 import featsat
 from . import io
 
 
-def modularity(file_name, mode='vig'):
+def _is_buffer(obj):
     '''
-    Computes de modularity of a CNF formula from a given file.
-    It has VIG and CVIG mode.
+    Whether obj supports the buffer protocol, as the arrays of a pair
+    (literals, offsets)
+    '''
+
+    try:
+        memoryview(obj)
+    except TypeError:
+        return False
+    return True
+
+
+def _formula(formula):
+    '''
+    Argument of the featsat functions for a formula and its number of
+    clauses. Formulas are file names, DIMACS text (bytes), pairs (literals,
+    offsets) of integer arrays, where clause i is
+    literals[offsets[i]:offsets[i+1]], or lists of clauses. Formulas in
+    memory are read by featsat in place, over variables 1 to the greatest
+    one found (DIMACS text keeps its header).
+    '''
+
+    if isinstance(formula, (str, os.PathLike)):
+        _, _, clause_num = io.get_header(Path(formula))
+        return str(formula), clause_num
+
+    if isinstance(formula, (bytes, bytearray)):
+        header = re.search(rb'^\s*p\s+cnf\s+\d+\s+(\d+)', formula, re.M)
+        if header is None:
+            raise ValueError('No variable or clause number available')
+        return formula, int(header.group(1))
+
+    # Tuples of two clauses are lists of clauses too
+    if isinstance(formula, tuple) and len(formula) == 2 and all(map(_is_buffer, formula)):
+        return formula, len(memoryview(formula[1])) - 1
+
+    return formula, len(formula)
+
+
+def modularity(file_name, mode='vig', method='louvain', budget=None):
     '''
+    Computes de modularity of a CNF formula (a file or in memory).
+    It has VIG and CVIG mode, and 'louvain', 'louvain-queue' and 'leiden'
+    methods. The 'hypergraph' mode computes the VIG modularity with Louvain
+    on the clauses, without building the VIG, in linear memory.
 
-    file_name_str = file_name.__str__()
-    _, _, clause_num = io.get_header(file_name)
+    A sia.Budget stops the computation when its timeout expires or it is
+    cancelled, returning the modularity of the partition found so far and
+    setting budget.truncated.
+    '''
+
+    formula, clause_num = _formula(file_name)
 
     if mode == 'vig':
-        ans = featsat.modularity_vig(file_name_str, clause_num)
+        ans = featsat.modularity_vig(formula, clause_num, method, budget)
         return ans
 
     if mode == 'cvig':
-        ans = featsat.modularity_cvig(file_name_str, clause_num)
+        ans = featsat.modularity_cvig(formula, clause_num, method, budget)
         return ans
 
-    raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
+    if mode == 'hypergraph':
+        return featsat.modularity_hypergraph(formula, clause_num, budget)
 
+    raise ValueError(f'Argument mode={mode} not valid. Choose "vig", "cvig" or "hypergraph"')
 
-def self_similar(file_name, mode='vig'):
+
+def self_similar(file_name, mode='vig', budget=None):
     '''
-    Computes de fractal dimension of a CNF formula from a given file.
-    It has VIG and CVIG mode.
+    Computes de fractal dimension of a CNF formula (a file or in memory).
+    It has VIG and CVIG mode. With a sia.Budget, it is fitted to the
+    diameters of the box covering computed within it.
     '''
 
-    file_name_str = file_name.__str__()
-    _, _, clause_num = io.get_header(file_name)
+    formula, clause_num = _formula(file_name)
 
     if mode == 'vig':
-        ans = featsat.self_similar_vig(file_name_str, clause_num)
+        ans = featsat.self_similar_vig(formula, clause_num, budget)
         return ans
 
     if mode == 'cvig':
-        ans = featsat.self_similar_cvig(file_name_str, clause_num)
+        ans = featsat.self_similar_cvig(formula, clause_num, budget)
         return ans
 
     raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
@@ -48,19 +103,158 @@ def self_similar(file_name, mode='vig'):
 
 def scale_free(file_name, mode='var'):
     '''
-    Computes de scale free exponent of a CNF formula from a given file.
+    Computes de scale free exponent of a CNF formula (a file or in memory).
     It has var and clause mode.
     '''
 
-    file_name_str = file_name.__str__()
-    _, _, clause_num = io.get_header(file_name)
+    formula, clause_num = _formula(file_name)
 
     if mode == 'var':
-        ans = featsat.scale_free_var(file_name_str, clause_num)
+        ans = featsat.scale_free_var(formula, clause_num)
         return ans
 
     if mode == 'clause':
-        ans = featsat.scale_free_clause(file_name_str, clause_num)
+        ans = featsat.scale_free_clause(formula, clause_num)
         return ans
 
     raise ValueError(f'Argument mode={mode} not valid. Choose "var" or "clause"')
+
+
+def communities(file_name, mode='vig', partition=None, mapping=None, method='louvain',
+                budget=None):
+    '''
+    Computes the community structure of a CNF formula (a file or in memory).
+    It has VIG and CVIG mode.
+
+    If a partition of a previous version of the formula is given (e.g. the
+    'partition' of a previous result), community detection continues from
+    it. mapping[i] is the previous node of node i, or -1 for new nodes.
+    The 'leiden' method refines communities into well-connected parts
+    before collapsing them, and only revisits nodes whose neighborhood
+    changed. The 'louvain-queue' method is Louvain revisiting nodes that way
+    instead of sweeping all nodes until none moves.
+
+    Returns a dict with the modularity, the number of communities and the
+    arrays 'partition' (community of every node), 'dendrogram' (list with
+    the partition after every level), 'order' and 'sizes' (communities by
+    decreasing size), 'members' and 'offsets' (nodes of every community,
+    numbered from 1), and 'evaluated' and 'moved' (nodes evaluated and moved
+    in every sweep of the local moving). Arrays support the buffer protocol, so numpy.asarray
+    wraps them without copying. With a sia.Budget, 'truncated' tells if it
+    stopped the computation, returning the partition found so far.
+    '''
+
+    formula, clause_num = _formula(file_name)
+
+    if mode == 'vig':
+        return featsat.communities_vig(formula, clause_num, partition, mapping, method, budget)
+
+    if mode == 'cvig':
+        return featsat.communities_cvig(formula, clause_num, partition, mapping, method, budget)
+
+    raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
+
+
+def ensemble(file_name, mode='vig', runs=10, seed=0, consensus=False, method='louvain',
+             budget=None):
+    '''
+    Runs the community detection of a CNF formula several times in
+    parallel, reading it once. Every run has its own random generator
+    seeded from seed, so results are reproducible. It has VIG and CVIG mode.
+
+    Returns a dict with 'runs' (modularity of every run), 'best', 'mean'
+    and 'std' of them, the 'partition' of the best run, and if consensus,
+    a 'consensus' partition built from the groups of nodes that all runs
+    put together, and its 'consensus_modularity'. 'truncated' tells if the
+    sia.Budget given stopped the runs.
+    '''
+
+    formula, clause_num = _formula(file_name)
+
+    if mode == 'vig':
+        return featsat.ensemble_vig(formula, clause_num, runs, seed, consensus, method, budget)
+
+    if mode == 'cvig':
+        return featsat.ensemble_cvig(formula, clause_num, runs, seed, consensus, method, budget)
+
+    raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
+
+
+def box_covering(file_name, mode='vig', budget=None):
+    '''
+    Computes the box covering curve of a CNF formula (a file or in memory),
+    i.e. the number of boxes of diameter d needed for covering its graph.
+    It has VIG and CVIG mode. With a sia.Budget, the curve stops at the
+    last diameter computed within it.
+    '''
+
+    formula, clause_num = _formula(file_name)
+
+    if mode == 'vig':
+        return featsat.box_covering_vig(formula, clause_num, budget)
+
+    if mode == 'cvig':
+        return featsat.box_covering_cvig(formula, clause_num, budget)
+
+    raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
+
+
+def estimate_box_covering(file_name, mode='vig', samples=200, seed=0, budget=None):
+    '''
+    Estimates the box covering curve of a CNF formula (a file or in memory)
+    from the balls grown around samples random centers, for graphs where
+    box_covering is too slow. It has VIG and CVIG mode.
+
+    Returns a dict with the estimated 'needed' boxes of every diameter, the
+    'low' and 'high' ends of their 95% confidence intervals, and the fractal
+    'dimension' fitted to them, with its bootstrap interval
+    ('dimension_low', 'dimension_high').
+    '''
+
+    formula, clause_num = _formula(file_name)
+
+    if mode == 'vig':
+        return featsat.estimate_box_covering_vig(formula, clause_num, samples, seed, budget)
+
+    if mode == 'cvig':
+        return featsat.estimate_box_covering_cvig(formula, clause_num, samples, seed, budget)
+
+    raise ValueError(f'Argument mode={mode} not valid. Choose "vig" or "cvig"')
+
+
+def features(file_name, features='all'):
+    '''
+    Computes the features of a CNF formula (a file or in memory) reading it
+    once. features are named as in sia-feat -f: 'base' counts the syntactic
+    features while the graphs are built, as 'vars', 'clauses', 'ratio',
+    clause sizes ('size_mean', 'unit', 'binary', ...), the fractions of
+    'horn' and 'dual_horn' clauses and of 'positive' literals, the balance
+    of the signs of every clause and variable, and the occurrences of the
+    variables ('degree_mean', ...). Returns a dict with them and the graph
+    features selected ('modularity', 'alpha_var', 'dim', ...).
+    '''
+
+    formula, clause_num = _formula(file_name)
+    return featsat.features(formula, clause_num, features)
+
+
+def progressive(file_name, features='mod-vig,alpha-var,dim-vig', mode='reservoir', first=10000,
+                growth=2.0, limit=None, tol=0.01, seed=0):
+    '''
+    Estimates features of a CNF formula (a file or in memory) on growing
+    samples of its clauses, for a fast triage of large instances. features
+    are named as in sia-feat -f. The sample, of at most limit clauses, is
+    read in one pass: a 'prefix' of the formula, a 'uniform' random sample
+    or a 'reservoir' sample. Features are computed on its first clauses,
+    growing them by growth until no estimate changes more than tol
+    (relatively) from one step to the next.
+
+    Returns a dict with an array per feature ('modularity', 'alpha_var',
+    'dim', ...) and the convergence trace: 'clauses', 'vars', 'change' and
+    'secs' of every step, the 'total' clauses of the formula and whether
+    the estimates 'converged'.
+    '''
+
+    formula, clause_num = _formula(file_name)
+    return featsat.progressive(formula, clause_num, features, mode, first, growth,
+                               limit or 0, tol, seed)
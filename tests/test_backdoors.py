@@ -2,10 +2,13 @@
 sia.backdoors module testing script for pytest
 '''
 
+import itertools as it
 from pathlib import Path
 
 import pytest
 
+import sia
+from sia import cnf
 from sia.backdoors import SynClass
 
 
@@ -26,3 +29,39 @@ def test_cnfbaseclass_is_dual_horn():
     k_sat = [[-1, 2, 3], [2], [-4, 5], [-2], [3, 4]]
     assert SynClass.is_k_sat(k_sat, 3) == True
     assert SynClass.is_k_sat(k_sat, 2) == False
+
+
+def test_renameable_horn():
+    '''Flipping the renamed variables makes a formula Horn'''
+    formula = [[1, 2, -3], [-1, 2], [3, 4], [-2, -4]]
+    renamed = sia.backdoors.horn_renaming(formula)
+    flipped = [[-l if abs(l) in renamed else l for l in c] for c in formula]
+    assert SynClass.is_horn(flipped)
+    assert SynClass.is_renameable_horn(formula)
+    # Two of 1, 2, 3 renamed for the first clause, and two kept for the second
+    assert not SynClass.is_renameable_horn([[1, 2, 3], [-1, -2, -3]])
+
+
+def test_strong_backdoor():
+    '''Every assignment of a strong backdoor leaves the class'''
+    formula = [[1, 2, 3], [-1, 4, 5], [2, -4], [3, 5, 6, -7]]
+    horn = sia.backdoors.strong_backdoor(formula, 'horn')
+    assert len(horn) == 3
+    for signs in it.product([1, -1], repeat=len(horn)):
+        reduced = cnf.propagate(formula, [s * x for s, x in zip(signs, horn)])
+        assert SynClass.is_horn(reduced)
+    assert len(sia.backdoors.strong_backdoor(formula, '2cnf')) == 2
+    assert sia.backdoors.strong_backdoor(formula, 'horn', max_size=2) is None
+    assert sia.backdoors.strong_backdoor([[-1, 2], [-2]], 'horn') == []
+    with pytest.raises(ValueError):
+        sia.backdoors.strong_backdoor(formula, 'affine')
+
+
+def test_weak_backdoor():
+    '''A weak backdoor leaves a satisfiable formula of the class'''
+    formula = [[1, 2, 3], [1, 4, 5], [-1, 2], [-2, -3], [4, 5, 6]]
+    tau = sia.backdoors.weak_backdoor(formula, 'horn')
+    assert len(tau) == 2
+    reduced = cnf.propagate(formula, tau)
+    assert SynClass.is_horn(reduced) and [] not in reduced
+    assert sia.backdoors.weak_backdoor([[1], [-1]], 'horn') is None
@@ -0,0 +1,486 @@
+'''
+sia.feat module testing script for pytest
+'''
+
+import random
+import signal
+from array import array
+from pathlib import Path
+
+import pytest
+
+import sia
+
+
+TEST_DIR = Path('tests/data')
+
+
+def test_modularity_graph():
+    '''Modularity of the small graph formula'''
+    q = sia.feat.modularity(TEST_DIR / 'graph.cnf')
+    assert q == pytest.approx(0.3163265306122447)
+
+
+def test_communities_graph():
+    '''Partition, dendrogram and communities are consistent'''
+    ans = sia.feat.communities(TEST_DIR / 'graph.cnf')
+    partition = memoryview(ans['partition']).tolist()
+    assert len(partition) == 9
+    assert ans['modularity'] == pytest.approx(0.3163265306122447)
+    assert memoryview(ans['dendrogram'][-1]).tolist() == partition
+    assert sum(memoryview(ans['sizes']).tolist()) == 9
+    offsets = memoryview(ans['offsets']).tolist()
+    members = memoryview(ans['members']).tolist()
+    assert len(offsets) == ans['ncomm'] + 1
+    assert sorted(members) == list(range(1, 10))
+
+
+def test_communities_warm_start():
+    '''Continuing from a previous partition keeps its modularity'''
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_clauses(clauses, n=n)
+    first = graph.communities()
+    again = graph.communities(partition=first['partition'])
+    assert again['modularity'] >= first['modularity'] - 1e-9
+    # Same formula with variables renamed in reverse order
+    renamed = [[(n + 1 - abs(l)) * (1 if l > 0 else -1) for l in c] for c in clauses]
+    mapping = list(range(n - 1, -1, -1))
+    ans = sia.Graph.from_clauses(renamed, n=n).communities(
+        partition=first['partition'], mapping=mapping)
+    assert ans['modularity'] >= first['modularity'] - 1e-9
+    with pytest.raises(ValueError):
+        graph.modularity(partition=first['partition'], mapping=[0])
+
+
+def test_formula_in_memory(tmp_path):
+    '''Formulas in memory give the same features as their files'''
+    file = TEST_DIR / 'graph.cnf'
+    _, _, _, clauses = sia.io.from_file(file)
+    literals = array('i', [lit for clause in clauses for lit in clause])
+    offsets = array('q', [0])
+    for clause in clauses:
+        offsets.append(offsets[-1] + len(clause))
+    formulas = [clauses, (literals, offsets), (array('q', literals), array('i', offsets)),
+                file.read_bytes()]
+    for mode in ['vig', 'cvig']:
+        q = sia.feat.modularity(file, mode)
+        dim = sia.feat.self_similar(file, mode)
+        for formula in formulas:
+            assert sia.feat.modularity(formula, mode) == pytest.approx(q)
+            assert sia.feat.self_similar(formula, mode) == pytest.approx(dim)
+    rng = random.Random(1)
+    clauses = [[v * rng.choice([1, -1]) for v in rng.sample(range(1, 101), rng.randint(2, 6))]
+               for _ in range(502)]
+    file = tmp_path / 'random.cnf'
+    file.write_text('p cnf 100 502\n' + ''.join(' '.join(map(str, c)) + ' 0\n' for c in clauses))
+    for mode in ['var', 'clause']:
+        alpha = sia.feat.scale_free(file, mode)
+        assert sia.feat.scale_free(clauses, mode) == alpha
+        assert sia.feat.scale_free(file.read_bytes(), mode) == alpha
+    # Two clauses in a tuple, not (literals, offsets)
+    assert sia.feat.self_similar(((1, 2), (2, 3))) == sia.feat.self_similar([[1, 2], [2, 3]])
+    assert sia.feat.self_similar(((1, 2), (2, 3))) == pytest.approx(1.5849625007211563)
+    with pytest.raises(ValueError):
+        sia.feat.modularity([[1, 0]])
+    with pytest.raises(ValueError):
+        sia.feat.modularity((literals, array('q', [0, 100])))
+    with pytest.raises(ValueError):
+        sia.feat.modularity(b'1 2 0\n')
+    for mode in ['vig', 'cvig']:
+        with pytest.raises(ValueError, match='variable number 9'):
+            sia.feat.modularity(b'p cnf 3 2\n1 -2 0\n2 9 0\n', mode)
+    with pytest.raises(ValueError):
+        sia.feat.scale_free(b'p cnf 3 2\n1 -2 0\n2 9 0\n', 'var')
+
+
+def test_ensemble():
+    '''Seeded runs are reproducible and summarized consistently'''
+    rng = random.Random(1)
+    clauses = [[v * rng.choice([1, -1]) for v in rng.sample(range(1, 301), 3)]
+               for _ in range(1200)]
+    graph = sia.Graph.from_clauses(clauses)
+    ans = graph.ensemble(runs=6, seed=7, consensus=True)
+    runs = memoryview(ans['runs']).tolist()
+    assert len(runs) == 6
+    assert ans['best'] == max(runs)
+    assert min(runs) <= ans['mean'] <= max(runs)
+    assert ans['std'] > 0
+    assert len(memoryview(ans['consensus'])) == len(graph)
+    assert ans['consensus_modularity'] > 0
+    assert memoryview(graph.ensemble(runs=6, seed=7)['runs']).tolist() == runs
+    assert graph.ensemble(runs=2, seed=7)['consensus'] is None
+    ans = sia.feat.ensemble(TEST_DIR / 'graph.cnf', runs=3)
+    assert ans['best'] == pytest.approx(0.3163265306122447)
+    with pytest.raises(ValueError):
+        graph.ensemble(runs=0)
+
+
+def test_leiden():
+    '''Leiden finds communities at least as good as Louvain'''
+    q = sia.feat.modularity(TEST_DIR / 'graph.cnf', method='leiden')
+    assert q == pytest.approx(0.3163265306122447)
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_clauses(clauses, n=n)
+    ans = graph.communities(method='leiden')
+    assert ans['modularity'] >= graph.modularity() - 1e-9
+    assert memoryview(ans['dendrogram'][-1]).tolist() == memoryview(ans['partition']).tolist()
+    assert sorted(memoryview(ans['members']).tolist()) == list(range(1, n + 1))
+    again = graph.modularity(partition=ans['partition'], method='leiden')
+    assert again >= ans['modularity'] - 1e-9
+    with pytest.raises(ValueError):
+        graph.modularity(method='foo')
+
+
+def test_louvain_queue():
+    '''Queue-driven moving evaluates fewer nodes than full sweeps'''
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_clauses(clauses, n=n)
+    full = graph.communities()
+    queue = graph.communities(method='louvain-queue')
+    evaluated = memoryview(queue['evaluated']).tolist()
+    moved = memoryview(queue['moved']).tolist()
+    assert evaluated[0] == n and len(evaluated) == len(moved)
+    assert all(m <= e for e, m in zip(evaluated, moved))
+    assert sum(evaluated) <= sum(memoryview(full['evaluated']).tolist())
+    assert queue['modularity'] == pytest.approx(full['modularity'], abs=0.02)
+    assert sorted(memoryview(queue['members']).tolist()) == list(range(1, n + 1))
+
+
+def test_reorder():
+    '''Reordered graphs give the same features, in the original node ids'''
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_clauses(clauses, n=n, kind='cvig')
+    assert graph.permutation is None
+    ans = graph.communities()
+    part = memoryview(ans['partition']).tolist()
+    for order in ['rcm', 'degree', 'community']:
+        other = graph.reorder(order)
+        perm = memoryview(other.permutation).tolist()
+        assert sorted(perm[:n]) == list(range(n))
+        assert sorted(perm) == list(range(len(graph)))
+        assert other.components() == graph.components()
+        assert memoryview(other.box_covering()).tolist() == memoryview(graph.box_covering()).tolist()
+        assert other.modularity() == pytest.approx(ans['modularity'], abs=1e-6)
+    other = graph.reorder('community', partition=ans['partition'])
+    perm = memoryview(other.permutation).tolist()
+    comms = [part[x] for x in sorted(range(n), key=lambda x: perm[x])]
+    assert sum(a != b for a, b in zip(comms, comms[1:])) == ans['ncomm'] - 1
+    again = other.reorder('rcm').communities(partition=ans['partition'])
+    assert again['modularity'] == pytest.approx(ans['modularity'], abs=1e-6)
+    same = {}
+    for c, d in zip(memoryview(again['partition']).tolist(), part):
+        same.setdefault(c, d)
+    agree = sum(same[c] == d for c, d in zip(memoryview(again['partition']).tolist(), part))
+    assert agree > 0.95 * len(part)
+    with pytest.raises(ValueError):
+        graph.reorder('foo')
+
+
+def test_proxy_clauses(tmp_path):
+    '''Long clauses as proxy nodes keep their weight in the VIG'''
+    rng = random.Random(1)
+    clauses = [[v * rng.choice([1, -1]) for v in rng.sample(range(1, 601), 3)]
+               for _ in range(2000)]
+    clauses += [list(range(1, 451)), list(range(200, 651))]
+    file = tmp_path / 'long.cnf'
+    file.write_text('p cnf 650 2002\n' + ''.join(' '.join(map(str, c)) + ' 0\n' for c in clauses))
+    clique = sia.Graph.from_clauses(clauses, max_clauses=1000)
+    dropped = sia.Graph.from_clauses(clauses)
+    proxy = sia.Graph.from_clauses(clauses, proxy=True)
+    assert len(proxy) == len(clique) + 2
+    assert proxy.degree_stats()['edges'] == dropped.degree_stats()['edges'] + 450 + 451
+    arity = lambda g: g.degree_stats()['mean_arity'] * len(g)
+    assert arity(proxy) == pytest.approx(arity(clique))
+    assert arity(dropped) < arity(clique) - 1
+    q = clique.modularity()
+    assert abs(proxy.modularity() - q) < abs(dropped.modularity() - q)
+    same = sia.Graph.from_file(str(file), proxy=True)
+    assert same.degree_stats()['edges'] == proxy.degree_stats()['edges']
+    assert arity(same) == pytest.approx(arity(proxy))
+    with pytest.raises(ValueError):
+        sia.Graph.from_clauses(clauses, dynamic=True, proxy=True)
+
+
+def test_hypergraph_modularity():
+    '''Louvain on the clause hypergraph optimizes the VIG modularity'''
+    file = TEST_DIR / 'graph.cnf'
+    assert sia.feat.modularity(file, 'hypergraph') == pytest.approx(0.3163265306122447)
+    file = TEST_DIR / 'php_50_51.cnf'
+    assert sia.feat.modularity(file, 'hypergraph') == pytest.approx(sia.feat.modularity(file), abs=1e-3)
+    rng = random.Random(2)
+    clauses = [rng.sample(range(1, 301), 3) for _ in range(1000)]
+    clauses += [rng.sample(range(1, 301), 40) for _ in range(10)]
+    q = sia.feat.modularity(clauses, 'hypergraph')
+    assert q == pytest.approx(sia.feat.modularity(clauses), abs=0.02)
+    with pytest.raises(ValueError):
+        sia.feat.modularity(clauses, 'clauses')
+    with pytest.raises(ValueError, match='variable number 9'):
+        sia.feat.modularity(b'p cnf 3 2\n1 -2 0\n2 9 0\n', 'hypergraph')
+
+
+def test_budget():
+    '''Exhausted budgets return the results found so far'''
+    rng = random.Random(3)
+    clauses = [rng.sample(range(1, 3001), 3) for _ in range(12000)]
+    full = sia.feat.communities(clauses)
+    assert not full['truncated']
+    cancelled = sia.Budget()
+    cancelled.cancel()
+    for budget in (sia.Budget(timeout=0), cancelled):
+        ans = sia.feat.communities(clauses, budget=budget)
+        assert budget.truncated and ans['truncated']
+        assert len(ans['partition']) == 3000
+        assert ans['modularity'] < full['modularity']
+        assert memoryview(sia.feat.box_covering(clauses, budget=budget)).tolist() == [3000, 3000]
+    budget = sia.Budget(timeout=60)
+    graph = sia.Graph.from_clauses(clauses)
+    assert graph.modularity(budget=budget) == pytest.approx(full['modularity'], abs=0.02)
+    assert not budget.truncated and not budget.cancelled
+    with pytest.raises(TypeError):
+        graph.box_covering(budget=1)
+
+
+def test_interrupt():
+    '''Signal handlers run while kernels compute, and may stop them'''
+    rng = random.Random(4)
+    graph = sia.Graph.from_clauses([rng.sample(range(1, 20001), 3) for _ in range(80000)])
+    budget = sia.Budget()
+    def interrupt(signum, frame):
+        raise KeyboardInterrupt
+    old = signal.signal(signal.SIGALRM, interrupt)
+    try:
+        signal.setitimer(signal.ITIMER_REAL, 0.01)
+        with pytest.raises(KeyboardInterrupt):
+            graph.ensemble(runs=100, budget=budget)
+        assert not budget.truncated
+        signal.signal(signal.SIGALRM, lambda signum, frame: budget.cancel())
+        signal.setitimer(signal.ITIMER_REAL, 0.01)
+        ans = graph.ensemble(runs=100, budget=budget)
+        assert ans['truncated'] and budget.cancelled
+    finally:
+        signal.setitimer(signal.ITIMER_REAL, 0)
+        signal.signal(signal.SIGALRM, old)
+
+
+def test_progressive(tmp_path):
+    '''Estimates on growing samples end with the features of the formula'''
+    rng = random.Random(6)
+    clauses = []
+    for _ in range(6000):
+        base = rng.randrange(20) * 50
+        clauses.append([base + v for v in rng.sample(range(1, 51), 3)])
+    file = tmp_path / 'comm.cnf'
+    file.write_text('p cnf 1000 6000\n' + ''.join(' '.join(map(str, c)) + ' 0\n' for c in clauses))
+    for mode in ('prefix', 'uniform', 'reservoir'):
+        ans = sia.feat.progressive(file, 'mod-vig,alpha-var', mode, first=500, tol=0)
+        assert memoryview(ans['clauses']).tolist() == [500, 1000, 2000, 4000, 6000]
+        assert not ans['converged'] and ans['total'] == 6000
+        assert memoryview(ans['vars']).tolist()[-1] == 1000
+        assert 'dim' not in ans and len(ans['secs']) == 5
+        assert memoryview(ans['alpha_var'])[-1] == pytest.approx(sia.feat.scale_free(file))
+        assert memoryview(ans['modularity'])[-1] == pytest.approx(sia.feat.modularity(file), abs=0.02)
+    ans = sia.feat.progressive(file, 'mod-vig', first=500, tol=0.05)
+    assert ans['converged'] and memoryview(ans['change'])[-1] <= 0.05
+    ans = sia.feat.progressive(clauses, 'mod-vig', 'prefix', first=100, limit=300, tol=0)
+    assert memoryview(ans['clauses']).tolist() == [100, 200, 300]
+    # Variables beyond the header, the smaller ones after the greater
+    ans = sia.feat.progressive(b'p cnf 3 3\n1 10 0\n5 2 0\n10 3 0\n', 'mod-vig', 'prefix', first=3)
+    assert memoryview(ans['vars']).tolist() == [5]
+    assert memoryview(ans['modularity'])[-1] == pytest.approx(4 / 9)
+    with pytest.raises(ValueError):
+        sia.feat.progressive(file, 'mod-vig', 'stratified')
+
+
+def test_features():
+    '''Base features counted in the pass building the graphs'''
+    rng = random.Random(7)
+    clauses = [[rng.choice((-1, 1)) * rng.randint(1, 40) for _ in range(rng.randint(1, 5))]
+               for _ in range(300)]
+    ans = sia.feat.features(clauses, 'base,mod-vig,alpha-var')
+    sizes = [len(c) for c in clauses]
+    lits = [x for c in clauses for x in c]
+    assert ans['vars'] == max(abs(x) for x in lits) and ans['clauses'] == 300
+    assert ans['size_min'] == min(sizes) and ans['size_max'] == max(sizes)
+    assert ans['size_mean'] == pytest.approx(sum(sizes) / 300)
+    assert ans['unit'] == pytest.approx(sizes.count(1) / 300)
+    assert ans['binary'] == pytest.approx(sizes.count(2) / 300)
+    assert ans['horn'] == pytest.approx(sum(sum(x > 0 for x in c) <= 1 for c in clauses) / 300)
+    assert ans['dual_horn'] == pytest.approx(sum(sum(x < 0 for x in c) <= 1 for c in clauses) / 300)
+    assert ans['positive'] == pytest.approx(sum(x > 0 for x in lits) / len(lits))
+    assert ans['degree_mean'] == pytest.approx(len(lits) / ans['vars'])
+    assert ans['alpha_var'] == pytest.approx(sia.feat.scale_free(clauses))
+    assert 'communities' in ans and 'dim' not in ans and not ans['truncated']
+
+    file = TEST_DIR / 'graph.cnf'
+    ans = sia.feat.features(file)
+    assert ans['modularity'] == pytest.approx(sia.feat.modularity(file))
+    assert ans['dim'] == pytest.approx(sia.feat.self_similar(file))
+    assert (ans['vars'], ans['clauses'], ans['positive']) == (9, 7, 1)
+    with pytest.raises(ValueError):
+        sia.feat.features(file, 'base,syntax')
+
+
+def test_box_covering_graph():
+    '''First box covering needs a box per node'''
+    needed = memoryview(sia.feat.box_covering(TEST_DIR / 'graph.cnf'))
+    assert needed.format == 'q'
+    assert needed[0] == 9
+    assert needed[1] == 9
+
+
+def test_box_covering_bitset():
+    '''Dense small graphs, covered with bit vectors, get the tiles of the DFS'''
+    rng = random.Random(4)
+    clauses = [rng.sample(range(1, 301), 3) for _ in range(1500)]
+    graph = sia.Graph.from_clauses(clauses, n=300)
+    assert memoryview(graph.box_covering()).tolist() == [300, 300, 29, 2, 1]
+    assert memoryview(sia.feat.box_covering(clauses)).tolist() == [300, 300, 29, 2, 1]
+
+
+def test_estimate_box_covering():
+    '''Box covering estimated from random centers, with confidence intervals'''
+    n = 30
+    grid = [[i * n + j + 1, -(i * n + j + 2)] for i in range(n) for j in range(n - 1)]
+    grid += [[i * n + j + 1, -(i * n + j + n + 1)] for i in range(n - 1) for j in range(n)]
+    ans = sia.feat.estimate_box_covering(grid, samples=100, seed=3)
+    needed = memoryview(ans['needed']).tolist()
+    low = memoryview(ans['low']).tolist()
+    high = memoryview(ans['high']).tolist()
+    assert needed[:2] == [n * n, n * n] and len(needed) == 16
+    assert all(l <= x <= h for l, x, h in zip(low, needed, high))
+    assert ans['samples'] == 100 and not ans['truncated']
+    assert ans['dimension_low'] <= ans['dimension'] <= ans['dimension_high']
+    assert 1.5 < ans['dimension'] < 2.5
+    graph = sia.Graph.from_clauses(grid)
+    assert graph.estimate_box_covering(samples=100, seed=3)['dimension'] == ans['dimension']
+    # A clique is covered by one box of diameter 2, and the curve ends there
+    clique = [[a, b] for a in range(1, 9) for b in range(a + 1, 9)]
+    ans = sia.feat.estimate_box_covering(clique, samples=10)
+    assert memoryview(ans['needed']).tolist() == [8, 8, 1]
+    with pytest.raises(ValueError):
+        sia.feat.estimate_box_covering(grid, samples=0)
+
+
+def test_implicit_cvig():
+    '''The CVIG kept as an incidence relation gives the same features'''
+    file = TEST_DIR / 'php_50_51.cnf'
+    graph = sia.Graph.from_file(str(file), kind='cvig')
+    needed = memoryview(sia.feat.box_covering(file, 'cvig')).tolist()
+    assert needed == memoryview(graph.box_covering()).tolist()
+    ans = sia.feat.communities(file, 'cvig')
+    assert ans['modularity'] == pytest.approx(graph.modularity(), abs=1e-6)
+    assert sorted(memoryview(ans['members']).tolist()) == list(range(1, len(graph) + 1))
+
+
+def test_graph_out_of_core(tmp_path):
+    '''A VIG built out of core, in many runs, is the same graph'''
+    file = str(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_file(file)
+    spilled = sia.Graph.from_file(file, memory=4096, scratch=str(tmp_path))
+    assert len(spilled) == len(graph)
+    assert spilled.degree_stats() == graph.degree_stats()
+    assert spilled.modularity() == pytest.approx(graph.modularity(), abs=1e-9)
+    assert memoryview(spilled.box_covering()).tolist() == memoryview(graph.box_covering()).tolist()
+    # Scratch files are unlinked as soon as they are created
+    assert list(tmp_path.iterdir()) == []
+    with pytest.raises(ValueError):
+        sia.Graph.from_file(file, memory=-1)
+    with pytest.raises(OSError):
+        sia.Graph.from_file(file, memory=4096, scratch=str(tmp_path / 'missing'))
+    with pytest.raises(OSError):
+        sia.Graph.from_file(file, memory=4096, scratch=file)
+
+
+def test_graph_compressed(tmp_path):
+    '''A VIG kept in compressed rows is the same graph, also built out of core'''
+    file = str(TEST_DIR / 'php_50_51.cnf')
+    graph = sia.Graph.from_file(file)
+    compressed = sia.Graph.from_file(file, compressed=True)
+    assert len(compressed) == len(graph)
+    assert compressed.degree_stats() == graph.degree_stats()
+    assert compressed.components() == graph.components()
+    assert compressed.modularity() == pytest.approx(graph.modularity(), abs=1e-9)
+    assert compressed.self_similarity() == pytest.approx(graph.self_similarity())
+    assert memoryview(compressed.box_covering()).tolist() == memoryview(graph.box_covering()).tolist()
+    spilled = sia.Graph.from_file(file, compressed=True, memory=4096, scratch=str(tmp_path))
+    assert spilled.degree_stats() == graph.degree_stats()
+    assert spilled.modularity() == pytest.approx(graph.modularity(), abs=1e-9)
+
+
+def test_graph_from_file():
+    '''A graph built once computes several features'''
+    graph = sia.Graph.from_file(str(TEST_DIR / 'graph.cnf'), kind='vig')
+    assert len(graph) == 9
+    assert graph.kind == 'vig'
+    assert graph.modularity() == pytest.approx(0.3163265306122447)
+    assert graph.components() == 1
+    assert graph.self_similarity() == pytest.approx(
+        sia.feat.self_similar(TEST_DIR / 'graph.cnf'))
+
+
+def test_graph_from_clauses():
+    '''Graphs from clauses in memory match the ones read from file'''
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'graph.cnf')
+    for kind in ('vig', 'cvig'):
+        graph = sia.Graph.from_clauses(clauses, kind=kind, n=n)
+        ref = sia.Graph.from_file(str(TEST_DIR / 'graph.cnf'), kind=kind)
+        assert len(graph) == len(ref)
+        assert graph.degree_stats() == ref.degree_stats()
+        assert graph.modularity() == pytest.approx(ref.modularity())
+
+
+def test_graph_repeated_edges():
+    '''Weights of repeated VIG edges are summed'''
+    once = sia.Graph.from_clauses([[1, 2], [2, 3], [3, 4], [4, 1]])
+    twice = sia.Graph.from_clauses([[1, 2], [2, 1], [2, 3], [3, 2],
+                                    [3, 4], [4, 3], [4, 1], [1, 4]])
+    assert once.degree_stats()['edges'] == twice.degree_stats()['edges']
+    assert once.modularity() == pytest.approx(twice.modularity())
+    assert memoryview(twice.communities()['partition']).format == 'I'
+
+
+def test_graph_dynamic():
+    '''Clauses added and then removed leave the graph and modularity unchanged'''
+    _, n, _, clauses = sia.io.from_file(TEST_DIR / 'php_50_51.cnf')
+    half = len(clauses) // 2
+    for kind in ['vig', 'cvig']:
+        graph = sia.Graph.from_clauses(clauses[:half], n=n, kind=kind, dynamic=True)
+        static = sia.Graph.from_clauses(clauses[:half], n=n, kind=kind)
+        assert graph.incremental_modularity() == pytest.approx(static.modularity())
+        edges = graph.degree_stats()['edges']
+        first = graph.add_clauses(clauses[half:])
+        assert first == half
+        assert graph.degree_stats()['edges'] == sia.Graph.from_clauses(clauses, n=n, kind=kind).degree_stats()['edges']
+        moved = graph.incremental_modularity(refine=False)
+        assert graph.incremental_modularity() >= moved - 1e-12
+        q = graph.incremental_modularity(refine=False)
+        graph.add_clauses([[1, -2], [3, 4, 5]])
+        graph.remove_clauses([len(clauses), len(clauses) + 1])
+        assert graph.incremental_modularity(refine=False) == pytest.approx(q)
+        graph.remove_clauses(range(half, len(clauses)))
+        assert graph.degree_stats()['edges'] == edges
+        with pytest.raises(ValueError):
+            graph.remove_clauses([len(clauses)])
+        with pytest.raises(ValueError):
+            graph.add_clauses([[n + 1]])
+    with pytest.raises(TypeError):
+        static.add_clauses([[1, 2]])
+    for kind in ['vig', 'cvig']:
+        empty = sia.Graph.from_clauses([], kind=kind, dynamic=True)
+        assert empty.incremental_modularity() == 0
+        assert empty.incremental_modularity(refine=False) == 0
+
+
+def test_graph_wrong_kind():
+    '''Only VIG and CVIG representations are available'''
+    with pytest.raises(ValueError):
+        sia.Graph.from_clauses([[1, 2]], kind='foo')
+
+
+def test_graph_large_header(tmp_path):
+    '''Clause counts over 2^31 in the header are read as such'''
+    cnf = tmp_path / 'large.cnf'
+    cnf.write_text('p cnf 3 5000000000\n1 2 0\n2 3 0\n')
+    graph = sia.Graph.from_file(str(cnf))
+    assert len(graph) == 3
+    assert graph.degree_stats()['edges'] == 2
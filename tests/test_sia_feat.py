@@ -0,0 +1,91 @@
+'''
+sia-feat command line tool testing script for pytest
+'''
+
+import json
+import shutil
+import subprocess
+from pathlib import Path
+
+import pytest
+
+
+TEST_DIR = Path('tests/data')
+INSTANCES = sorted(str(p) for p in TEST_DIR.rglob('*') if p.suffix in ('.cnf', '.dimacs'))
+
+
+@pytest.fixture(scope='module')
+def sia_feat(tmp_path_factory):
+    '''The command line tool, built in a temporary directory'''
+    if shutil.which('make') is None or shutil.which('g++') is None:
+        pytest.skip('make and g++ are needed to build sia-feat')
+    tool = tmp_path_factory.mktemp('bin') / 'sia-feat'
+    subprocess.run(['make', '-s', f'NATIVE_TOOL={tool}', str(tool)], check=True)
+    return tool
+
+
+def run(tool, *args):
+    '''Runs the tool on the given arguments, capturing its output'''
+    return subprocess.run([str(tool), *map(str, args)], capture_output=True, text=True,
+                          check=False)
+
+
+def rows(file):
+    '''Instances and values of the rows of a CSV output file'''
+    lines = file.read_text().splitlines()
+    return {line.split(',')[0]: line.split(',')[1:] for line in lines[1:]}
+
+
+def test_resume(sia_feat, tmp_path):
+    '''Resuming computes the instances missing, truncated or cut'''
+    out = tmp_path / 'features.csv'
+    ans = run(sia_feat, '-f', 'base,mod-vig', '-o', out, TEST_DIR)
+    assert ans.returncode == 0
+    first = rows(out)
+    columns = out.read_text().splitlines()[0].count(',')
+    assert sorted(first) == INSTANCES
+    assert all(len(values) == columns for values in first.values())
+
+    ans = run(sia_feat, '-v', '-r', '-f', 'base,mod-vig', '-o', out, TEST_DIR)
+    assert ans.returncode == 0
+    assert f'0 instances pending, {len(INSTANCES)} done' in ans.stderr
+
+    # A row cut after the graph columns, another marked as truncated, and
+    # the last one cut before its newline
+    lines = out.read_text().splitlines()
+    lines[1] = ','.join(lines[1].split(',')[:17])
+    lines[2] = lines[2][:-1] + '1'
+    out.write_text('\n'.join(lines)[:-10])
+    ans = run(sia_feat, '-v', '-r', '-f', 'base,mod-vig', '-o', out, TEST_DIR)
+    assert ans.returncode == 0
+    assert f'3 instances pending, {len(INSTANCES) - 3} done' in ans.stderr
+    resumed = rows(out)
+    assert sorted(resumed) == INSTANCES
+    assert all(len(values) == columns for values in resumed.values())
+    ans = run(sia_feat, '-v', '-r', '-f', 'base,mod-vig', '-o', out, TEST_DIR)
+    assert f'0 instances pending, {len(INSTANCES)} done' in ans.stderr
+
+
+def test_failed(sia_feat, tmp_path):
+    '''Malformed instances are reported and the others computed'''
+    shutil.copy(TEST_DIR / 'graph.cnf', tmp_path)
+    (tmp_path / 'bad.cnf').write_text('p cnf 3 2\n1 -2 0\n2 9 0\n')
+    out = tmp_path / 'features.csv'
+    ans = run(sia_feat, '-j', 2, '-o', out, tmp_path / 'bad.cnf', tmp_path / 'graph.cnf')
+    assert ans.returncode == 2
+    assert 'bad.cnf: Unvalid variable number 9' in ans.stderr
+    assert list(rows(out)) == [str(tmp_path / 'graph.cnf')]
+
+
+def test_json(sia_feat):
+    '''JSON lines are valid JSON, with null for the features not finite'''
+    ans = run(sia_feat, '-F', 'json', '-f', 'base,dim-vig', TEST_DIR)
+    assert ans.returncode == 0
+
+    def constant(name):
+        raise ValueError(name)
+
+    lines = [json.loads(line, parse_constant=constant) for line in ans.stdout.splitlines()]
+    assert sorted(line['instance'] for line in lines) == INSTANCES
+    empty = next(line for line in lines if line['instance'].endswith('empty_formula.cnf'))
+    assert empty['dim'] is None and empty['truncated'] is False